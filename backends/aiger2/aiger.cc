@@ -1317,7 +1317,7 @@ struct Aiger2Backend : Backend {
 		ct.setup_internals_eval();
 		log("    ");
 		int col = 0;
-		for (auto pair : ct.cell_types)
+		for (auto pair : ct.all_types())
 		if (!supported.count(pair.first)) {
 			if (col + pair.first.size() + 2 > 72) {
 				log("\n    ");
@@ -1334,7 +1334,7 @@ struct Aiger2Backend : Backend {
 		ct2.setup_stdcells();
 		log("    ");
 		col = 0;
-		for (auto pair : ct2.cell_types)
+		for (auto pair : ct2.all_types())
 		if (!supported.count(pair.first)) {
 			if (col + pair.first.size() + 2 > 72) {
 				log("\n    ");
@@ -246,14 +246,22 @@ struct FunctionalCxxBackend : public Backend
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
+		log("    write_functional_cxx [options] [filename]\n");
+		log("\n");
 		log("TODO: add help message\n");
 		log("\n");
+		log("    -stats\n");
+		log("        print the size of the functional IR and the time and memory used to\n");
+		log("        build it.\n");
+		log("\n");
     }
 
-	void printCxx(std::ostream &stream, std::string, Module *module)
+	void printCxx(std::ostream &stream, std::string, Module *module, bool stats)
 	{
 		CxxWriter f(stream);
 		CxxModule mod(module);
+		if (stats)
+			mod.ir.log_stats();
 		mod.write_header(f);
 		mod.write_struct_def(f);
 		mod.write_eval_def(f);
@@ -262,14 +270,24 @@ struct FunctionalCxxBackend : public Backend
 
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		bool stats = false;
+
         log_header(design, "Executing Functional C++ backend.\n");
 
-		size_t argidx = 1;
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-stats") {
+				stats = true;
+				continue;
+			}
+			break;
+		}
 		extra_args(f, filename, args, argidx, design);
 
 		for (auto module : design->selected_modules()) {
             log("Dumping module `%s'.\n", module->name.c_str());
-			printCxx(*f, filename, module);
+			printCxx(*f, filename, module, stats);
 		}
 	}
 } FunctionalCxxBackend;
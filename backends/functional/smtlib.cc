@@ -275,18 +275,42 @@ struct SmtModule {
 struct FunctionalSmtBackend : public Backend {
 	FunctionalSmtBackend() : Backend("functional_smt2", "Generate SMT-LIB from Functional IR") {}
 
-	void help() override { log("\nFunctional SMT Backend.\n\n"); }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_functional_smt2 [options] [filename]\n");
+		log("\n");
+		log("Functional SMT Backend.\n");
+		log("\n");
+		log("    -stats\n");
+		log("        print the size of the functional IR and the time and memory used to\n");
+		log("        build it.\n");
+		log("\n");
+	}
 
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		bool stats = false;
+
 		log_header(design, "Executing Functional SMT Backend.\n");
 
-		size_t argidx = 1;
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-stats") {
+				stats = true;
+				continue;
+			}
+			break;
+		}
 		extra_args(f, filename, args, argidx, design);
 
 		for (auto module : design->selected_modules()) {
 			log("Processing module `%s`.\n", module->name.c_str());
 			SmtModule smt(module);
+			if (stats)
+				smt.ir.log_stats();
 			smt.write(*f);
 		}
 	}
@@ -283,11 +283,16 @@ struct FunctionalSmtrBackend : public Backend {
 		log("    -provides\n");
 		log("        include 'provide' statement(s) for loading output as a module\n");
 		log("\n");
+		log("    -stats\n");
+		log("        print the size of the functional IR and the time and memory used to\n");
+		log("        build it.\n");
+		log("\n");
 	}
 
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		auto provides = false;
+		auto stats = false;
 
 		log_header(design, "Executing Functional Rosette Backend.\n");
 
@@ -296,6 +301,8 @@ struct FunctionalSmtrBackend : public Backend {
 		{
 			if (args[argidx] == "-provides")
 				provides = true;
+			else if (args[argidx] == "-stats")
+				stats = true;
 			else
 				break;
 		}
@@ -309,6 +316,8 @@ struct FunctionalSmtrBackend : public Backend {
 		for (auto module : design->selected_modules()) {
 			log("Processing module `%s`.\n", module->name.c_str());
 			SmtrModule smtr(module);
+			if (stats)
+				smtr.ir.log_stats();
 			smtr.write(*f);
 		}
 	}
@@ -38,6 +38,7 @@
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
+#include "kernel/io.h"
 #include "aigerparse.h"
 
 YOSYS_NAMESPACE_BEGIN
@@ -257,6 +258,7 @@ end_of_header:
 
 	log_debug("M=%u I=%u L=%u O=%u A=%u B=%u C=%u J=%u F=%u\n", M, I, L, O, A, B, C, J, F);
 
+	reserve_objects();
 	line_count = 1;
 	piNum = 0;
 	flopNum = 0;
@@ -336,7 +338,31 @@ static uint32_t parse_xaiger_literal(std::istream &f)
 	return from_big_endian(l);
 }
 
+// The header gives the number of objects, so the module's containers can be
+// sized up front. Every variable gets at most one wire and its inverted
+// literal another one, every AND gate and latch gets one cell.
+void AigerReader::reserve_objects()
+{
+	// the counts aren't checked against the file yet, so skip this for
+	// inconsistent or absurd headers
+	if (M > size_t(I) + L + A || M >= (1u << 30))
+		return;
+	literal_wires.assign(2 * (size_t(M) + 1), nullptr);
+	module->wires_.reserve(size_t(I) + L + O + M + 1);
+	module->cells_.reserve(size_t(A) + L);
+}
+
 RTLIL::Wire* AigerReader::createWireIfNotExists(RTLIL::Module *module, unsigned literal)
+{
+	if (literal < literal_wires.size() && literal_wires[literal])
+		return literal_wires[literal];
+	RTLIL::Wire *wire = createWire(module, literal);
+	if (literal < literal_wires.size())
+		literal_wires[literal] = wire;
+	return wire;
+}
+
+RTLIL::Wire* AigerReader::createWire(RTLIL::Module *module, unsigned literal)
 {
 	const unsigned variable = literal >> 1;
 	const bool invert = literal & 1;
@@ -385,6 +411,7 @@ void AigerReader::parse_xaiger()
 
 	log_debug("M=%u I=%u L=%u O=%u A=%u\n", M, I, L, O, A);
 
+	reserve_objects();
 	line_count = 1;
 	piNum = 0;
 	flopNum = 0;
@@ -638,12 +665,20 @@ void AigerReader::parse_aiger_ascii()
 	}
 }
 
-static unsigned parse_next_delta_literal(std::istream &f, unsigned ref)
+// reads from the stream buffer directly, going through std::istream::get()
+// for every byte of the AND section is much slower
+static unsigned parse_next_delta_literal(std::streambuf &buf, unsigned ref, unsigned line_count)
 {
 	unsigned x = 0, i = 0;
-	unsigned char ch;
-	while ((ch = f.get()) & 0x80)
+	int ch;
+	while (1) {
+		ch = buf.sbumpc();
+		if (ch == EOF)
+			log_error("Line %u: unexpected end of file in AND gate!\n", line_count);
+		if (!(ch & 0x80))
+			break;
 		x |= (ch & 0x7f) << (7 * i++);
+	}
 	return ref - (x | (ch << (7 * i)));
 }
 
@@ -750,8 +785,8 @@ void AigerReader::parse_aiger_binary()
 	// Parse AND
 	l1 = (I+L+1) << 1;
 	for (unsigned i = 0; i < A; ++i, ++line_count, l1 += 2) {
-		l2 = parse_next_delta_literal(f, l1);
-		l3 = parse_next_delta_literal(f, l2);
+		l2 = parse_next_delta_literal(*f.rdbuf(), l1, line_count);
+		l3 = parse_next_delta_literal(*f.rdbuf(), l2, line_count);
 
 		log_debug2("%d %d %d is an AND\n", l1, l2, l3);
 		log_assert(!(l1 & 1));
@@ -1055,7 +1090,13 @@ struct AigerFrontend : public Frontend {
 #endif
 		}
 
-		AigerReader reader(design, *f, module_name, clk_name, map_filename, wideports);
+		// plain files are read from memory
+		std::istream *in = f;
+		mapped_istream mapped;
+		if (dynamic_cast<std::ifstream*>(f) != nullptr && mapped.open(filename))
+			in = &mapped;
+
+		AigerReader reader(design, *in, module_name, clk_name, map_filename, wideports);
 		if (xaiger)
 			reader.parse_xaiger();
 		else
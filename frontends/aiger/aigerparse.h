@@ -46,6 +46,8 @@ struct AigerReader
     std::vector<RTLIL::Wire*> bad_properties;
     std::vector<RTLIL::Cell*> boxes;
     std::vector<int> mergeability, initial_state;
+    // wires returned by createWireIfNotExists, indexed by literal
+    std::vector<RTLIL::Wire*> literal_wires;
 
     AigerReader(RTLIL::Design *design, std::istream &f, RTLIL::IdString module_name, RTLIL::IdString clk_name, std::string map_filename, bool wideports);
     void parse_aiger();
@@ -53,8 +55,10 @@ struct AigerReader
     void parse_aiger_ascii();
     void parse_aiger_binary();
     void post_process();
+    void reserve_objects();
 
     RTLIL::Wire* createWireIfNotExists(RTLIL::Module *module, unsigned literal);
+    RTLIL::Wire* createWire(RTLIL::Module *module, unsigned literal);
 };
 
 YOSYS_NAMESPACE_END
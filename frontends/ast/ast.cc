@@ -50,7 +50,7 @@ namespace AST_INTERNAL {
 	bool flag_nodisplay, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_vlog1, flag_dump_vlog2, flag_dump_rtlil, flag_nolatches, flag_nomeminit;
 	bool flag_nomem2reg, flag_mem2reg, flag_noblackbox, flag_lib, flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_autowire;
 	AstNode *current_ast, *current_ast_mod;
-	std::map<std::string, AstNode*> current_scope;
+	dict<std::string, AstNode*> current_scope;
 	const dict<RTLIL::SigBit, RTLIL::SigBit> *genRTLIL_subst_ptr = NULL;
 	RTLIL::SigSpec ignoreThisSignalsInInitial;
 	AstNode *current_always, *current_top_block, *current_block, *current_block_child;
@@ -58,6 +58,7 @@ namespace AST_INTERNAL {
 	bool current_always_clocked;
 	dict<std::string, int> current_memwr_count;
 	dict<std::string, pool<int>> current_memwr_visible;
+	ConstFunctionCache const_function_cache;
 }
 
 // convert node types to string
@@ -250,6 +251,30 @@ AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *ch
 	fixup_hierarchy_flags();
 }
 
+// the slab is never destroyed, as nodes may still be deleted from static destructors
+static RTLIL::ObjectSlab<AstNode> &astnode_slab()
+{
+	static RTLIL::ObjectSlab<AstNode> *slab = new RTLIL::ObjectSlab<AstNode>;
+	return *slab;
+}
+
+void *AstNode::operator new(size_t size)
+{
+	if (size != sizeof(AstNode))
+		return ::operator new(size);
+	return astnode_slab().allocate();
+}
+
+void AstNode::operator delete(void *ptr, size_t size)
+{
+	if (ptr == nullptr)
+		return;
+	if (size != sizeof(AstNode))
+		::operator delete(ptr);
+	else
+		astnode_slab().release(ptr);
+}
+
 // create a (deep recursive) copy of a node
 AstNode *AstNode::clone() const
 {
@@ -304,6 +329,8 @@ AstNode::~AstNode()
 void AstNode::dumpAst(FILE *f, std::string indent) const
 {
 	if (f == NULL) {
+		// write out what was logged before, see log_file_async()
+		log_flush();
 		for (auto f : log_files)
 			dumpAst(f, indent);
 		return;
@@ -408,6 +435,8 @@ void AstNode::dumpVlog(FILE *f, std::string indent) const
 	std::vector<AstNode*> rem_children1, rem_children2;
 
 	if (f == NULL) {
+		// write out what was logged before, see log_file_async()
+		log_flush();
 		for (auto f : log_files)
 			dumpVlog(f, indent);
 		return;
@@ -1149,9 +1178,19 @@ static RTLIL::Module *process_module(RTLIL::Design *design, AstNode *ast, bool d
 		// simplify this module or interface using the current design as context
 		// for lookup up ports and wires within cells
 		set_simplify_design_context(design);
+		const_function_cache.begin_module(design);
+		int cache_hits = const_function_cache.hits, cache_misses = const_function_cache.misses;
+		int cache_uncached = const_function_cache.uncached;
 		while (ast->simplify(!flag_noopt, 0, -1, false)) { }
 		set_simplify_design_context(nullptr);
 
+		cache_hits = const_function_cache.hits - cache_hits;
+		cache_misses = const_function_cache.misses - cache_misses;
+		cache_uncached = const_function_cache.uncached - cache_uncached;
+		if (cache_hits + cache_misses + cache_uncached > 0)
+			log_debug("Constant function calls: %d cached, %d evaluated, %d not cacheable (%d results cached in total).\n",
+					cache_hits, cache_misses, cache_uncached, GetSize(const_function_cache.results));
+
 		if (flag_dump_ast2) {
 			log("Dumping AST after simplification:\n");
 			ast->dumpAst(NULL, "    ");
@@ -172,7 +172,77 @@ namespace AST
 	// convert an node type to a string (e.g. for debug output)
 	std::string type2str(AstNodeType type);
 
-	// The AST is built using instances of this struct
+	struct AstNode;
+
+	// The attributes of an AST node. Most nodes have no or only a few attributes,
+	// so they are kept in a vector sorted by name instead of a std::map. This
+	// provides the subset of the std::map interface used by the frontends and
+	// iterates in the same order.
+	struct AstAttributes
+	{
+		typedef std::pair<RTLIL::IdString, AstNode*> value_type;
+		typedef std::vector<value_type>::iterator iterator;
+		typedef std::vector<value_type>::const_iterator const_iterator;
+
+		iterator begin() { return entries.begin(); }
+		iterator end() { return entries.end(); }
+		const_iterator begin() const { return entries.begin(); }
+		const_iterator end() const { return entries.end(); }
+
+		bool empty() const { return entries.empty(); }
+		size_t size() const { return entries.size(); }
+		void clear() { entries.clear(); }
+
+		iterator find(RTLIL::IdString key) {
+			auto it = lower_bound(key);
+			return it != entries.end() && it->first == key ? it : entries.end();
+		}
+		const_iterator find(RTLIL::IdString key) const {
+			return const_cast<AstAttributes*>(this)->find(key);
+		}
+		size_t count(RTLIL::IdString key) const { return find(key) != end(); }
+
+		AstNode *&at(RTLIL::IdString key) {
+			auto it = find(key);
+			if (it == entries.end())
+				throw std::out_of_range("AstAttributes::at()");
+			return it->second;
+		}
+		AstNode *at(RTLIL::IdString key) const {
+			return const_cast<AstAttributes*>(this)->at(key);
+		}
+
+		AstNode *&operator[](RTLIL::IdString key) {
+			return emplace(key, nullptr).first->second;
+		}
+		std::pair<iterator, bool> emplace(RTLIL::IdString key, AstNode *node) {
+			auto it = lower_bound(key);
+			if (it != entries.end() && it->first == key)
+				return {it, false};
+			return {entries.emplace(it, key, node), true};
+		}
+
+		iterator erase(iterator it) { return entries.erase(it); }
+		size_t erase(RTLIL::IdString key) {
+			auto it = find(key);
+			if (it == entries.end())
+				return 0;
+			entries.erase(it);
+			return 1;
+		}
+
+	private:
+		std::vector<value_type> entries;
+
+		iterator lower_bound(RTLIL::IdString key) {
+			return std::lower_bound(entries.begin(), entries.end(), key,
+					[](const value_type &entry, RTLIL::IdString k) { return entry.first < k; });
+		}
+	};
+
+	// The AST is built using instances of this struct. The fields are grouped by
+	// size to keep the nodes small, and nodes are allocated from a shared slab
+	// (see operator new below), as large designs create millions of them.
 	struct AstNode
 	{
 		// for dict<> and pool<>
@@ -186,18 +256,15 @@ namespace AST
 		std::vector<AstNode*> children;
 
 		// the list of attributes assigned to this node
-		std::map<RTLIL::IdString, AstNode*> attributes;
+		AstAttributes attributes;
 		bool get_bool_attribute(RTLIL::IdString id);
 
 		// node content - most of it is unused in most node types
 		std::string str;
 		std::vector<RTLIL::State> bits;
-		bool is_input, is_output, is_reg, is_logic, is_signed, is_string, is_wand, is_wor, range_valid, range_swapped, was_checked, is_unsized, is_custom_type;
+		double realvalue;
 		int port_id, range_left, range_right;
 		uint32_t integer;
-		double realvalue;
-		// set for IDs typed to an enumeration, not used
-		bool is_enum;
 
 		// Declared range for array dimension.
 		struct dimension_t {
@@ -208,24 +275,29 @@ namespace AST
 		// Packed and unpacked dimensions for arrays.
 		// Unpacked dimensions go first, to follow the order of indexing.
 		std::vector<dimension_t> dimensions;
-		// Number of unpacked dimensions.
-		int unpacked_dimensions;
 
 		// this is set by simplify and used during RTLIL generation
 		AstNode *id2ast;
 
-		// this is used by simplify to detect if basic analysis has been performed already on the node
-		bool basic_prep;
-
-		// this is used for ID references in RHS expressions that should use the "new" value for non-blocking assignments
-		bool lookahead;
-
 		// this is the original sourcecode location that resulted in this AST node
 		// it is automatically set by the constructor using AST::current_filename and
 		// the AST::get_line_num() callback function.
 		std::string filename;
 		AstSrcLocType location;
 
+		// Number of unpacked dimensions.
+		int unpacked_dimensions;
+
+		bool is_input, is_output, is_reg, is_logic, is_signed, is_string, is_wand, is_wor, range_valid, range_swapped, was_checked, is_unsized, is_custom_type;
+		// set for IDs typed to an enumeration, not used
+		bool is_enum;
+
+		// this is used by simplify to detect if basic analysis has been performed already on the node
+		bool basic_prep;
+
+		// this is used for ID references in RHS expressions that should use the "new" value for non-blocking assignments
+		bool lookahead;
+
 		// are we embedded in an lvalue, param?
 		// (see fixup_hierarchy_flags)
 		bool in_lvalue;
@@ -233,6 +305,11 @@ namespace AST
 		bool in_lvalue_from_above;
 		bool in_param_from_above;
 
+		// nodes are allocated from a slab that is shared by all ASTs and
+		// reuses the memory of deleted nodes
+		static void *operator new(size_t size);
+		static void operator delete(void *ptr, size_t size);
+
 		// creating and deleting nodes
 		AstNode(AstNodeType type = AST_NONE, AstNode *child1 = nullptr, AstNode *child2 = nullptr, AstNode *child3 = nullptr, AstNode *child4 = nullptr);
 		AstNode *clone() const;
@@ -443,7 +520,7 @@ namespace AST_INTERNAL
 	extern bool flag_nodisplay, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_rtlil, flag_nolatches, flag_nomeminit;
 	extern bool flag_nomem2reg, flag_mem2reg, flag_lib, flag_noopt, flag_icells, flag_pwires, flag_autowire;
 	extern AST::AstNode *current_ast, *current_ast_mod;
-	extern std::map<std::string, AST::AstNode*> current_scope;
+	extern dict<std::string, AST::AstNode*> current_scope;
 	extern const dict<RTLIL::SigBit, RTLIL::SigBit> *genRTLIL_subst_ptr;
 	extern RTLIL::SigSpec ignoreThisSignalsInInitial;
 	extern AST::AstNode *current_always, *current_top_block, *current_block, *current_block_child;
@@ -454,6 +531,31 @@ namespace AST_INTERNAL
 	struct LookaheadRewriter;
 	struct ProcessGenerator;
 
+	// Memoized results of constant function calls, so that identical calls from
+	// different instances, generate iterations and derived modules are only
+	// evaluated once (see AstNode::simplify()). A call is identified by the
+	// declarations it depends on and its constant arguments.
+	struct ConstFunctionCache
+	{
+		struct Result {
+			std::vector<RTLIL::State> bits;
+			bool is_signed;
+			bool failed;
+		};
+		dict<std::string, int> contexts;
+		dict<std::pair<int, std::string>, Result> results;
+		int hits = 0, misses = 0, uncached = 0;
+
+		// the results are only kept for modules of one design, and only up
+		// to this many of them
+		static constexpr int max_results = 100000;
+		Hasher::hash_t design_hashidx = 0;
+
+		bool make_key(AST::AstNode *decl, const std::vector<AST::AstNode*> &args, std::pair<int, std::string> &key);
+		void begin_module(RTLIL::Design *design);
+	};
+	extern ConstFunctionCache const_function_cache;
+
 	// Create and add a new AstModule from new_ast, then use it to replace
 	// old_module in design, renaming old_module to move it out of the way.
 	// Return the new module.
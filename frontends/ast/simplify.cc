@@ -1090,8 +1090,11 @@ bool AstNode::simplify(bool const_fold, int stage, int width_hint, bool sign_hin
 	// activate const folding if this is anything that must be evaluated statically (ranges, parameters, attributes, etc.)
 	if (type == AST_WIRE || type == AST_PARAMETER || type == AST_LOCALPARAM || type == AST_ENUM_ITEM || type == AST_DEFPARAM || type == AST_PARASET || type == AST_RANGE || type == AST_PREFIX || type == AST_TYPEDEF)
 		const_fold = true;
-	if (type == AST_IDENTIFIER && current_scope.count(str) > 0 && (current_scope[str]->type == AST_PARAMETER || current_scope[str]->type == AST_LOCALPARAM || current_scope[str]->type == AST_ENUM_ITEM))
-		const_fold = true;
+	if (type == AST_IDENTIFIER) {
+		auto it = current_scope.find(str);
+		if (it != current_scope.end() && (it->second->type == AST_PARAMETER || it->second->type == AST_LOCALPARAM || it->second->type == AST_ENUM_ITEM))
+			const_fold = true;
+	}
 
 	std::map<std::string, AstNode*> backup_scope;
 
@@ -2227,8 +2230,9 @@ bool AstNode::simplify(bool const_fold, int stage, int width_hint, bool sign_hin
 
 	if (type == AST_IDENTIFIER && !basic_prep) {
 		// check if a plausible struct member sss.mmmm
-		if (!str.empty() && str[0] == '\\' && current_scope.count(str)) {
-			auto item_node = current_scope[str];
+		auto it = str.empty() || str[0] != '\\' ? current_scope.end() : current_scope.find(str);
+		if (it != current_scope.end()) {
+			auto item_node = it->second;
 			if (item_node->type == AST_STRUCT_ITEM || item_node->type == AST_STRUCT || item_node->type == AST_UNION) {
 				// Traverse any hierarchical path until the full name for the referenced struct/union is found.
 				std::string sname;
@@ -2267,7 +2271,8 @@ bool AstNode::simplify(bool const_fold, int stage, int width_hint, bool sign_hin
 	}
 	// annotate identifiers using scope resolution and create auto-wires as needed
 	if (type == AST_IDENTIFIER) {
-		if (current_scope.count(str) == 0) {
+		auto it = current_scope.find(str);
+		if (it == current_scope.end()) {
 			AstNode *current_scope_ast = (current_ast_mod == nullptr) ? current_ast : current_ast_mod;
 			str = try_pop_module_prefix();
 			for (auto node : current_scope_ast->children) {
@@ -2302,22 +2307,23 @@ bool AstNode::simplify(bool const_fold, int stage, int width_hint, bool sign_hin
 					break;
 				}
 			}
-		}
-		if (current_scope.count(str) == 0) {
-			if (current_ast_mod == nullptr) {
-				input_error("Identifier `%s' is implicitly declared outside of a module.\n", str.c_str());
-			} else if (flag_autowire || str == "\\$global_clock") {
-				AstNode *auto_wire = new AstNode(AST_AUTOWIRE);
-				auto_wire->str = str;
-				current_ast_mod->children.push_back(auto_wire);
-				current_scope[str] = auto_wire;
-				did_something = true;
-			} else {
-				input_error("Identifier `%s' is implicitly declared and `default_nettype is set to none.\n", str.c_str());
+			if (current_scope.count(str) == 0) {
+				if (current_ast_mod == nullptr) {
+					input_error("Identifier `%s' is implicitly declared outside of a module.\n", str.c_str());
+				} else if (flag_autowire || str == "\\$global_clock") {
+					AstNode *auto_wire = new AstNode(AST_AUTOWIRE);
+					auto_wire->str = str;
+					current_ast_mod->children.push_back(auto_wire);
+					current_scope[str] = auto_wire;
+					did_something = true;
+				} else {
+					input_error("Identifier `%s' is implicitly declared and `default_nettype is set to none.\n", str.c_str());
+				}
 			}
+			it = current_scope.find(str);
 		}
-		if (id2ast != current_scope[str]) {
-			id2ast = current_scope[str];
+		if (id2ast != it->second) {
+			id2ast = it->second;
 			did_something = true;
 		}
 	}
@@ -3893,6 +3899,7 @@ skip_dynamic_range_lvalue_expansion:;
 		AstNode *decl = current_scope[str];
 		if (unevaluated_tern_branch && decl->is_recursive_function())
 			goto replace_fcall_later;
+		AstNode *orig_decl = decl;
 		decl = decl->clone();
 		decl->replace_result_wire_name_in_function(str, "$result"); // enables recursion
 		decl->expand_genblock(prefix);
@@ -3908,11 +3915,31 @@ skip_dynamic_range_lvalue_expansion:;
 			}
 
 			if (all_args_const) {
-				AstNode *func_workspace = decl->clone();
-				func_workspace->set_in_param_flag(true);
-				func_workspace->str = prefix_id(prefix, "$result");
-				newNode = func_workspace->eval_const_function(this, in_param || require_const_eval);
-				delete func_workspace;
+				bool must_succeed = in_param || require_const_eval;
+				auto &cache = const_function_cache;
+				std::pair<int, std::string> key;
+				bool cacheable = cache.make_key(orig_decl, children, key);
+				auto cached = cacheable ? cache.results.find(key) : cache.results.end();
+				// failed evaluations are repeated if an error message is needed
+				if (cached != cache.results.end() && !(cached->second.failed && must_succeed)) {
+					cache.hits++;
+					if (!cached->second.failed)
+						newNode = mkconst_bits(cached->second.bits, cached->second.is_signed);
+				} else {
+					if (cacheable)
+						cache.misses++;
+					else
+						cache.uncached++;
+					AstNode *func_workspace = decl->clone();
+					func_workspace->set_in_param_flag(true);
+					func_workspace->str = prefix_id(prefix, "$result");
+					newNode = func_workspace->eval_const_function(this, must_succeed);
+					delete func_workspace;
+					if (cacheable && newNode)
+						cache.results[key] = {newNode->bits, newNode->is_signed, false};
+					else if (cacheable)
+						cache.results[key] = {{}, false, true};
+				}
 				if (newNode) {
 					delete decl;
 					goto apply_newNode;
@@ -4580,6 +4607,40 @@ AstNode *AstNode::readmem(bool is_readmemh, std::string mem_filename, AstNode *m
 	return block;
 }
 
+// Resolves ident as it is referenced from the scope given by prefix, searching
+// the innermost scope first and then stepping outward. Returns an empty string
+// if ident is not declared in any of these scopes.
+static std::string resolve_in_scope(const std::string &prefix, const std::string &ident)
+{
+	for (size_t ppos = prefix.empty() ? 0 : prefix.size() - 1; ppos; --ppos) {
+		if (prefix.at(ppos) != '.') continue;
+
+		std::string new_prefix = prefix.substr(0, ppos + 1);
+		auto attempt_resolve = [&new_prefix](const std::string &ident) -> std::string {
+			std::string new_name = prefix_id(new_prefix, ident);
+			if (current_scope.count(new_name))
+				return new_name;
+			return {};
+		};
+
+		// attempt to resolve the full identifier
+		std::string resolved = attempt_resolve(ident);
+		if (!resolved.empty())
+			return resolved;
+
+		// attempt to resolve hierarchical prefixes within the identifier,
+		// as the prefix could refer to a local scope which exists but
+		// hasn't yet been elaborated
+		for (size_t spos = ident.size() - 1; spos; --spos) {
+			if (ident.at(spos) != '.') continue;
+			resolved = attempt_resolve(ident.substr(0, spos));
+			if (!resolved.empty())
+				return resolved + ident.substr(spos);
+		}
+	}
+	return {};
+}
+
 // annotate the names of all wires and other named objects in a named generate
 // or procedural block; nested blocks are themselves annotated such that the
 // prefix is carried forward, but resolution of their children is deferred
@@ -4587,40 +4648,9 @@ void AstNode::expand_genblock(const std::string &prefix)
 {
 	if (type == AST_IDENTIFIER || type == AST_FCALL || type == AST_TCALL || type == AST_WIRETYPE || type == AST_PREFIX) {
 		log_assert(!str.empty());
-
-		// search starting in the innermost scope and then stepping outward
-		for (size_t ppos = prefix.size() - 1; ppos; --ppos) {
-			if (prefix.at(ppos) != '.') continue;
-
-			std::string new_prefix = prefix.substr(0, ppos + 1);
-			auto attempt_resolve = [&new_prefix](const std::string &ident) -> std::string {
-				std::string new_name = prefix_id(new_prefix, ident);
-				if (current_scope.count(new_name))
-					return new_name;
-				return {};
-			};
-
-			// attempt to resolve the full identifier
-			std::string resolved = attempt_resolve(str);
-			if (!resolved.empty()) {
-				str = resolved;
-				break;
-			}
-
-			// attempt to resolve hierarchical prefixes within the identifier,
-			// as the prefix could refer to a local scope which exists but
-			// hasn't yet been elaborated
-			for (size_t spos = str.size() - 1; spos; --spos) {
-				if (str.at(spos) != '.') continue;
-				resolved = attempt_resolve(str.substr(0, spos));
-				if (!resolved.empty()) {
-					str = resolved + str.substr(spos);
-					ppos = 1; // break outer loop
-					break;
-				}
-			}
-
-		}
+		std::string resolved = resolve_in_scope(prefix, str);
+		if (!resolved.empty())
+			str = resolved;
 	}
 
 	auto prefix_node = [&prefix](AstNode* child) {
@@ -5363,10 +5393,121 @@ bool AstNode::replace_variables(std::map<std::string, AstNode::varinfo_t> &varia
 	return true;
 }
 
+// helper function for ConstFunctionCache::make_key()
+static void append_const_eval_key(const AstNode *node, std::string &key)
+{
+	auto add = [&key](auto value) {
+		key += std::to_string(value);
+		key += ' ';
+	};
+	int flags = node->is_input | node->is_output << 1 | node->is_reg << 2 | node->is_logic << 3 | node->is_signed << 4 |
+			node->is_string << 5 | node->is_wand << 6 | node->is_wor << 7 | node->range_valid << 8 | node->range_swapped << 9 |
+			node->is_unsized << 10 | node->is_custom_type << 11 | node->is_enum << 12;
+	uint64_t realvalue;
+	static_assert(sizeof(realvalue) == sizeof(node->realvalue), "double is expected to be 64 bits");
+	memcpy(&realvalue, &node->realvalue, sizeof(realvalue));
+	key += '(';
+	add(node->type);
+	key += std::to_string(node->str.size());
+	key += ':';
+	key += node->str;
+	key += ' ';
+	add(flags);
+	add(node->port_id);
+	add(node->range_left);
+	add(node->range_right);
+	add(node->integer);
+	add(realvalue);
+	add(GetSize(node->bits));
+	for (auto bit : node->bits)
+		key += char('0' + bit);
+	for (auto &dim : node->dimensions) {
+		key += " [";
+		add(dim.range_right);
+		add(dim.range_width);
+		key += std::to_string(dim.range_swapped);
+		key += ']';
+	}
+	for (auto child : node->children)
+		append_const_eval_key(child, key);
+	key += ')';
+}
+
+// The result of a constant function call depends on the declaration of the
+// function and on everything it refers to in the current scope: the functions
+// it calls, and the parameters, types and enum items it uses. Names are
+// resolved like expand_genblock() does when the call is evaluated, so that
+// e.g. a localparam of the generate block the function is declared in shadows
+// a parameter of the module. Returns false for calls that depend on anything
+// else, these are not cached.
+bool ConstFunctionCache::make_key(AstNode *decl, const std::vector<AstNode*> &args, std::pair<int, std::string> &key)
+{
+	std::string context;
+	pool<const AstNode*> queued = {decl};
+	std::vector<const AstNode*> queue = {decl};
+
+	while (!queue.empty())
+	{
+		const AstNode *node = queue.back();
+		queue.pop_back();
+		append_const_eval_key(node, context);
+
+		pool<std::string> declared;
+		std::vector<const AstNode*> references;
+		std::vector<const AstNode*> stack = {node};
+		while (!stack.empty()) {
+			const AstNode *n = stack.back();
+			stack.pop_back();
+			if (n->type == AST_WIRE || n->type == AST_MEMORY || n->type == AST_LOCALPARAM || n->type == AST_PARAMETER ||
+					n->type == AST_TYPEDEF || n->type == AST_ENUM_ITEM)
+				declared.insert(n->str);
+			if ((n->type == AST_IDENTIFIER || n->type == AST_FCALL || n->type == AST_WIRETYPE) && n->str.compare(0, 1, "$") != 0)
+				references.push_back(n);
+			for (auto child : n->children)
+				stack.push_back(child);
+		}
+
+		for (auto ref : references) {
+			// the local variables of a function are its innermost scope
+			if (ref->str.empty() || declared.count(ref->str))
+				continue;
+			// e.g. \P referenced from \g.f can be \g.P
+			std::string name = resolve_in_scope(node->str, ref->str);
+			if (name.empty())
+				name = ref->str;
+			auto it = current_scope.find(name);
+			if (it == current_scope.end())
+				return false;
+			AstNode *target = it->second;
+			if (target->type != AST_FUNCTION && target->type != AST_PARAMETER && target->type != AST_LOCALPARAM &&
+					target->type != AST_TYPEDEF && target->type != AST_ENUM_ITEM)
+				return false;
+			if (queued.insert(target).second)
+				queue.push_back(target);
+		}
+	}
+
+	auto ctx = contexts.emplace(context, GetSize(contexts));
+	key.first = ctx.first->second;
+	key.second.clear();
+	for (auto arg : args)
+		append_const_eval_key(arg, key.second);
+	return true;
+}
+
+void ConstFunctionCache::begin_module(RTLIL::Design *design)
+{
+	if (design->hashidx_ != design_hashidx || GetSize(results) > max_results) {
+		contexts.clear();
+		results.clear();
+		design_hashidx = design->hashidx_;
+	}
+}
+
 // attempt to statically evaluate a functions with all-const arguments
 AstNode *AstNode::eval_const_function(AstNode *fcall, bool must_succeed)
 {
-	std::map<std::string, AstNode*> backup_scope = current_scope;
+	dict<std::string, AstNode*> backup_scope = current_scope;
 	std::map<std::string, AstNode::varinfo_t> variables;
 	std::vector<AstNode*> to_delete;
 	AstNode *block = new AstNode(AST_BLOCK);
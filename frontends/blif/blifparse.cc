@@ -18,14 +18,16 @@
  */
 
 #include "blifparse.h"
+#include "kernel/io.h"
 
 YOSYS_NAMESPACE_BEGIN
 
 const int lut_input_plane_limit = 12;
 
-static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count, std::istream &f)
+// reads the next line from [ptr, end) and joins continued lines, the
+// input itself is never modified
+static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count, const char *&ptr, const char *end)
 {
-	string strbuf;
 	int buffer_len = 0;
 	buffer[0] = 0;
 
@@ -45,13 +47,17 @@ static bool read_next_line(char *&buffer, size_t &buffer_size, int &line_count,
 			if (buffer_len > 0 && buffer[buffer_len-1] == '\\')
 				buffer[--buffer_len] = 0;
 			line_count++;
-			if (!std::getline(f, strbuf))
+			if (ptr == end)
 				return false;
-			while (buffer_size-buffer_len < strbuf.size()+1) {
+			const char *eol = (const char*)memchr(ptr, '\n', end - ptr);
+			size_t len = (eol ? eol : end) - ptr;
+			while (buffer_size-buffer_len < len+1) {
 				buffer_size *= 2;
 				buffer = (char*)realloc(buffer, buffer_size);
 			}
-			strcpy(buffer+buffer_len, strbuf.c_str());
+			memcpy(buffer+buffer_len, ptr, len);
+			buffer[buffer_len+len] = 0;
+			ptr = eol ? eol+1 : end;
 		} else
 			return true;
 	}
@@ -86,6 +92,13 @@ failed:
 
 void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool run_clean, bool sop_mode, bool wideports)
 {
+	std::string text(std::istreambuf_iterator<char>(f), {});
+	parse_blif(design, text.data(), text.size(), dff_name, run_clean, sop_mode, wideports);
+}
+
+void parse_blif(RTLIL::Design *design, const char *data, size_t size, IdString dff_name, bool run_clean, bool sop_mode, bool wideports)
+{
+	const char *ptr = data, *end = data + size;
 	RTLIL::Module *module = nullptr;
 	RTLIL::Const *lutptr = NULL;
 	RTLIL::Cell *sopcell = NULL;
@@ -135,7 +148,7 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 
 	while (1)
 	{
-		if (!read_next_line(buffer, buffer_size, line_count, f)) {
+		if (!read_next_line(buffer, buffer_size, line_count, ptr, end)) {
 			if (module != nullptr)
 				goto error;
 			free(buffer);
@@ -482,7 +495,7 @@ void parse_blif(RTLIL::Design *design, std::istream &f, IdString dff_name, bool
 				{
 					RTLIL::State state = RTLIL::State::Sa;
 					while (1) {
-						if (!read_next_line(buffer, buffer_size, line_count, f))
+						if (!read_next_line(buffer, buffer_size, line_count, ptr, end))
 							goto error;
 						for (int i = 0; buffer[i]; i++) {
 							if (buffer[i] == ' ' || buffer[i] == '\t')
@@ -661,7 +674,12 @@ struct BlifFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		parse_blif(design, *f, "", true, sop_mode, wideports);
+		// plain files are parsed in place
+		MappedFile mapped;
+		if (dynamic_cast<std::ifstream*>(f) != nullptr && mapped.open(filename))
+			parse_blif(design, mapped.data, mapped.size, "", true, sop_mode, wideports);
+		else
+			parse_blif(design, *f, "", true, sop_mode, wideports);
 	}
 } BlifFrontend;
 
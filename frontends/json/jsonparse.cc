@@ -18,606 +18,673 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/io.h"
 
 YOSYS_NAMESPACE_BEGIN
 
-struct JsonNode
+// Pull parser for JSON text in memory. Like the tree based parser it
+// replaces, it treats commas and colons between entries as optional.
+struct JsonReader
 {
-	char type; // S=String, N=Number, A=Array, D=Dict
-	string data_string;
-	int64_t data_number;
-	vector<JsonNode*> data_array;
-	dict<string, JsonNode*> data_dict;
-	vector<string> data_dict_keys;
-
-	JsonNode(std::istream &f)
+	const char *ptr, *end;
+
+	JsonReader(const char *data, size_t size) : ptr(data), end(data + size) { }
+
+	// returns the type of the next value without consuming it:
+	// S=String, N=Number, A=Array, D=Dict
+	char peek_type()
+	{
+		while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n'))
+			ptr++;
+		if (ptr == end)
+			log_error("Unexpected EOF in JSON file.\n");
+		char ch = *ptr;
+		if (ch == '"')
+			return 'S';
+		if (('0' <= ch && ch <= '9') || ch == '-')
+			return 'N';
+		if (ch == '[')
+			return 'A';
+		if (ch == '{')
+			return 'D';
+		log_error("Unexpected character in JSON file: '%c'\n", ch);
+	}
+
+	int get()
 	{
-		type = 0;
-		data_number = 0;
+		if (ptr == end)
+			log_error("Unexpected EOF in JSON string.\n");
+		return (unsigned char)*ptr++;
+	}
 
+	void parse_string(std::string &str)
+	{
+		str.clear();
+		ptr++;
 		while (1)
 		{
-			int ch = f.get();
-
-			if (ch == EOF)
-				log_error("Unexpected EOF in JSON file.\n");
-
-			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
-				continue;
+			const char *begin = ptr;
+			while (ptr < end && *ptr != '"' && *ptr != '\\')
+				ptr++;
+			str.append(begin, ptr);
 
+			int ch = get();
 			if (ch == '"')
-			{
-				type = 'S';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON string.\n");
-
-					if (ch == '"')
-						break;
-
-					if (ch == '\\') {
-						ch = f.get();
-
-						switch (ch) {
-							case EOF: log_error("Unexpected EOF in JSON string.\n"); break;
-							case '"':
-							case '/':
-							case '\\':           break;
-							case 'b': ch = '\b'; break;
-							case 'f': ch = '\f'; break;
-							case 'n': ch = '\n'; break;
-							case 'r': ch = '\r'; break;
-							case 't': ch = '\t'; break;
-							case 'u':
-								int val = 0;
-								for (int i = 0; i < 4; i++) {
-									ch = f.get();
-									val <<= 4;
-									if (ch >= '0' && '9' >= ch) {
-										val += ch - '0';
-									} else if (ch >= 'A' && 'F' >= ch) {
-										val += 10 + ch - 'A';
-									} else if (ch >= 'a' && 'f' >= ch) {
-										val += 10 + ch - 'a';
-									} else
-										log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
-								}
-								if (val < 128)
-									ch = val;
-								else
-									log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
-								break;
-						}
-					}
-
-					data_string += ch;
-				}
-
 				break;
-			}
-
-			if (('0' <= ch && ch <= '9') || ch == '-')
-			{
-				bool negative = false;
-				type = 'N';
-				if (ch == '-') {
-					data_number = 0;
-				       	negative = true;
-				} else {
-					data_number = ch - '0';
-				}
-
-				data_string += ch;
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						break;
 
-					if (ch == '.')
-						goto parse_real;
-
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
+			ch = get();
+			switch (ch) {
+				case '"':
+				case '/':
+				case '\\':           break;
+				case 'b': ch = '\b'; break;
+				case 'f': ch = '\f'; break;
+				case 'n': ch = '\n'; break;
+				case 'r': ch = '\r'; break;
+				case 't': ch = '\t'; break;
+				case 'u':
+					int val = 0;
+					for (int i = 0; i < 4; i++) {
+						ch = ptr < end ? (unsigned char)*ptr++ : EOF;
+						val <<= 4;
+						if (ch >= '0' && '9' >= ch) {
+							val += ch - '0';
+						} else if (ch >= 'A' && 'F' >= ch) {
+							val += 10 + ch - 'A';
+						} else if (ch >= 'a' && 'f' >= ch) {
+							val += 10 + ch - 'a';
+						} else
+							log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
 					}
-
-					data_number = data_number*10 + (ch - '0');
-					data_string += ch;
-				}
-
-				data_number = negative ? -data_number : data_number;
-				data_string = "";
-				break;
-
-			parse_real:
-				type = 'S';
-				data_number = 0;
-				data_string += ch;
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						break;
-
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
-					}
-
-					data_string += ch;
-				}
-
-				break;
+					if (val < 128)
+						ch = val;
+					else
+						log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
+					break;
 			}
+			str += ch;
+		}
+	}
 
-			if (ch == '[')
-			{
-				type = 'A';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
-
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
-
-					if (ch == ']')
-						break;
-
-					f.unget();
-					data_array.push_back(new JsonNode(f));
-				}
+	// parses a number, returns false (and the number as text in str) if
+	// it has a fractional part
+	bool parse_number(int64_t &number, std::string &str)
+	{
+		const char *begin = ptr;
+		bool negative = *ptr == '-';
+		if (negative)
+			ptr++;
+		number = 0;
+		while (ptr < end && '0' <= *ptr && *ptr <= '9')
+			number = number*10 + (*ptr++ - '0');
+		if (ptr < end && *ptr == '.') {
+			for (ptr++; ptr < end && '0' <= *ptr && *ptr <= '9'; ptr++) { }
+			str.assign(begin, ptr);
+			return false;
+		}
+		if (negative)
+			number = -number;
+		return true;
+	}
 
+	// skips whitespace and the given separator
+	void skip(char separator)
+	{
+		while (1) {
+			if (ptr == end)
+				log_error("Unexpected EOF in JSON file.\n");
+			char ch = *ptr;
+			if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' && ch != separator)
 				break;
-			}
-
-			if (ch == '{')
-			{
-				type = 'D';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
-
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
-
-					if (ch == '}')
-						break;
-
-					f.unget();
-					JsonNode key(f);
-
-					while (1)
-					{
-						ch = f.get();
-
-						if (ch == EOF)
-							log_error("Unexpected EOF in JSON file.\n");
-
-						if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ':')
-							continue;
-
-						f.unget();
-						break;
-					}
-
-					JsonNode *value = new JsonNode(f);
-
-					if (key.type != 'S')
-						log_error("Unexpected non-string key in JSON dict.\n");
+			ptr++;
+		}
+	}
 
-					data_dict[key.data_string] = value;
-					data_dict_keys.push_back(key.data_string);
-				}
+	// returns false at the end of an array or dict
+	bool next_entry(char closing)
+	{
+		skip(',');
+		if (*ptr != closing)
+			return true;
+		ptr++;
+		return false;
+	}
 
-				break;
+	// calls f(key) for each entry of the dict, f must consume the value
+	template<typename F>
+	void parse_dict(F f)
+	{
+		std::string key;
+		ptr++;
+		while (next_entry('}'))
+		{
+			if (peek_type() != 'S') {
+				skip_value();
+				log_error("Unexpected non-string key in JSON dict.\n");
 			}
-
-			log_error("Unexpected character in JSON file: '%c'\n", ch);
+			parse_string(key);
+			skip(':');
+			f(key);
 		}
 	}
 
-	~JsonNode()
+	// calls f(index) for each element of the array, f must consume the value
+	template<typename F>
+	void parse_array(F f)
 	{
-		for (auto it : data_array)
-			delete it;
-		for (auto &it : data_dict)
-			delete it.second;
+		ptr++;
+		for (int i = 0; next_entry(']'); i++)
+			f(i);
 	}
-};
 
-Const json_parse_attr_param_value(JsonNode *node)
-{
-	Const value;
-
-	if (node->type == 'S') {
-		string &s = node->data_string;
-		size_t cursor = s.find_first_not_of("01xz");
-		if (cursor == string::npos) {
-			value = Const::from_string(s);
-		} else if (s.find_first_not_of(' ', cursor) == string::npos) {
-			value = Const(s.substr(0, GetSize(s)-1));
-		} else {
-			value = Const(s);
+	void skip_value()
+	{
+		std::string str;
+		int64_t number;
+		switch (peek_type()) {
+			case 'S': parse_string(str); break;
+			case 'N': parse_number(number, str); break;
+			case 'A': parse_array([&](int) { skip_value(); }); break;
+			case 'D': parse_dict([&](const std::string &) { skip_value(); }); break;
 		}
-	} else
-	if (node->type == 'N') {
-		value = Const(node->data_number, 32);
-		if (node->data_number < 0)
-			value.flags |= RTLIL::CONST_FLAG_SIGNED;
-	} else
-	if (node->type == 'A') {
-		log_error("JSON attribute or parameter value is an array.\n");
-	} else
-	if (node->type == 'D') {
-		log_error("JSON attribute or parameter value is a dict.\n");
-	} else {
-		log_abort();
 	}
 
-	return value;
-}
-
-void json_parse_attr_param(dict<IdString, Const> &results, JsonNode *node)
-{
-	if (node->type != 'D')
-		log_error("JSON attributes or parameters node is not a dictionary.\n");
-
-	for (auto it : node->data_dict)
+	// reads an optional number field, returns false and ignores the value
+	// if it has another type
+	template<typename T>
+	bool parse_optional_number(T &value)
 	{
-		IdString key = RTLIL::escape_id(it.first.c_str());
-		Const value = json_parse_attr_param_value(it.second);
-		results[key] = value;
+		std::string str;
+		int64_t number;
+		if (peek_type() == 'N' && parse_number(number, str)) {
+			value = number;
+			return true;
+		}
+		skip_value();
+		return false;
 	}
-}
+};
 
-void json_import(Design *design, string &modname, JsonNode *node)
+// a bit in a ports, netnames or connections array, either an index into
+// the module's signals or a constant
+struct JsonBit
 {
-	log("Importing module %s from JSON tree.\n", modname.c_str());
-
-	Module *module = new RTLIL::Module;
-	module->name = RTLIL::escape_id(modname.c_str());
-
-	if (design->module(module->name))
-		log_error("Re-definition of module %s.\n", log_id(module->name));
-
-	design->add(module);
-
-	if (node->data_dict.count("attributes"))
-		json_parse_attr_param(module->attributes, node->data_dict.at("attributes"));
+	int index;
+	RTLIL::State state;
+};
 
+struct JsonImporter : JsonReader
+{
+	Design *design;
+	Module *module = nullptr;
 	dict<int, SigBit> signal_bits;
+	bool ports_done;
+	std::string scratch;
 
-	if (node->data_dict.count("ports"))
-	{
-		JsonNode *ports_node = node->data_dict.at("ports");
-
-		if (ports_node->type != 'D')
-			log_error("JSON ports node is not a dictionary.\n");
-
-		for (int port_id = 1; port_id <= GetSize(ports_node->data_dict_keys); port_id++)
-		{
-			IdString port_name = RTLIL::escape_id(ports_node->data_dict_keys[port_id-1].c_str());
-			JsonNode *port_node = ports_node->data_dict.at(ports_node->data_dict_keys[port_id-1]);
-
-			if (port_node->type != 'D')
-				log_error("JSON port node '%s' is not a dictionary.\n", log_id(port_name));
-
-			if (port_node->data_dict.count("direction") == 0)
-				log_error("JSON port node '%s' has no direction attribute.\n", log_id(port_name));
-
-			if (port_node->data_dict.count("bits") == 0)
-				log_error("JSON port node '%s' has no bits attribute.\n", log_id(port_name));
-
-			JsonNode *port_direction_node = port_node->data_dict.at("direction");
-			JsonNode *port_bits_node = port_node->data_dict.at("bits");
+	struct PendingConnection {
+		Cell *cell;
+		IdString port;
+		std::vector<JsonBit> bits;
+	};
+	std::vector<PendingConnection> pending;
 
-			if (port_direction_node->type != 'S')
-				log_error("JSON port node '%s' has non-string direction attribute.\n", log_id(port_name));
+	JsonImporter(const char *data, size_t size, Design *design) : JsonReader(data, size), design(design) { }
 
-			if (port_bits_node->type != 'A')
-				log_error("JSON port node '%s' has non-array bits attribute.\n", log_id(port_name));
+	Const parse_attr_param_value()
+	{
+		Const value;
+		int64_t number;
+		char type = peek_type();
+
+		if (type == 'N' && parse_number(number, scratch)) {
+			value = Const(number, 32);
+			if (number < 0)
+				value.flags |= RTLIL::CONST_FLAG_SIGNED;
+		} else
+		if (type == 'S' || type == 'N') {
+			if (type == 'S')
+				parse_string(scratch);
+			string &s = scratch;
+			size_t cursor = s.find_first_not_of("01xz");
+			if (cursor == string::npos) {
+				value = Const::from_string(s);
+			} else if (s.find_first_not_of(' ', cursor) == string::npos) {
+				value = Const(s.substr(0, GetSize(s)-1));
+			} else {
+				value = Const(s);
+			}
+		} else
+		if (type == 'A') {
+			log_error("JSON attribute or parameter value is an array.\n");
+		} else {
+			log_error("JSON attribute or parameter value is a dict.\n");
+		}
 
-			Wire *port_wire = module->wire(port_name);
+		return value;
+	}
 
-			if (port_wire == nullptr)
-				port_wire = module->addWire(port_name, GetSize(port_bits_node->data_array));
+	void parse_attr_param(dict<IdString, Const> &results)
+	{
+		if (peek_type() != 'D')
+			log_error("JSON attributes or parameters node is not a dictionary.\n");
 
-			if (port_node->data_dict.count("upto") != 0) {
-				JsonNode *val = port_node->data_dict.at("upto");
-				if (val->type == 'N')
-					port_wire->upto = val->data_number != 0;
-			}
+		parse_dict([&](const std::string &key) {
+			results[RTLIL::escape_id(key)] = parse_attr_param_value();
+		});
+	}
 
-			if (port_node->data_dict.count("signed") != 0) {
-				JsonNode *val = port_node->data_dict.at("signed");
-				if (val->type == 'N')
-					port_wire->is_signed = val->data_number != 0;
+	// error(value, i) is called for an invalid bit, value is nullptr if
+	// the bit is neither a string nor a number
+	template<typename E>
+	void parse_bits(std::vector<JsonBit> &bits, E error)
+	{
+		bits.clear();
+		parse_array([&](int i) {
+			int64_t number;
+			char type = peek_type();
+			if (type == 'N') {
+				if (parse_number(number, scratch))
+					bits.push_back({int(number), State::Sm});
+				else
+					error(&scratch, i);
+				return;
 			}
-
-			if (port_node->data_dict.count("offset") != 0) {
-				JsonNode *val = port_node->data_dict.at("offset");
-				if (val->type == 'N')
-					port_wire->start_offset = val->data_number;
+			if (type == 'S') {
+				parse_string(scratch);
+				if (scratch == "0")
+					bits.push_back({0, State::S0});
+				else if (scratch == "1")
+					bits.push_back({0, State::S1});
+				else if (scratch == "x")
+					bits.push_back({0, State::Sx});
+				else if (scratch == "z")
+					bits.push_back({0, State::Sz});
+				else
+					error(&scratch, i);
+				return;
 			}
+			skip_value();
+			error(nullptr, i);
+		});
+	}
 
-			if (port_direction_node->data_string == "input") {
-				port_wire->port_input = true;
-			} else
-			if (port_direction_node->data_string == "output") {
-				port_wire->port_output = true;
-			} else
-			if (port_direction_node->data_string == "inout") {
-				port_wire->port_input = true;
-				port_wire->port_output = true;
+	void import_port(const std::string &name, int port_id)
+	{
+		IdString port_name = RTLIL::escape_id(name);
+
+		if (peek_type() != 'D')
+			log_error("JSON port node '%s' is not a dictionary.\n", log_id(port_name));
+
+		bool has_direction = false, has_bits = false, upto = false, is_signed = false;
+		bool has_upto = false, has_signed = false, has_offset = false;
+		int offset = 0;
+		std::string direction;
+		std::vector<JsonBit> bits;
+
+		parse_dict([&](const std::string &key) {
+			if (key == "direction") {
+				if (peek_type() != 'S')
+					log_error("JSON port node '%s' has non-string direction attribute.\n", log_id(port_name));
+				parse_string(direction);
+				has_direction = true;
+			} else if (key == "bits") {
+				if (peek_type() != 'A')
+					log_error("JSON port node '%s' has non-array bits attribute.\n", log_id(port_name));
+				parse_bits(bits, [&](const std::string *value, int i) {
+					if (value == nullptr)
+						log_error("JSON port node '%s' has invalid bit value on bit %d.\n", log_id(port_name), i);
+					log_error("JSON port node '%s' has invalid '%s' bit string value on bit %d.\n",
+							log_id(port_name), value->c_str(), i);
+				});
+				has_bits = true;
+			} else if (key == "upto") {
+				has_upto = parse_optional_number(upto);
+			} else if (key == "signed") {
+				has_signed = parse_optional_number(is_signed);
+			} else if (key == "offset") {
+				has_offset = parse_optional_number(offset);
 			} else
-				log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), port_direction_node->data_string.c_str());
-
-			port_wire->port_id = port_id;
-
-			for (int i = 0; i < GetSize(port_bits_node->data_array); i++)
-			{
-				JsonNode *bitval_node = port_bits_node->data_array.at(i);
-				SigBit sigbit(port_wire, i);
-
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON port node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(port_name), bitval_node->data_string.c_str(), i);
-				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (port_wire->port_output) {
-							module->connect(sigbit, signal_bits.at(bitidx));
-						} else {
-							module->connect(signal_bits.at(bitidx), sigbit);
-							signal_bits[bitidx] = sigbit;
-						}
+				skip_value();
+		});
+
+		if (!has_direction)
+			log_error("JSON port node '%s' has no direction attribute.\n", log_id(port_name));
+
+		if (!has_bits)
+			log_error("JSON port node '%s' has no bits attribute.\n", log_id(port_name));
+
+		Wire *port_wire = module->wire(port_name);
+
+		if (port_wire == nullptr)
+			port_wire = module->addWire(port_name, GetSize(bits));
+
+		if (has_upto)
+			port_wire->upto = upto;
+		if (has_signed)
+			port_wire->is_signed = is_signed;
+		if (has_offset)
+			port_wire->start_offset = offset;
+
+		if (direction == "input") {
+			port_wire->port_input = true;
+		} else
+		if (direction == "output") {
+			port_wire->port_output = true;
+		} else
+		if (direction == "inout") {
+			port_wire->port_input = true;
+			port_wire->port_output = true;
+		} else
+			log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), direction.c_str());
+
+		port_wire->port_id = port_id;
+
+		for (int i = 0; i < GetSize(bits); i++)
+		{
+			SigBit sigbit(port_wire, i);
+
+			if (bits[i].state != State::Sm) {
+				module->connect(sigbit, bits[i].state);
+			} else {
+				int bitidx = bits[i].index;
+				if (signal_bits.count(bitidx)) {
+					if (port_wire->port_output) {
+						module->connect(sigbit, signal_bits.at(bitidx));
 					} else {
+						module->connect(signal_bits.at(bitidx), sigbit);
 						signal_bits[bitidx] = sigbit;
 					}
-				} else
-					log_error("JSON port node '%s' has invalid bit value on bit %d.\n", log_id(port_name), i);
+				} else {
+					signal_bits[bitidx] = sigbit;
+				}
 			}
 		}
-
-		module->fixup_ports();
 	}
 
-	if (node->data_dict.count("netnames"))
+	void import_netname(const std::string &name)
 	{
-		JsonNode *netnames_node = node->data_dict.at("netnames");
-
-		if (netnames_node->type != 'D')
-			log_error("JSON netnames node is not a dictionary.\n");
-
-		for (auto &net : netnames_node->data_dict)
-		{
-			IdString net_name = RTLIL::escape_id(net.first.c_str());
-			JsonNode *net_node = net.second;
-
-			if (net_node->type != 'D')
-				log_error("JSON netname node '%s' is not a dictionary.\n", log_id(net_name));
-
-			if (net_node->data_dict.count("bits") == 0)
-				log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
+		IdString net_name = RTLIL::escape_id(name);
+
+		if (peek_type() != 'D')
+			log_error("JSON netname node '%s' is not a dictionary.\n", log_id(net_name));
+
+		bool has_bits = false, upto = false, has_upto = false, has_offset = false;
+		int offset = 0;
+		std::vector<JsonBit> bits;
+		dict<IdString, Const> attributes;
+
+		parse_dict([&](const std::string &key) {
+			if (key == "bits") {
+				if (peek_type() != 'A')
+					log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
+				parse_bits(bits, [&](const std::string *value, int i) {
+					if (value == nullptr)
+						log_error("JSON netname node '%s' has invalid bit value on bit %d.\n", log_id(net_name), i);
+					log_error("JSON netname node '%s' has invalid '%s' bit string value on bit %d.\n",
+							log_id(net_name), value->c_str(), i);
+				});
+				has_bits = true;
+			} else if (key == "upto") {
+				has_upto = parse_optional_number(upto);
+			} else if (key == "offset") {
+				has_offset = parse_optional_number(offset);
+			} else if (key == "attributes") {
+				parse_attr_param(attributes);
+			} else
+				skip_value();
+		});
 
-			JsonNode *bits_node = net_node->data_dict.at("bits");
+		if (!has_bits)
+			log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
 
-			if (bits_node->type != 'A')
-				log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
+		Wire *wire = module->wire(net_name);
 
-			Wire *wire = module->wire(net_name);
+		if (wire == nullptr)
+			wire = module->addWire(net_name, GetSize(bits));
 
-			if (wire == nullptr)
-				wire = module->addWire(net_name, GetSize(bits_node->data_array));
+		if (has_upto)
+			wire->upto = upto;
+		if (has_offset)
+			wire->start_offset = offset;
 
-			if (net_node->data_dict.count("upto") != 0) {
-				JsonNode *val = net_node->data_dict.at("upto");
-				if (val->type == 'N')
-					wire->upto = val->data_number != 0;
+		for (int i = 0; i < GetSize(bits); i++)
+		{
+			SigBit sigbit(wire, i);
+
+			if (bits[i].state != State::Sm) {
+				module->connect(sigbit, bits[i].state);
+			} else {
+				int bitidx = bits[i].index;
+				if (signal_bits.count(bitidx)) {
+					if (sigbit != signal_bits.at(bitidx))
+						module->connect(sigbit, signal_bits.at(bitidx));
+				} else {
+					signal_bits[bitidx] = sigbit;
+				}
 			}
+		}
 
-			if (net_node->data_dict.count("offset") != 0) {
-				JsonNode *val = net_node->data_dict.at("offset");
-				if (val->type == 'N')
-					wire->start_offset = val->data_number;
-			}
+		for (auto &it : attributes)
+			wire->attributes[it.first] = std::move(it.second);
+	}
 
-			for (int i = 0; i < GetSize(bits_node->data_array); i++)
-			{
-				JsonNode *bitval_node = bits_node->data_array.at(i);
-				SigBit sigbit(wire, i);
-
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON netname node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(net_name), bitval_node->data_string.c_str(), i);
-				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (sigbit != signal_bits.at(bitidx))
-							module->connect(sigbit, signal_bits.at(bitidx));
-					} else {
-						signal_bits[bitidx] = sigbit;
-					}
-				} else
-					log_error("JSON netname node '%s' has invalid bit value on bit %d.\n", log_id(net_name), i);
-			}
+	// connections are bound right away if all their signals are known
+	// and no port can change them any more, otherwise at the end of the
+	// module
+	bool can_bind(const std::vector<JsonBit> &bits)
+	{
+		if (!ports_done)
+			return false;
+		for (auto &bit : bits)
+			if (bit.state == State::Sm && !signal_bits.count(bit.index))
+				return false;
+		return true;
+	}
 
-			if (net_node->data_dict.count("attributes"))
-				json_parse_attr_param(wire->attributes, net_node->data_dict.at("attributes"));
+	SigSpec bind(const std::vector<JsonBit> &bits)
+	{
+		SigSpec sig;
+		for (auto &bit : bits) {
+			if (bit.state != State::Sm) {
+				sig.append(bit.state);
+				continue;
+			}
+			auto it = signal_bits.find(bit.index);
+			if (it == signal_bits.end())
+				it = signal_bits.emplace(bit.index, module->addWire(NEW_ID)).first;
+			sig.append(it->second);
 		}
+		return sig;
 	}
 
-	if (node->data_dict.count("cells"))
+	void import_cell(const std::string &name)
 	{
-		JsonNode *cells_node = node->data_dict.at("cells");
-
-		if (cells_node->type != 'D')
-			log_error("JSON cells node is not a dictionary.\n");
-
-		for (auto &cell_node_it : cells_node->data_dict)
-		{
-			IdString cell_name = RTLIL::escape_id(cell_node_it.first.c_str());
-			JsonNode *cell_node = cell_node_it.second;
+		IdString cell_name = RTLIL::escape_id(name);
+
+		if (peek_type() != 'D')
+			log_error("JSON cells node '%s' is not a dictionary.\n", log_id(cell_name));
+
+		bool has_type = false, has_connections = false;
+		IdString cell_type;
+		dict<IdString, Const> attributes, parameters;
+		std::vector<std::pair<IdString, std::vector<JsonBit>>> connections;
+
+		parse_dict([&](const std::string &key) {
+			if (key == "type") {
+				if (peek_type() != 'S')
+					log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
+				parse_string(scratch);
+				cell_type = RTLIL::escape_id(scratch);
+				has_type = true;
+			} else if (key == "connections") {
+				if (peek_type() != 'D')
+					log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
+				parse_dict([&](const std::string &port) {
+					IdString conn_name = RTLIL::escape_id(port);
+					if (peek_type() != 'A')
+						log_error("JSON cells node '%s' connection '%s' is not an array.\n", log_id(cell_name), log_id(conn_name));
+					connections.emplace_back(conn_name, std::vector<JsonBit>());
+					parse_bits(connections.back().second, [&](const std::string *value, int i) {
+						if (value == nullptr)
+							log_error("JSON cells node '%s' connection '%s' has invalid bit value on bit %d.\n",
+									log_id(cell_name), log_id(conn_name), i);
+						log_error("JSON cells node '%s' connection '%s' has invalid '%s' bit string value on bit %d.\n",
+								log_id(cell_name), log_id(conn_name), value->c_str(), i);
+					});
+				});
+				has_connections = true;
+			} else if (key == "attributes") {
+				parse_attr_param(attributes);
+			} else if (key == "parameters") {
+				parse_attr_param(parameters);
+			} else
+				skip_value();
+		});
 
-			if (cell_node->type != 'D')
-				log_error("JSON cells node '%s' is not a dictionary.\n", log_id(cell_name));
+		if (!has_type)
+			log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
 
-			if (cell_node->data_dict.count("type") == 0)
-				log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
+		Cell *cell = module->addCell(cell_name, cell_type);
 
-			JsonNode *type_node = cell_node->data_dict.at("type");
+		if (!has_connections)
+			log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
 
-			if (type_node->type != 'S')
-				log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
+		for (auto &conn : connections) {
+			if (can_bind(conn.second))
+				cell->setPort(conn.first, bind(conn.second));
+			else
+				pending.push_back({cell, conn.first, std::move(conn.second)});
+		}
 
-			IdString cell_type = RTLIL::escape_id(type_node->data_string.c_str());
+		cell->attributes.swap(attributes);
+		cell->parameters.swap(parameters);
+	}
 
-			Cell *cell = module->addCell(cell_name, cell_type);
+	void import_memory(const std::string &name)
+	{
+		IdString memory_name = RTLIL::escape_id(name);
+
+		if (peek_type() != 'D')
+			log_error("JSON memory node '%s' is not a dictionary.\n", log_id(memory_name));
+
+		RTLIL::Memory *mem = new RTLIL::Memory;
+		mem->name = memory_name;
+		mem->start_offset = 0;
+
+		bool has_width = false, has_size = false;
+		int64_t number;
+
+		parse_dict([&](const std::string &key) {
+			if (key == "width") {
+				if (peek_type() != 'N' || !parse_number(number, scratch))
+					log_error("JSON memory node '%s' has a non-number width.\n", log_id(memory_name));
+				mem->width = number;
+				has_width = true;
+			} else if (key == "size") {
+				if (peek_type() != 'N' || !parse_number(number, scratch))
+					log_error("JSON memory node '%s' has a non-number size.\n", log_id(memory_name));
+				mem->size = number;
+				has_size = true;
+			} else if (key == "start_offset") {
+				parse_optional_number(mem->start_offset);
+			} else if (key == "attributes") {
+				parse_attr_param(mem->attributes);
+			} else
+				skip_value();
+		});
 
-			if (cell_node->data_dict.count("connections") == 0)
-				log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
+		if (!has_width)
+			log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
 
-			JsonNode *connections_node = cell_node->data_dict.at("connections");
+		if (!has_size)
+			log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
 
-			if (connections_node->type != 'D')
-				log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
+		module->memories[mem->name] = mem;
+	}
 
-			for (auto &conn_it : connections_node->data_dict)
-			{
-				IdString conn_name = RTLIL::escape_id(conn_it.first.c_str());
-				JsonNode *conn_node = conn_it.second;
+	void import_module(const std::string &modname)
+	{
+		log("Importing module %s from JSON tree.\n", modname.c_str());
 
-				if (conn_node->type != 'A')
-					log_error("JSON cells node '%s' connection '%s' is not an array.\n", log_id(cell_name), log_id(conn_name));
+		module = new RTLIL::Module;
+		module->name = RTLIL::escape_id(modname);
 
-				SigSpec sig;
+		if (design->module(module->name))
+			log_error("Re-definition of module %s.\n", log_id(module->name));
 
-				for (int i = 0; i < GetSize(conn_node->data_array); i++)
-				{
-					JsonNode *bitval_node = conn_node->data_array.at(i);
+		design->add(module);
 
-					if (bitval_node->type == 'S') {
-						if (bitval_node->data_string == "0")
-							sig.append(State::S0);
-						else if (bitval_node->data_string == "1")
-							sig.append(State::S1);
-						else if (bitval_node->data_string == "x")
-							sig.append(State::Sx);
-						else if (bitval_node->data_string == "z")
-							sig.append(State::Sz);
-						else
-							log_error("JSON cells node '%s' connection '%s' has invalid '%s' bit string value on bit %d.\n",
-									log_id(cell_name), log_id(conn_name), bitval_node->data_string.c_str(), i);
-					} else
-					if (bitval_node->type == 'N') {
-						int bitidx = bitval_node->data_number;
-						if (signal_bits.count(bitidx) == 0)
-							signal_bits[bitidx] = module->addWire(NEW_ID);
-						sig.append(signal_bits.at(bitidx));
-					} else
-						log_error("JSON cells node '%s' connection '%s' has invalid bit value on bit %d.\n",
-								log_id(cell_name), log_id(conn_name), i);
+		signal_bits.clear();
+		pending.clear();
+		ports_done = false;
 
-				}
+		if (peek_type() != 'D') {
+			skip_value();
+			return;
+		}
 
-				cell->setPort(conn_name, sig);
-			}
+		parse_dict([&](const std::string &key) {
+			if (key == "attributes") {
+				parse_attr_param(module->attributes);
+			} else if (key == "ports") {
+				if (peek_type() != 'D')
+					log_error("JSON ports node is not a dictionary.\n");
+				int port_id = 0;
+				parse_dict([&](const std::string &name) {
+					import_port(name, ++port_id);
+				});
+				module->fixup_ports();
+				ports_done = true;
+			} else if (key == "netnames") {
+				if (peek_type() != 'D')
+					log_error("JSON netnames node is not a dictionary.\n");
+				parse_dict([&](const std::string &name) {
+					import_netname(name);
+				});
+			} else if (key == "cells") {
+				if (peek_type() != 'D')
+					log_error("JSON cells node is not a dictionary.\n");
+				parse_dict([&](const std::string &name) {
+					import_cell(name);
+				});
+			} else if (key == "memories") {
+				if (peek_type() != 'D')
+					log_error("JSON memories node is not a dictionary.\n");
+				parse_dict([&](const std::string &name) {
+					import_memory(name);
+				});
+			} else
+				skip_value();
+		});
 
-			if (cell_node->data_dict.count("attributes"))
-				json_parse_attr_param(cell->attributes, cell_node->data_dict.at("attributes"));
+		for (auto &conn : pending)
+			conn.cell->setPort(conn.port, bind(conn.bits));
+		pending.clear();
 
-			if (cell_node->data_dict.count("parameters"))
-				json_parse_attr_param(cell->parameters, cell_node->data_dict.at("parameters"));
-		}
+		// remove duplicates from connections array
+		pool<RTLIL::SigSig> unique_connections(module->connections_.begin(), module->connections_.end());
+		module->connections_ = std::vector<RTLIL::SigSig>(unique_connections.begin(), unique_connections.end());
+		module->invalidate_sigmap();
 	}
 
-	if (node->data_dict.count("memories"))
+	void import()
 	{
-		JsonNode *memories_node = node->data_dict.at("memories");
-
-		if (memories_node->type != 'D')
-			log_error("JSON memories node is not a dictionary.\n");
+		if (peek_type() != 'D')
+			log_error("JSON root node is not a dictionary.\n");
 
-		for (auto &memory_node_it : memories_node->data_dict)
-		{
-			IdString memory_name = RTLIL::escape_id(memory_node_it.first.c_str());
-			JsonNode *memory_node = memory_node_it.second;
-
-			RTLIL::Memory *mem = new RTLIL::Memory;
-			mem->name = memory_name;
-
-			if (memory_node->type != 'D')
-				log_error("JSON memory node '%s' is not a dictionary.\n", log_id(memory_name));
-
-			if (memory_node->data_dict.count("width") == 0)
-				log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
-			JsonNode *width_node = memory_node->data_dict.at("width");
-			if (width_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number width.\n", log_id(memory_name));
-			mem->width = width_node->data_number;
-
-			if (memory_node->data_dict.count("size") == 0)
-				log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
-			JsonNode *size_node = memory_node->data_dict.at("size");
-			if (size_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number size.\n", log_id(memory_name));
-			mem->size = size_node->data_number;
-
-			mem->start_offset = 0;
-			if (memory_node->data_dict.count("start_offset") != 0) {
-				JsonNode *val = memory_node->data_dict.at("start_offset");
-				if (val->type == 'N')
-					mem->start_offset = val->data_number;
+		parse_dict([&](const std::string &key) {
+			if (key != "modules") {
+				skip_value();
+				return;
 			}
-
-			if (memory_node->data_dict.count("attributes"))
-				json_parse_attr_param(mem->attributes, memory_node->data_dict.at("attributes"));
-
-			module->memories[mem->name] = mem;
-		}
+			if (peek_type() != 'D')
+				log_error("JSON modules node is not a dictionary.\n");
+			parse_dict([&](const std::string &modname) {
+				import_module(modname);
+			});
+		});
 	}
-
-	// remove duplicates from connections array
-	pool<RTLIL::SigSig> unique_connections(module->connections_.begin(), module->connections_.end());
-	module->connections_ = std::vector<RTLIL::SigSig>(unique_connections.begin(), unique_connections.end());
-}
+};
 
 struct JsonFrontend : public Frontend {
 	JsonFrontend() : Frontend("json", "read JSON file") { }
@@ -646,21 +713,15 @@ struct JsonFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		JsonNode root(*f);
-
-		if (root.type != 'D')
-			log_error("JSON root node is not a dictionary.\n");
-
-		if (root.data_dict.count("modules") != 0)
-		{
-			JsonNode *modules = root.data_dict.at("modules");
-
-			if (modules->type != 'D')
-				log_error("JSON modules node is not a dictionary.\n");
-
-			for (auto &it : modules->data_dict)
-				json_import(design, it.first, it.second);
+		// plain files are parsed in place, anything else is read into memory first
+		MappedFile mapped;
+		if (dynamic_cast<std::ifstream*>(f) != nullptr && mapped.open(filename)) {
+			JsonImporter(mapped.data, mapped.size, design).import();
+			return;
 		}
+
+		std::string buffer(std::istreambuf_iterator<char>(*f), {});
+		JsonImporter(buffer.data(), buffer.size(), design).import();
 	}
 } JsonFrontend;
 
@@ -25,6 +25,7 @@
 #include "rtlil_frontend.h"
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/io.h"
 
 void rtlil_frontend_yyerror(char const *s)
 {
@@ -60,12 +61,17 @@ struct RTLILFrontend : public Frontend {
 		log("    -lib\n");
 		log("        only create empty blackbox modules\n");
 		log("\n");
+		log("    -legacy\n");
+		log("        use the flex/bison based parser instead of the default reader. both\n");
+		log("        accept the same input and create the same design.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		RTLIL_FRONTEND::flag_nooverwrite = false;
 		RTLIL_FRONTEND::flag_overwrite = false;
 		RTLIL_FRONTEND::flag_lib = false;
+		bool flag_legacy = false;
 
 		log_header(design, "Executing RTLIL frontend.\n");
 
@@ -86,20 +92,43 @@ struct RTLILFrontend : public Frontend {
 				RTLIL_FRONTEND::flag_lib = true;
 				continue;
 			}
+			if (arg == "-legacy") {
+				flag_legacy = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
 		log("Input filename: %s\n", filename.c_str());
 
-		RTLIL_FRONTEND::lexin = f;
-		RTLIL_FRONTEND::current_design = design;
-		rtlil_frontend_yydebug = false;
-		rtlil_frontend_yyrestart(NULL);
-		rtlil_frontend_yyparse();
-		rtlil_frontend_yylex_destroy();
+		if (flag_legacy) {
+			RTLIL_FRONTEND::parse_rtlil_legacy(f, design);
+			return;
+		}
+
+		// plain files are parsed in place, anything else (here documents,
+		// decompressed input) is read into memory first
+		MappedFile mapped;
+		if (dynamic_cast<std::ifstream*>(f) != nullptr && mapped.open(filename)) {
+			RTLIL_FRONTEND::parse_rtlil(mapped.data, mapped.size, design);
+			return;
+		}
+
+		std::string buffer(std::istreambuf_iterator<char>(*f), {});
+		RTLIL_FRONTEND::parse_rtlil(buffer.data(), buffer.size(), design);
 	}
 } RTLILFrontend;
 
+void RTLIL_FRONTEND::parse_rtlil_legacy(std::istream *f, RTLIL::Design *design)
+{
+	RTLIL_FRONTEND::lexin = f;
+	RTLIL_FRONTEND::current_design = design;
+	rtlil_frontend_yydebug = false;
+	rtlil_frontend_yyrestart(NULL);
+	rtlil_frontend_yyparse();
+	rtlil_frontend_yylex_destroy();
+}
+
 YOSYS_NAMESPACE_END
 
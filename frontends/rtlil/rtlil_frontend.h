@@ -35,6 +35,12 @@ namespace RTLIL_FRONTEND {
 	extern bool flag_nooverwrite;
 	extern bool flag_overwrite;
 	extern bool flag_lib;
+
+	// parses RTLIL text from memory, see rtlil_reader.cc
+	void parse_rtlil(const char *data, size_t size, RTLIL::Design *design);
+
+	// runs the flex/bison parser on the given stream
+	void parse_rtlil_legacy(std::istream *f, RTLIL::Design *design);
 }
 
 YOSYS_NAMESPACE_END
@@ -0,0 +1,759 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  A hand-written reader for the RTLIL text representation. It accepts the
+ *  same language as the flex/bison parser in rtlil_lexer.l and
+ *  rtlil_parser.y and creates the same designs, but tokenizes the input in
+ *  place instead of allocating a string for every token.
+ *
+ */
+
+#include "rtlil_frontend.h"
+#include "kernel/log.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+enum class Tok {
+	Eof, Eol, Id, Value, Int, String, Char, Invalid,
+	Autoidx, Module, Attribute, Parameter, Signed, Real, Wire, Memory, Width, Upto, Offset, Size,
+	Input, Output, Inout, Cell, Connect, Switch, Case, Assign, Sync, Low, High, Posedge, Negedge,
+	Edge, Always, Global, Init, Update, Memwr, Process, End
+};
+
+const std::pair<std::string_view, Tok> keywords[] = {
+	{"autoidx", Tok::Autoidx}, {"module", Tok::Module}, {"attribute", Tok::Attribute},
+	{"parameter", Tok::Parameter}, {"signed", Tok::Signed}, {"real", Tok::Real}, {"wire", Tok::Wire},
+	{"memory", Tok::Memory}, {"width", Tok::Width}, {"upto", Tok::Upto}, {"offset", Tok::Offset},
+	{"size", Tok::Size}, {"input", Tok::Input}, {"output", Tok::Output}, {"inout", Tok::Inout},
+	{"cell", Tok::Cell}, {"connect", Tok::Connect}, {"switch", Tok::Switch}, {"case", Tok::Case},
+	{"assign", Tok::Assign}, {"sync", Tok::Sync}, {"low", Tok::Low}, {"high", Tok::High},
+	{"posedge", Tok::Posedge}, {"negedge", Tok::Negedge}, {"edge", Tok::Edge}, {"always", Tok::Always},
+	{"global", Tok::Global}, {"init", Tok::Init}, {"update", Tok::Update}, {"memwr", Tok::Memwr},
+	{"process", Tok::Process}, {"end", Tok::End},
+};
+
+inline bool is_digit(char c) { return '0' <= c && c <= '9'; }
+
+struct RTLILReader
+{
+	const char *ptr, *end;
+	int line = 1;
+
+	// the current token, text is set for Id and Value
+	Tok tok = Tok::Eof;
+	std::string_view text;
+	int integer = 0;
+	char ch = 0;
+	std::string str;
+
+	RTLIL::Design *design;
+	RTLIL::Module *module = nullptr;
+	RTLIL::Process *process = nullptr;
+	std::vector<std::vector<RTLIL::SwitchRule*>*> switch_stack;
+	std::vector<RTLIL::CaseRule*> case_stack;
+	dict<RTLIL::IdString, RTLIL::Const> attrbuf;
+	std::string id_buffer;
+
+	RTLILReader(const char *data, size_t size, RTLIL::Design *design) :
+			ptr(data), end(data + size), design(design) { }
+
+	[[noreturn]] void error(const std::string &message)
+	{
+		log_error("Parser error in line %d: %s\n", line, message.c_str());
+	}
+
+	[[noreturn]] void syntax_error()
+	{
+		error("syntax error");
+	}
+
+	// tokenizer, follows the rules in rtlil_lexer.l
+
+	void next()
+	{
+		while (ptr < end) {
+			if (*ptr == ' ' || *ptr == '\t')
+				ptr++;
+			else if (*ptr == '#')
+				while (ptr < end && *ptr != '\n')
+					ptr++;
+			else
+				break;
+		}
+
+		if (ptr == end) {
+			tok = Tok::Eof;
+			return;
+		}
+
+		const char *begin = ptr;
+		char c = *ptr;
+
+		if (c == '\r' || c == '\n') {
+			for (; ptr < end && (*ptr == '\r' || *ptr == '\n'); ptr++)
+				line += *ptr == '\n';
+			tok = Tok::Eol;
+			return;
+		}
+
+		if ('a' <= c && c <= 'z') {
+			while (ptr < end && 'a' <= *ptr && *ptr <= 'z')
+				ptr++;
+			std::string_view word(begin, ptr - begin);
+			tok = Tok::Invalid;
+			for (auto &it : keywords)
+				if (it.first == word) {
+					tok = it.second;
+					break;
+				}
+			return;
+		}
+
+		if (c == '\\' || c == '$') {
+			for (ptr++; ptr < end && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n'; ptr++) { }
+			if (ptr - begin == 1) {
+				tok = Tok::Char;
+				ch = c;
+				return;
+			}
+			tok = Tok::Id;
+			text = std::string_view(begin, ptr - begin);
+			return;
+		}
+
+		if (is_digit(c) || (c == '-' && ptr + 1 < end && is_digit(ptr[1]))) {
+			for (ptr++; ptr < end && is_digit(*ptr); ptr++) { }
+			if (c != '-' && ptr < end && *ptr == '\'') {
+				ptr++;
+				if (ptr < end && *ptr == 's')
+					ptr++;
+				while (ptr < end && (*ptr == '0' || *ptr == '1' || *ptr == 'x' || *ptr == 'z' || *ptr == 'm' || *ptr == '-'))
+					ptr++;
+				tok = Tok::Value;
+				text = std::string_view(begin, ptr - begin);
+				return;
+			}
+			// literals that don't fit into an int are invalid
+			long long value = 0;
+			for (const char *p = begin + (c == '-'); p < ptr; p++) {
+				value = value * 10 + (*p - '0');
+				if (value > (long long)INT_MAX + 1)
+					break;
+			}
+			if (c == '-')
+				value = -value;
+			if (value < INT_MIN || value > INT_MAX) {
+				tok = Tok::Invalid;
+				return;
+			}
+			tok = Tok::Int;
+			integer = value;
+			return;
+		}
+
+		if (c == '"') {
+			std::string raw;
+			for (ptr++; ptr < end && *ptr != '"'; ptr++) {
+				if (*ptr == '\\' && ptr + 1 < end && ptr[1] != '\n')
+					raw += *ptr++;
+				line += *ptr == '\n';
+				raw += *ptr;
+			}
+			if (ptr == end) {
+				tok = Tok::Eof;
+				return;
+			}
+			ptr++;
+			unescape_string(raw);
+			tok = Tok::String;
+			return;
+		}
+
+		ptr++;
+		tok = Tok::Char;
+		ch = c;
+	}
+
+	// same escape handling as in rtlil_lexer.l, the string ends at the first NUL
+	void unescape_string(std::string &raw)
+	{
+		raw.push_back(0);
+		char *yystr = &raw[0];
+		int i = 0, j = 0;
+		while (yystr[i]) {
+			if (yystr[i] == '\\' && yystr[i + 1]) {
+				i++;
+				if (yystr[i] == 'n')
+					yystr[i] = '\n';
+				else if (yystr[i] == 't')
+					yystr[i] = '\t';
+				else if ('0' <= yystr[i] && yystr[i] <= '7') {
+					yystr[i] = yystr[i] - '0';
+					if ('0' <= yystr[i + 1] && yystr[i + 1] <= '7') {
+						yystr[i + 1] = yystr[i] * 8 + yystr[i + 1] - '0';
+						i++;
+					}
+					if ('0' <= yystr[i + 1] && yystr[i + 1] <= '7') {
+						yystr[i + 1] = yystr[i] * 8 + yystr[i + 1] - '0';
+						i++;
+					}
+				}
+			}
+			yystr[j++] = yystr[i++];
+		}
+		yystr[j] = 0;
+		str.assign(yystr);
+	}
+
+	bool is_char(char c) const { return tok == Tok::Char && ch == c; }
+
+	void expect(Tok t)
+	{
+		if (tok != t)
+			syntax_error();
+		next();
+	}
+
+	void expect_char(char c)
+	{
+		if (!is_char(c))
+			syntax_error();
+		next();
+	}
+
+	int expect_int()
+	{
+		if (tok != Tok::Int)
+			syntax_error();
+		int value = integer;
+		next();
+		return value;
+	}
+
+	void expect_eol()
+	{
+		if (tok != Tok::Eol)
+			syntax_error();
+		while (tok == Tok::Eol)
+			next();
+	}
+
+	RTLIL::IdString expect_id()
+	{
+		if (tok != Tok::Id)
+			syntax_error();
+		id_buffer.assign(text);
+		RTLIL::IdString id(id_buffer);
+		next();
+		return id;
+	}
+
+	// parser, follows the grammar in rtlil_parser.y
+
+	RTLIL::Const parse_value()
+	{
+		const char *p = text.data(), *e = p + text.size();
+		long long width = 0;
+		for (; p < e && is_digit(*p); p++)
+			width = std::min(width * 10 + (*p - '0'), (long long)INT_MAX);
+		bool is_signed = false;
+		if (p < e && *p == '\'')
+			p++;
+		if (p < e && *p == 's') {
+			is_signed = true;
+			p++;
+		}
+
+		std::vector<RTLIL::State> bits;
+		bits.reserve(e - p);
+		while (e > p) {
+			switch (*--e) {
+			case '0': bits.push_back(RTLIL::S0); break;
+			case '1': bits.push_back(RTLIL::S1); break;
+			case 'z': bits.push_back(RTLIL::Sz); break;
+			case '-': bits.push_back(RTLIL::Sa); break;
+			case 'm': bits.push_back(RTLIL::Sm); break;
+			default: bits.push_back(RTLIL::Sx); break;
+			}
+		}
+		if (bits.empty())
+			bits.push_back(RTLIL::Sx);
+		RTLIL::State extend = bits.back() == RTLIL::S1 ? RTLIL::S0 : bits.back();
+		bits.resize(width, extend);
+
+		RTLIL::Const value;
+		value.bits() = std::move(bits);
+		if (is_signed)
+			value.flags |= RTLIL::CONST_FLAG_SIGNED;
+		return value;
+	}
+
+	RTLIL::Const parse_constant()
+	{
+		if (tok == Tok::Value) {
+			RTLIL::Const value = parse_value();
+			next();
+			return value;
+		}
+		if (tok == Tok::Int) {
+			RTLIL::Const value(integer, 32);
+			next();
+			return value;
+		}
+		if (tok == Tok::String) {
+			RTLIL::Const value(str);
+			next();
+			return value;
+		}
+		syntax_error();
+	}
+
+	RTLIL::SigSpec parse_sigspec()
+	{
+		RTLIL::SigSpec sig;
+		if (tok == Tok::Id) {
+			id_buffer.assign(text);
+			RTLIL::Wire *wire = module->wire(id_buffer);
+			if (wire == nullptr)
+				error(stringf("RTLIL error: wire %s not found", id_buffer.c_str()));
+			sig = wire;
+			next();
+		} else if (is_char('{')) {
+			next();
+			std::vector<RTLIL::SigSpec> parts;
+			while (!is_char('}'))
+				parts.push_back(parse_sigspec());
+			next();
+			for (auto it = parts.rbegin(); it != parts.rend(); it++)
+				sig.append(*it);
+		} else {
+			sig = parse_constant();
+		}
+
+		while (is_char('[')) {
+			next();
+			int left = expect_int();
+			if (is_char(']')) {
+				next();
+				if (left >= sig.size() || left < 0)
+					error("bit index out of range");
+				sig = sig.extract(left);
+			} else {
+				expect_char(':');
+				int right = expect_int();
+				expect_char(']');
+				if (left >= sig.size() || left < 0 || left < right)
+					error("invalid slice");
+				sig = sig.extract(right, left - right + 1);
+			}
+		}
+		return sig;
+	}
+
+	void parse_attr()
+	{
+		next();
+		RTLIL::IdString name = expect_id();
+		RTLIL::Const value = parse_constant();
+		expect_eol();
+		attrbuf[name] = value;
+	}
+
+	template<typename T>
+	void take_attributes(T *object)
+	{
+		object->attributes.swap(attrbuf);
+		attrbuf.clear();
+	}
+
+	void check_dangling_attributes()
+	{
+		if (!attrbuf.empty())
+			error("dangling attribute");
+	}
+
+	void parse_autoidx()
+	{
+		next();
+		int value = expect_int();
+		expect_eol();
+		autoidx = std::max(autoidx, value);
+	}
+
+	void parse_module()
+	{
+		next();
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		bool delete_module = false;
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!RTLIL_FRONTEND::flag_overwrite && (RTLIL_FRONTEND::flag_lib || (attrbuf.count(ID::blackbox) && attrbuf.at(ID::blackbox).as_bool()))) {
+				log("Ignoring blackbox re-definition of module %s.\n", name.c_str());
+				delete_module = true;
+			} else if (!RTLIL_FRONTEND::flag_nooverwrite && !RTLIL_FRONTEND::flag_overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				error(stringf("RTLIL error: redefinition of module %s.", name.c_str()));
+			} else if (RTLIL_FRONTEND::flag_nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", name.c_str());
+				delete_module = true;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", name.c_str());
+				design->remove(existing_mod);
+			}
+		}
+
+		module = new RTLIL::Module;
+		module->name = name;
+		take_attributes(module);
+		if (!delete_module)
+			design->add(module);
+
+		while (tok != Tok::End) {
+			switch (tok) {
+			case Tok::Parameter: parse_param(); break;
+			case Tok::Attribute: parse_attr(); break;
+			case Tok::Wire: parse_wire(); break;
+			case Tok::Memory: parse_memory(); break;
+			case Tok::Cell: parse_cell(); break;
+			case Tok::Process: parse_process(); break;
+			case Tok::Connect: parse_connect(); break;
+			default: syntax_error();
+			}
+		}
+		next();
+
+		check_dangling_attributes();
+		module->fixup_ports();
+		if (delete_module)
+			delete module;
+		else if (RTLIL_FRONTEND::flag_lib)
+			module->makeblackbox();
+		module = nullptr;
+		expect_eol();
+	}
+
+	void parse_param()
+	{
+		next();
+		RTLIL::IdString name = expect_id();
+		if (tok == Tok::Eol) {
+			expect_eol();
+			module->avail_parameters(name);
+			return;
+		}
+		RTLIL::Const value = parse_constant();
+		expect_eol();
+		module->avail_parameters(name);
+		module->parameter_default_values[name] = value;
+	}
+
+	void parse_wire()
+	{
+		next();
+		int width = 1, start_offset = 0, port_id = 0;
+		bool upto = false, is_signed = false, port_input = false, port_output = false;
+		while (1) {
+			if (tok == Tok::Width) {
+				next();
+				if (tok == Tok::Invalid)
+					error("RTLIL error: invalid wire width");
+				width = expect_int();
+			} else if (tok == Tok::Upto) {
+				next();
+				upto = true;
+			} else if (tok == Tok::Signed) {
+				next();
+				is_signed = true;
+			} else if (tok == Tok::Offset) {
+				next();
+				start_offset = expect_int();
+			} else if (tok == Tok::Input || tok == Tok::Output || tok == Tok::Inout) {
+				port_input = tok != Tok::Output;
+				port_output = tok != Tok::Input;
+				next();
+				port_id = expect_int();
+			} else
+				break;
+		}
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->wire(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of wire %s.", name.c_str()));
+		RTLIL::Wire *wire = module->addWire(name);
+		take_attributes(wire);
+		wire->width = width;
+		wire->start_offset = start_offset;
+		wire->port_id = port_id;
+		wire->port_input = port_input;
+		wire->port_output = port_output;
+		wire->upto = upto;
+		wire->is_signed = is_signed;
+	}
+
+	void parse_memory()
+	{
+		next();
+		RTLIL::Memory *memory = new RTLIL::Memory;
+		take_attributes(memory);
+		while (1) {
+			if (tok == Tok::Width) {
+				next();
+				memory->width = expect_int();
+			} else if (tok == Tok::Size) {
+				next();
+				memory->size = expect_int();
+			} else if (tok == Tok::Offset) {
+				next();
+				memory->start_offset = expect_int();
+			} else
+				break;
+		}
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->memories.count(name) != 0)
+			error(stringf("RTLIL error: redefinition of memory %s.", name.c_str()));
+		memory->name = name;
+		module->memories[name] = memory;
+	}
+
+	void parse_cell()
+	{
+		next();
+		RTLIL::IdString type = expect_id();
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->cell(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of cell %s.", name.c_str()));
+		RTLIL::Cell *cell = module->addCell(name, type);
+		take_attributes(cell);
+
+		while (1) {
+			if (tok == Tok::Parameter) {
+				next();
+				int flags = 0;
+				if (tok == Tok::Signed)
+					flags = RTLIL::CONST_FLAG_SIGNED;
+				else if (tok == Tok::Real)
+					flags = RTLIL::CONST_FLAG_REAL;
+				if (flags)
+					next();
+				RTLIL::IdString param = expect_id();
+				RTLIL::Const value = parse_constant();
+				expect_eol();
+				value.flags |= flags;
+				cell->parameters[param] = value;
+			} else if (tok == Tok::Connect) {
+				next();
+				RTLIL::IdString port = expect_id();
+				RTLIL::SigSpec sig = parse_sigspec();
+				expect_eol();
+				if (cell->hasPort(port))
+					error(stringf("RTLIL error: redefinition of cell port %s.", port.c_str()));
+				cell->setPort(port, std::move(sig));
+			} else
+				break;
+		}
+		expect(Tok::End);
+		expect_eol();
+	}
+
+	void parse_case_body()
+	{
+		while (1) {
+			if (tok == Tok::Attribute)
+				parse_attr();
+			else if (tok == Tok::Switch)
+				parse_switch();
+			else if (tok == Tok::Assign)
+				parse_assign();
+			else
+				break;
+		}
+	}
+
+	void parse_switch()
+	{
+		next();
+		RTLIL::SigSpec signal = parse_sigspec();
+		expect_eol();
+
+		RTLIL::SwitchRule *rule = new RTLIL::SwitchRule;
+		rule->signal = signal;
+		take_attributes(rule);
+		switch_stack.back()->push_back(rule);
+
+		while (tok == Tok::Attribute)
+			parse_attr();
+
+		while (tok == Tok::Case) {
+			next();
+			RTLIL::CaseRule *case_rule = new RTLIL::CaseRule;
+			take_attributes(case_rule);
+			rule->cases.push_back(case_rule);
+			switch_stack.push_back(&case_rule->switches);
+			case_stack.push_back(case_rule);
+
+			if (tok != Tok::Eol && !is_char(','))
+				case_rule->compare.push_back(parse_sigspec());
+			while (is_char(',')) {
+				next();
+				case_rule->compare.push_back(parse_sigspec());
+			}
+			expect_eol();
+			parse_case_body();
+
+			switch_stack.pop_back();
+			case_stack.pop_back();
+		}
+		expect(Tok::End);
+		expect_eol();
+	}
+
+	void parse_assign()
+	{
+		next();
+		RTLIL::SigSpec lhs = parse_sigspec();
+		RTLIL::SigSpec rhs = parse_sigspec();
+		expect_eol();
+		check_dangling_attributes();
+
+		// See https://github.com/YosysHQ/yosys/pull/4765 for discussion on this
+		// warning
+		if (!switch_stack.back()->empty())
+			log_warning("In line %d: %s\n", line,
+				"case rule assign statements after switch statements may cause unexpected behaviour. "
+				"The assign statement is reordered to come before all switch statements.");
+
+		case_stack.back()->actions.push_back(RTLIL::SigSig(lhs, rhs));
+	}
+
+	void parse_process()
+	{
+		next();
+		RTLIL::IdString name = expect_id();
+		expect_eol();
+
+		if (module->processes.count(name) != 0)
+			error(stringf("RTLIL error: redefinition of process %s.", name.c_str()));
+		process = module->addProcess(name);
+		take_attributes(process);
+		switch_stack.clear();
+		switch_stack.push_back(&process->root_case.switches);
+		case_stack.clear();
+		case_stack.push_back(&process->root_case);
+
+		parse_case_body();
+
+		while (tok == Tok::Sync) {
+			next();
+			RTLIL::SyncRule *rule = new RTLIL::SyncRule;
+			process->syncs.push_back(rule);
+			switch (tok) {
+			case Tok::Low: rule->type = RTLIL::ST0; break;
+			case Tok::High: rule->type = RTLIL::ST1; break;
+			case Tok::Posedge: rule->type = RTLIL::STp; break;
+			case Tok::Negedge: rule->type = RTLIL::STn; break;
+			case Tok::Edge: rule->type = RTLIL::STe; break;
+			case Tok::Always: rule->type = RTLIL::STa; break;
+			case Tok::Global: rule->type = RTLIL::STg; break;
+			case Tok::Init: rule->type = RTLIL::STi; break;
+			default: syntax_error();
+			}
+			bool has_signal = tok != Tok::Always && tok != Tok::Global && tok != Tok::Init;
+			next();
+			if (has_signal)
+				rule->signal = parse_sigspec();
+			expect_eol();
+
+			while (1) {
+				if (tok == Tok::Update) {
+					next();
+					RTLIL::SigSpec lhs = parse_sigspec();
+					RTLIL::SigSpec rhs = parse_sigspec();
+					expect_eol();
+					rule->actions.push_back(RTLIL::SigSig(lhs, rhs));
+				} else if (tok == Tok::Attribute || tok == Tok::Memwr) {
+					while (tok == Tok::Attribute)
+						parse_attr();
+					expect(Tok::Memwr);
+					RTLIL::MemWriteAction act;
+					act.memid = expect_id();
+					act.address = parse_sigspec();
+					act.data = parse_sigspec();
+					act.enable = parse_sigspec();
+					act.priority_mask = parse_constant();
+					expect_eol();
+					take_attributes(&act);
+					rule->mem_write_actions.push_back(std::move(act));
+				} else
+					break;
+			}
+		}
+
+		expect(Tok::End);
+		expect_eol();
+		process = nullptr;
+	}
+
+	void parse_connect()
+	{
+		next();
+		RTLIL::SigSpec lhs = parse_sigspec();
+		RTLIL::SigSpec rhs = parse_sigspec();
+		expect_eol();
+		check_dangling_attributes();
+		module->connect(lhs, rhs);
+	}
+
+	void parse()
+	{
+		next();
+		while (tok == Tok::Eol)
+			next();
+		attrbuf.clear();
+
+		while (tok != Tok::Eof) {
+			if (tok == Tok::Module)
+				parse_module();
+			else if (tok == Tok::Attribute)
+				parse_attr();
+			else if (tok == Tok::Autoidx)
+				parse_autoidx();
+			else
+				syntax_error();
+		}
+		check_dangling_attributes();
+	}
+};
+
+}
+
+void RTLIL_FRONTEND::parse_rtlil(const char *data, size_t size, RTLIL::Design *design)
+{
+	RTLILReader reader(data, size, design);
+	reader.parse();
+}
+
+YOSYS_NAMESPACE_END
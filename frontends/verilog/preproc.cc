@@ -40,45 +40,58 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
 
 YOSYS_NAMESPACE_BEGIN
 using namespace VERILOG_FRONTEND;
 
 static std::list<std::string> output_code;
-static std::list<std::string> input_buffer;
-static size_t input_buffer_charp;
+
+// The remaining input as a stack of strings, the back is read first. Text
+// is spliced in by pushing a new entry, so the rest of the input is never
+// copied. Included files share their cached contents, see below.
+struct input_chunk_t
+{
+	std::shared_ptr<const std::string> text;
+	size_t pos;
+};
+
+static std::vector<input_chunk_t> input_buffer;
 
 static void return_char(char ch)
 {
-	if (input_buffer_charp == 0)
-		input_buffer.push_front(std::string() + ch);
-	else
-		input_buffer.front()[--input_buffer_charp] = ch;
+	if (!input_buffer.empty()) {
+		input_chunk_t &chunk = input_buffer.back();
+		if (chunk.pos > 0 && (*chunk.text)[chunk.pos - 1] == ch) {
+			chunk.pos--;
+			return;
+		}
+	}
+	input_buffer.push_back({std::make_shared<const std::string>(1, ch), 0});
 }
 
 static void insert_input(std::string str)
 {
-	if (input_buffer_charp != 0) {
-		input_buffer.front() = input_buffer.front().substr(input_buffer_charp);
-		input_buffer_charp = 0;
-	}
-	input_buffer.push_front(str);
+	if (!str.empty())
+		input_buffer.push_back({std::make_shared<const std::string>(std::move(str)), 0});
 }
 
 static char next_char()
 {
-	if (input_buffer.empty())
-		return 0;
-
-	log_assert(input_buffer_charp <= input_buffer.front().size());
-	if (input_buffer_charp == input_buffer.front().size()) {
-		input_buffer_charp = 0;
-		input_buffer.pop_front();
-		return next_char();
+	while (!input_buffer.empty()) {
+		input_chunk_t &chunk = input_buffer.back();
+		if (chunk.pos == chunk.text->size()) {
+			input_buffer.pop_back();
+			continue;
+		}
+		char ch = (*chunk.text)[chunk.pos++];
+		if (ch != '\r')
+			return ch;
 	}
-
-	char ch = input_buffer.front()[input_buffer_charp++];
-	return ch == '\r' ? next_char() : ch;
+	return 0;
 }
 
 static std::string skip_spaces()
@@ -385,20 +398,310 @@ void define_map_t::log() const
 	}
 }
 
-static void input_file(std::istream &f, std::string filename)
+static void input_file(const std::shared_ptr<const std::string> &text, std::string filename)
 {
-	char buffer[513];
+	insert_input("\n`file_pop\n");
+	input_buffer.push_back({text, 0});
+	insert_input("`file_push \"" + filename + "\"\n");
+}
+
+static std::shared_ptr<const std::string> read_input(std::istream &f)
+{
+	std::string text;
+	char buffer[65536];
 	int rc;
+	while ((rc = readsome(f, buffer, sizeof(buffer))) > 0)
+		text.append(buffer, rc);
+	return std::make_shared<const std::string>(std::move(text));
+}
+
+// Cache of `include lookups for the rest of the session. Resolved paths are
+// keyed on everything the search depends on. The contents of include files
+// are reused as long as their stat() data doesn't change, see FileStamp. Paths
+// that could not be resolved are not cached, and a file created later in a
+// directory that is searched earlier than the cached result is not noticed.
+struct include_cache_t
+{
+	struct contents_t {
+		std::shared_ptr<const std::string> text;
+		FileStamp stamp;
+		// include guard, see find_include_guard()
+		bool guard_checked = false;
+		std::string guard;
+		std::shared_ptr<const std::string> skipped_text;
+	};
+
+	dict<std::string, std::string> paths;
+	dict<std::string, contents_t> contents;
+	bool paths_changed = false;
+	pool<std::string> loaded_files;
+
+	static std::string lookup_key(const std::string &fn, const std::string &filename, const std::list<std::string> &include_dirs)
+	{
+		std::string key = fn;
+		key += '\n';
+		key += filename.substr(0, filename.find_last_of(
+#ifdef _WIN32
+				"/\\"
+#else
+				"/"
+#endif
+				) + 1);
+		for (auto &dir : include_dirs) {
+			key += '\n';
+			key += dir;
+		}
+		// relative names are also looked up in the working directory
+		char cwd[PATH_MAX];
+		if (getcwd(cwd, sizeof(cwd)) != nullptr) {
+			key += '\n';
+			key += cwd;
+		}
+		return key;
+	}
+
+	// Returns the contents of path, or null if it can't be read
+	std::shared_ptr<const std::string> read(const std::string &path)
+	{
+		FileStamp stamp;
+		if (!stamp.read(path))
+			return nullptr;
+		contents_t &entry = contents[path];
+		if (entry.text == nullptr || entry.stamp.racy() || stamp.size < 0 || entry.stamp != stamp) {
+			std::ifstream ff(path, std::ifstream::binary);
+			if (ff.fail()) {
+				contents.erase(path);
+				return nullptr;
+			}
+			entry.text = read_input(ff);
+			entry.stamp = stamp;
+			entry.guard_checked = false;
+		}
+		return entry.text;
+	}
+
+	// Returns text to use instead of the contents of path if the file has
+	// an include guard that is already defined, or null
+	std::shared_ptr<const std::string> skipped_text(const std::string &path, const define_map_t &defines);
+};
+
+static include_cache_t include_cache;
+
+static bool blank_token(const std::string &tok)
+{
+	if (tok.empty())
+		return false;
+	// "//" comments are also turned into "/* ... */"
+	return tok[0] == ' ' || tok[0] == '\t' || tok[0] == '\n' || tok.compare(0, 2, "/*") == 0;
+}
+
+// Checks whether a file consists of a single `ifndef NAME ... `endif block
+// with only whitespace and comments around it. If so, returns NAME and sets
+// skipped_text to text that the main loop turns into the same output as the
+// file when NAME is defined: the surrounding comments and the newlines from
+// the skipped block. The tokens are read like in the main loop, which lets
+// headers included many times be skipped without tokenizing them again.
+static std::string find_include_guard(const std::shared_ptr<const std::string> &text, std::shared_ptr<const std::string> &skipped_text)
+{
+	std::vector<input_chunk_t> saved_input;
+	std::list<std::string> saved_output;
+	std::swap(input_buffer, saved_input);
+	std::swap(output_code, saved_output);
+	input_buffer.push_back({text, 0});
+
+	// offset of the next token in text, if nothing was pushed back
+	auto offset = []() {
+		return GetSize(input_buffer) == 1 ? input_buffer.back().pos : std::string::npos;
+	};
+
+	std::string guard, tok;
+	size_t guard_begin, guard_end = std::string::npos;
+	do {
+		guard_begin = offset();
+		tok = next_token();
+	} while (blank_token(tok));
+
+	if (tok == "`ifndef" && guard_begin != std::string::npos) {
+		skip_spaces();
+		guard = next_token(true);
+		int fail_level = 1;
+		while (fail_level > 0) {
+			tok = next_token();
+			if (tok.empty())
+				break;
+			if (tok == "`endif") {
+				fail_level--;
+			} else if (tok == "`else" || tok == "`elsif") {
+				if (fail_level == 1)
+					break;
+				if (tok == "`elsif") {
+					skip_spaces();
+					next_token(true);
+				}
+			} else if (tok == "`ifdef" || tok == "`ifndef") {
+				skip_spaces();
+				next_token(true);
+				fail_level++;
+			} else if (tok == "\n") {
+				output_code.push_back(tok);
+			}
+		}
+		if (fail_level == 0) {
+			guard_end = offset();
+			do {
+				tok = next_token();
+			} while (blank_token(tok));
+		}
+	}
+
+	if (guard.empty() || guard_end == std::string::npos || !tok.empty()) {
+		guard.clear();
+	} else {
+		std::string skipped = text->substr(0, guard_begin);
+		for (auto &str : output_code)
+			skipped += str;
+		skipped += text->substr(guard_end);
+		skipped_text = std::make_shared<const std::string>(std::move(skipped));
+	}
+
+	std::swap(input_buffer, saved_input);
+	std::swap(output_code, saved_output);
+	return guard;
+}
+
+std::shared_ptr<const std::string> include_cache_t::skipped_text(const std::string &path, const define_map_t &defines)
+{
+	auto it = contents.find(path);
+	if (it == contents.end())
+		return nullptr;
+	contents_t &entry = it->second;
+	if (!entry.guard_checked) {
+		entry.guard = find_include_guard(entry.text, entry.skipped_text);
+		entry.guard_checked = true;
+	}
+	if (entry.guard.empty() || !defines.find(entry.guard))
+		return nullptr;
+	return entry.skipped_text;
+}
+
+// Searches for an `include file and reads it, see include_cache_t
+static std::shared_ptr<const std::string> find_include(const std::string &fn, const std::string &filename,
+		const std::list<std::string> &include_dirs, std::string &fixed_fn)
+{
+	std::string key = include_cache_t::lookup_key(fn, filename, include_dirs);
+	auto it = include_cache.paths.find(key);
+	if (it != include_cache.paths.end()) {
+		fixed_fn = it->second;
+		if (auto text = include_cache.read(fixed_fn))
+			return text;
+		include_cache.paths.erase(it);
+	}
+
+	fixed_fn = fn;
+	std::shared_ptr<const std::string> text = include_cache.read(fixed_fn);
+
+	bool filename_path_sep_found;
+	bool fn_relative;
+#ifdef _WIN32
+	// Both forward and backslash are acceptable separators on Windows.
+	filename_path_sep_found = (filename.find_first_of("/\\") != std::string::npos);
+	// Easier just to invert the check for an absolute path (e.g. C:\ or C:/)
+	fn_relative = !(fn[1] == ':' && (fn[2] == '/' || fn[2] == '\\'));
+#else
+	filename_path_sep_found = (filename.find('/') != std::string::npos);
+	fn_relative = (fn[0] != '/');
+#endif
+
+	if (!text && fn.size() > 0 && fn_relative && filename_path_sep_found) {
+		// if the include file was not found, it is not given with an absolute path, and the
+		// currently read file is given with a path, then try again relative to its directory
+#ifdef _WIN32
+		fixed_fn = filename.substr(0, filename.find_last_of("/\\")+1) + fn;
+#else
+		fixed_fn = filename.substr(0, filename.rfind('/')+1) + fn;
+#endif
+		text = include_cache.read(fixed_fn);
+	}
+	if (!text && fn.size() > 0 && fn_relative) {
+		// if the include file was not found and it is not given with an absolute path, then
+		// search it in the include path
+		for (auto incdir : include_dirs) {
+			fixed_fn = incdir + '/' + fn;
+			text = include_cache.read(fixed_fn);
+			if (text) break;
+		}
+	}
+
+	if (text) {
+		include_cache.paths[key] = fixed_fn;
+		include_cache.paths_changed = true;
+	}
+	return text;
+}
 
-	insert_input("");
-	auto it = input_buffer.begin();
+static std::string escape_cache_line(const std::string &str)
+{
+	std::string escaped;
+	for (char c : str) {
+		if (c == '\\')
+			escaped += "\\\\";
+		else if (c == '\n')
+			escaped += "\\n";
+		else
+			escaped += c;
+	}
+	return escaped;
+}
+
+static std::string unescape_cache_line(const std::string &str)
+{
+	std::string unescaped;
+	for (size_t i = 0; i < str.size(); i++) {
+		if (str[i] == '\\' && i + 1 < str.size())
+			unescaped += str[++i] == 'n' ? '\n' : str[i];
+		else
+			unescaped += str[i];
+	}
+	return unescaped;
+}
+
+static const char *include_cache_magic = "yosys-verilog-include-cache 1";
+
+void frontend_verilog_load_include_cache(const std::string &filename)
+{
+	if (!include_cache.loaded_files.insert(filename).second)
+		return;
+	std::ifstream f(filename);
+	std::string line, key;
+	if (f.fail() || !std::getline(f, line) || line != include_cache_magic)
+		return;
+	int count = 0;
+	while (std::getline(f, key) && std::getline(f, line)) {
+		key = unescape_cache_line(key);
+		if (!include_cache.paths.count(key)) {
+			include_cache.paths[key] = unescape_cache_line(line);
+			count++;
+		}
+	}
+	log("Loaded %d include paths from `%s'.\n", count, filename.c_str());
+}
 
-	input_buffer.insert(it, "`file_push \"" + filename + "\"\n");
-	while ((rc = readsome(f, buffer, sizeof(buffer)-1)) > 0) {
-		buffer[rc] = 0;
-		input_buffer.insert(it, buffer);
+void frontend_verilog_save_include_cache(const std::string &filename)
+{
+	if (!include_cache.paths_changed)
+		return;
+	std::string temp_filename = filename + ".tmp";
+	std::ofstream f(temp_filename);
+	f << include_cache_magic << "\n";
+	for (auto &it : include_cache.paths)
+		f << escape_cache_line(it.first) << "\n" << escape_cache_line(it.second) << "\n";
+	f.close();
+	if (f.fail() || rename(temp_filename.c_str(), filename.c_str()) != 0) {
+		remove(temp_filename.c_str());
+		log_warning("Can't write include cache `%s'.\n", filename.c_str());
+		return;
 	}
-	input_buffer.insert(it, "\n`file_pop\n");
+	include_cache.paths_changed = false;
 }
 
 // Read tokens to get one argument (either a macro argument at a callsite or a default argument in a
@@ -771,9 +1074,8 @@ frontend_verilog_preproc(std::istream                 &f,
 
 	output_code.clear();
 	input_buffer.clear();
-	input_buffer_charp = 0;
 
-	input_file(f, filename);
+	input_file(read_input(f), filename);
 
 	while (!input_buffer.empty())
 	{
@@ -871,48 +1173,14 @@ frontend_verilog_preproc(std::istream                 &f,
 				else
 					fn = fn.substr(0, pos) + fn.substr(pos+1);
 			}
-			std::ifstream ff;
-			ff.clear();
-			std::string fixed_fn = fn;
-			ff.open(fixed_fn.c_str());
-
-			bool filename_path_sep_found;
-			bool fn_relative;
-#ifdef _WIN32
-			// Both forward and backslash are acceptable separators on Windows.
-			filename_path_sep_found = (filename.find_first_of("/\\") != std::string::npos);
-			// Easier just to invert the check for an absolute path (e.g. C:\ or C:/)
-			fn_relative = !(fn[1] == ':' && (fn[2] == '/' || fn[2] == '\\'));
-#else
-			filename_path_sep_found = (filename.find('/') != std::string::npos);
-			fn_relative = (fn[0] != '/');
-#endif
-
-			if (ff.fail() && fn.size() > 0 && fn_relative && filename_path_sep_found) {
-				// if the include file was not found, it is not given with an absolute path, and the
-				// currently read file is given with a path, then try again relative to its directory
-				ff.clear();
-#ifdef _WIN32
-				fixed_fn = filename.substr(0, filename.find_last_of("/\\")+1) + fn;
-#else
-				fixed_fn = filename.substr(0, filename.rfind('/')+1) + fn;
-#endif
-				ff.open(fixed_fn);
-			}
-			if (ff.fail() && fn.size() > 0 && fn_relative) {
-				// if the include file was not found and it is not given with an absolute path, then
-				// search it in the include path
-				for (auto incdir : include_dirs) {
-					ff.clear();
-					fixed_fn = incdir + '/' + fn;
-					ff.open(fixed_fn);
-					if (!ff.fail()) break;
-				}
-			}
-			if (ff.fail()) {
+			std::string fixed_fn;
+			std::shared_ptr<const std::string> text = find_include(fn, filename, include_dirs, fixed_fn);
+			if (text == nullptr) {
 				output_code.push_back("`file_notfound " + fn);
 			} else {
-				input_file(ff, fixed_fn);
+				if (auto skipped = include_cache.skipped_text(fixed_fn, defines))
+					text = skipped;
+				input_file(text, fixed_fn);
 				yosys_input_files.insert(fixed_fn);
 			}
 			continue;
@@ -992,7 +1260,6 @@ frontend_verilog_preproc(std::istream                 &f,
 
 	output_code.clear();
 	input_buffer.clear();
-	input_buffer_charp = 0;
 
 	return output;
 }
@@ -73,6 +73,11 @@ frontend_verilog_preproc(std::istream                 &f,
                          define_map_t                 &global_defines_cache,
                          const std::list<std::string> &include_dirs);
 
+// Resolved `include paths are cached for the rest of the session, these
+// load them from and store them to a file for later runs
+void frontend_verilog_load_include_cache(const std::string &filename);
+void frontend_verilog_save_include_cache(const std::string &filename);
+
 YOSYS_NAMESPACE_END
 
 #endif
@@ -225,6 +225,12 @@ struct VerilogFrontend : public Frontend {
 		log("        add 'dir' to the directories which are used when searching include\n");
 		log("        files\n");
 		log("\n");
+		log("    -inccache <file>\n");
+		log("        load resolved include file paths from the given file and store them\n");
+		log("        there afterwards, so that later runs don't need to search the include\n");
+		log("        directories again. Within one session include lookups and the\n");
+		log("        contents of unchanged include files are always cached.\n");
+		log("\n");
 		log("The command 'verilog_defaults' can be used to register default options for\n");
 		log("subsequent calls to 'read_verilog'.\n");
 		log("\n");
@@ -269,6 +275,7 @@ struct VerilogFrontend : public Frontend {
 		define_map_t defines_map;
 
 		std::list<std::string> include_dirs;
+		std::string include_cache_file;
 		std::list<std::string> attributes;
 
 		frontend_verilog_yydebug = false;
@@ -466,6 +473,10 @@ struct VerilogFrontend : public Frontend {
 				include_dirs.push_back(arg.substr(2));
 				continue;
 			}
+			if (arg == "-inccache" && argidx+1 < args.size()) {
+				include_cache_file = args[++argidx];
+				continue;
+			}
 			break;
 		}
 
@@ -489,7 +500,11 @@ struct VerilogFrontend : public Frontend {
 		std::string code_after_preproc;
 
 		if (!flag_nopp) {
+			if (!include_cache_file.empty())
+				frontend_verilog_load_include_cache(include_cache_file);
 			code_after_preproc = frontend_verilog_preproc(*f, filename, defines_map, *design->verilog_defines, include_dirs);
+			if (!include_cache_file.empty())
+				frontend_verilog_save_include_cache(include_cache_file);
 			if (flag_ppdump)
 				log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
 			lexin = new std::istringstream(code_after_preproc);
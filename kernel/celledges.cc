@@ -388,67 +388,65 @@ void ff_op(AbstractCellEdgesDatabase *db, RTLIL::Cell *cell)
 			db->add_edge(cell, ID::ARST, 0, ID::Q, k, -1);
 }
 
-PRIVATE_NAMESPACE_END
-
-bool YOSYS_NAMESPACE_PREFIX AbstractCellEdgesDatabase::add_edges_from_cell(RTLIL::Cell *cell)
+bool add_builtin_edges(AbstractCellEdgesDatabase *db, RTLIL::Cell *cell)
 {
 	if (cell->type.in(ID($not), ID($pos), ID($buf))) {
-		bitwise_unary_op(this, cell);
+		bitwise_unary_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor))) {
-		bitwise_binary_op(this, cell);
+		bitwise_binary_op(db, cell);
 		return true;
 	}
 
 	if (cell->type == ID($neg)) {
-		arith_neg_op(this, cell);
+		arith_neg_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($add), ID($sub))) {
-		arith_binary_op(this, cell);
+		arith_binary_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool), ID($logic_not))) {
-		reduce_op(this, cell);
+		reduce_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx))) {
-		shift_op(this, cell);
+		shift_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($lt), ID($le), ID($eq), ID($ne), ID($eqx), ID($nex), ID($ge), ID($gt))) {
-		compare_op(this, cell);
+		compare_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($mux), ID($pmux))) {
-		mux_op(this, cell);
+		mux_op(db, cell);
 		return true;
 	}
 
 	if (cell->type == ID($bmux)) {
-		bmux_op(this, cell);
+		bmux_op(db, cell);
 		return true;
 	}
 
 	if (cell->type == ID($demux)) {
-		demux_op(this, cell);
+		demux_op(db, cell);
 		return true;
 	}
 
 	if (cell->type.in(ID($mem_v2), ID($memrd), ID($memrd_v2), ID($memwr), ID($memwr_v2), ID($meminit))) {
-		mem_op(this, cell);
+		mem_op(db, cell);
 		return true;
 	}
 
 	if (RTLIL::builtin_ff_cell_types().count(cell->type)) {
-		ff_op(this, cell);
+		ff_op(db, cell);
 		return true;
 	}
 
@@ -469,3 +467,51 @@ bool YOSYS_NAMESPACE_PREFIX AbstractCellEdgesDatabase::add_edges_from_cell(RTLIL
 	return false;
 }
 
+struct RecordingCellEdgesDatabase : AbstractCellEdgesDatabase
+{
+	std::vector<EdgeTemplate> edges;
+
+	void add_edge(RTLIL::Cell *, RTLIL::IdString from_port, int from_bit, RTLIL::IdString to_port, int to_bit, int delay) override {
+		edges.push_back({from_port, from_bit, to_port, to_bit, delay});
+	}
+};
+
+PRIVATE_NAMESPACE_END
+
+bool YOSYS_NAMESPACE_PREFIX AbstractCellEdgesDatabase::add_edges_from_cell(RTLIL::Cell *cell)
+{
+	// only built-in cell types have known edges
+	if (!cell->type.begins_with("$"))
+		return false;
+
+	std::vector<std::pair<RTLIL::IdString, int>> port_widths;
+	port_widths.reserve(cell->connections().size());
+	for (auto const &conn : cell->connections())
+		port_widths.emplace_back(conn.first, GetSize(conn.second));
+	std::sort(port_widths.begin(), port_widths.end(), [](auto const &a, auto const &b) {
+		return a.first < b.first;
+	});
+
+	// all parameters read by add_builtin_edges() besides the port widths
+	static const RTLIL::IdString edge_params[] = {
+		ID::A_SIGNED, ID::B_SIGNED, ID::WIDTH, ID::ABITS, ID::RD_PORTS, ID::CLK_ENABLE, ID::RD_CLK_ENABLE
+	};
+	std::vector<RTLIL::Const> parameters;
+	for (auto param : edge_params) {
+		auto it = cell->parameters.find(param);
+		parameters.push_back(it != cell->parameters.end() ? it->second : RTLIL::Const());
+	}
+
+	EdgeTemplateKey key{cell->type, std::move(port_widths), std::move(parameters)};
+	auto found = edge_templates.find(key);
+	if (found == edge_templates.end()) {
+		RecordingCellEdgesDatabase recorder;
+		if (!add_builtin_edges(&recorder, cell))
+			return false;
+		found = edge_templates.emplace(std::move(key), std::move(recorder.edges)).first;
+	}
+
+	for (auto const &edge : found->second)
+		add_edge(cell, edge.from_port, edge.from_bit, edge.to_port, edge.to_bit, edge.delay);
+	return true;
+}
@@ -30,6 +30,43 @@ struct AbstractCellEdgesDatabase
 	virtual ~AbstractCellEdgesDatabase() { }
 	virtual void add_edge(RTLIL::Cell *cell, RTLIL::IdString from_port, int from_bit, RTLIL::IdString to_port, int to_bit, int delay) = 0;
 	bool add_edges_from_cell(RTLIL::Cell *cell);
+
+protected:
+	struct EdgeTemplate
+	{
+		RTLIL::IdString from_port;
+		int from_bit;
+		RTLIL::IdString to_port;
+		int to_bit;
+		int delay;
+	};
+
+	// The edges of a built-in cell only depend on its type, its port widths
+	// and the signedness and memory layout parameters. add_edges_from_cell()
+	// generates them once per such shape and replays them for every cell of
+	// that shape added to this database.
+	struct EdgeTemplateKey
+	{
+		RTLIL::IdString type;
+		std::vector<std::pair<RTLIL::IdString, int>> port_widths;
+		std::vector<RTLIL::Const> parameters;
+
+		bool operator==(const EdgeTemplateKey &other) const {
+			return type == other.type && port_widths == other.port_widths && parameters == other.parameters;
+		}
+		[[nodiscard]] Hasher hash_into(Hasher h) const {
+			h.eat(type);
+			for (auto const &it : port_widths) {
+				h.eat(it.first);
+				h.eat(it.second);
+			}
+			for (auto const &it : parameters)
+				h.eat(it);
+			return h;
+		}
+	};
+
+	dict<EdgeTemplateKey, std::vector<EdgeTemplate>> edge_templates;
 };
 
 struct FwdCellEdgesDatabase : AbstractCellEdgesDatabase
@@ -0,0 +1,334 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+const BuiltinCellTypes &BuiltinCellTypes::get()
+{
+	// never destroyed, CellTypes objects with static storage duration may
+	// still refer to it during shutdown
+	static const BuiltinCellTypes *table = new BuiltinCellTypes;
+	return *table;
+}
+
+void BuiltinCellTypes::begin_group(Group group)
+{
+	current_group = group;
+	group_begin[group] = GetSize(entries);
+	group_end[group] = GetSize(entries);
+}
+
+int BuiltinCellTypes::port_bit(RTLIL::IdString port)
+{
+	int idx = find_port(port);
+	if (idx >= 0)
+		return idx;
+	idx = GetSize(ports);
+	log_assert(idx < 64);
+	ports.push_back(port);
+	if (port.index_ >= GetSize(port_by_index))
+		port_by_index.resize(port.index_ + 1, -1);
+	port_by_index[port.index_] = idx;
+	return idx;
+}
+
+void BuiltinCellTypes::add(RTLIL::IdString type, const pool<RTLIL::IdString> &inputs, const pool<RTLIL::IdString> &outputs, bool is_evaluable)
+{
+	log_assert(find_entry(type) < 0);
+
+	Entry entry;
+	entry.info = {type, inputs, outputs, is_evaluable, false, false};
+	entry.inputs = 0;
+	entry.outputs = 0;
+	for (auto port : inputs)
+		entry.inputs |= uint64_t(1) << port_bit(port);
+	for (auto port : outputs)
+		entry.outputs |= uint64_t(1) << port_bit(port);
+
+	if (type.index_ >= GetSize(entry_by_index))
+		entry_by_index.resize(type.index_ + 1, -1);
+	entry_by_index[type.index_] = GetSize(entries);
+	entries.push_back(std::move(entry));
+	group_end[current_group] = GetSize(entries);
+}
+
+BuiltinCellTypes::BuiltinCellTypes()
+{
+	// the ID:: constants used below are only valid after yosys_setup()
+	log_assert(ID::A != RTLIL::IdString());
+
+	begin_group(INTERNALS_EVAL);
+	std::vector<RTLIL::IdString> unary_ops = {
+		ID($not), ID($pos), ID($buf), ID($neg),
+		ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
+		ID($logic_not), ID($slice), ID($lut), ID($sop)
+	};
+
+	std::vector<RTLIL::IdString> binary_ops = {
+		ID($and), ID($or), ID($xor), ID($xnor),
+		ID($shl), ID($shr), ID($sshl), ID($sshr), ID($shift), ID($shiftx),
+		ID($lt), ID($le), ID($eq), ID($ne), ID($eqx), ID($nex), ID($ge), ID($gt),
+		ID($add), ID($sub), ID($mul), ID($div), ID($mod), ID($divfloor), ID($modfloor), ID($pow),
+		ID($logic_and), ID($logic_or), ID($concat), ID($macc),
+		ID($bweqx)
+	};
+
+	for (auto type : unary_ops)
+		add(type, {ID::A}, {ID::Y}, true);
+
+	for (auto type : binary_ops)
+		add(type, {ID::A, ID::B}, {ID::Y}, true);
+
+	for (auto type : std::vector<RTLIL::IdString>({ID($mux), ID($pmux), ID($bwmux)}))
+		add(type, {ID::A, ID::B, ID::S}, {ID::Y}, true);
+
+	for (auto type : std::vector<RTLIL::IdString>({ID($bmux), ID($demux)}))
+		add(type, {ID::A, ID::S}, {ID::Y}, true);
+
+	add(ID($lcu), {ID::P, ID::G, ID::CI}, {ID::CO}, true);
+	add(ID($alu), {ID::A, ID::B, ID::CI, ID::BI}, {ID::X, ID::Y, ID::CO}, true);
+	add(ID($macc_v2), {ID::A, ID::B, ID::C}, {ID::Y}, true);
+	add(ID($fa), {ID::A, ID::B, ID::C}, {ID::X, ID::Y}, true);
+
+	begin_group(INTERNALS_OTHER);
+	add(ID($tribuf), {ID::A, ID::EN}, {ID::Y}, true);
+
+	add(ID($assert), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
+	add(ID($assume), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
+	add(ID($live), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
+	add(ID($fair), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
+	add(ID($cover), {ID::A, ID::EN}, pool<RTLIL::IdString>(), true);
+	add(ID($initstate), pool<RTLIL::IdString>(), {ID::Y}, true);
+	add(ID($anyconst), pool<RTLIL::IdString>(), {ID::Y}, true);
+	add(ID($anyseq), pool<RTLIL::IdString>(), {ID::Y}, true);
+	add(ID($allconst), pool<RTLIL::IdString>(), {ID::Y}, true);
+	add(ID($allseq), pool<RTLIL::IdString>(), {ID::Y}, true);
+	add(ID($equiv), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($specify2), {ID::EN, ID::SRC, ID::DST}, pool<RTLIL::IdString>(), true);
+	add(ID($specify3), {ID::EN, ID::SRC, ID::DST, ID::DAT}, pool<RTLIL::IdString>(), true);
+	add(ID($specrule), {ID::EN_SRC, ID::EN_DST, ID::SRC, ID::DST}, pool<RTLIL::IdString>(), true);
+	add(ID($print), {ID::EN, ID::ARGS, ID::TRG}, pool<RTLIL::IdString>());
+	add(ID($check), {ID::A, ID::EN, ID::ARGS, ID::TRG}, pool<RTLIL::IdString>());
+	add(ID($set_tag), {ID::A, ID::SET, ID::CLR}, {ID::Y});
+	add(ID($get_tag), {ID::A}, {ID::Y});
+	add(ID($overwrite_tag), {ID::A, ID::SET, ID::CLR}, pool<RTLIL::IdString>());
+	add(ID($original_tag), {ID::A}, {ID::Y});
+	add(ID($future_ff), {ID::A}, {ID::Y});
+	add(ID($scopeinfo), {}, {});
+
+	begin_group(INTERNALS_FF);
+	add(ID($sr), {ID::SET, ID::CLR}, {ID::Q});
+	add(ID($ff), {ID::D}, {ID::Q});
+	add(ID($dff), {ID::CLK, ID::D}, {ID::Q});
+	add(ID($dffe), {ID::CLK, ID::EN, ID::D}, {ID::Q});
+	add(ID($dffsr), {ID::CLK, ID::SET, ID::CLR, ID::D}, {ID::Q});
+	add(ID($dffsre), {ID::CLK, ID::SET, ID::CLR, ID::D, ID::EN}, {ID::Q});
+	add(ID($adff), {ID::CLK, ID::ARST, ID::D}, {ID::Q});
+	add(ID($adffe), {ID::CLK, ID::ARST, ID::D, ID::EN}, {ID::Q});
+	add(ID($aldff), {ID::CLK, ID::ALOAD, ID::AD, ID::D}, {ID::Q});
+	add(ID($aldffe), {ID::CLK, ID::ALOAD, ID::AD, ID::D, ID::EN}, {ID::Q});
+	add(ID($sdff), {ID::CLK, ID::SRST, ID::D}, {ID::Q});
+	add(ID($sdffe), {ID::CLK, ID::SRST, ID::D, ID::EN}, {ID::Q});
+	add(ID($sdffce), {ID::CLK, ID::SRST, ID::D, ID::EN}, {ID::Q});
+	add(ID($dlatch), {ID::EN, ID::D}, {ID::Q});
+	add(ID($adlatch), {ID::EN, ID::D, ID::ARST}, {ID::Q});
+	add(ID($dlatchsr), {ID::EN, ID::SET, ID::CLR, ID::D}, {ID::Q});
+
+	begin_group(INTERNALS_MEM);
+	add(ID($memrd), {ID::CLK, ID::EN, ID::ADDR}, {ID::DATA});
+	add(ID($memrd_v2), {ID::CLK, ID::EN, ID::ARST, ID::SRST, ID::ADDR}, {ID::DATA});
+	add(ID($memwr), {ID::CLK, ID::EN, ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
+	add(ID($memwr_v2), {ID::CLK, ID::EN, ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
+	add(ID($meminit), {ID::ADDR, ID::DATA}, pool<RTLIL::IdString>());
+	add(ID($meminit_v2), {ID::ADDR, ID::DATA, ID::EN}, pool<RTLIL::IdString>());
+	add(ID($mem), {ID::RD_CLK, ID::RD_EN, ID::RD_ADDR, ID::WR_CLK, ID::WR_EN, ID::WR_ADDR, ID::WR_DATA}, {ID::RD_DATA});
+	add(ID($mem_v2), {ID::RD_CLK, ID::RD_EN, ID::RD_ARST, ID::RD_SRST, ID::RD_ADDR, ID::WR_CLK, ID::WR_EN, ID::WR_ADDR, ID::WR_DATA}, {ID::RD_DATA});
+
+	add(ID($fsm), {ID::CLK, ID::ARST, ID::CTRL_IN}, {ID::CTRL_OUT});
+
+	begin_group(INTERNALS_ANYINIT);
+	add(ID($anyinit), {ID::D}, {ID::Q});
+
+	begin_group(STDCELLS_EVAL);
+	add(ID($_BUF_), {ID::A}, {ID::Y}, true);
+	add(ID($_NOT_), {ID::A}, {ID::Y}, true);
+	add(ID($_AND_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_NAND_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_OR_),  {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_NOR_),  {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_XOR_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_XNOR_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_ANDNOT_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_ORNOT_), {ID::A, ID::B}, {ID::Y}, true);
+	add(ID($_MUX_), {ID::A, ID::B, ID::S}, {ID::Y}, true);
+	add(ID($_NMUX_), {ID::A, ID::B, ID::S}, {ID::Y}, true);
+	add(ID($_MUX4_), {ID::A, ID::B, ID::C, ID::D, ID::S, ID::T}, {ID::Y}, true);
+	add(ID($_MUX8_), {ID::A, ID::B, ID::C, ID::D, ID::E, ID::F, ID::G, ID::H, ID::S, ID::T, ID::U}, {ID::Y}, true);
+	add(ID($_MUX16_), {ID::A, ID::B, ID::C, ID::D, ID::E, ID::F, ID::G, ID::H, ID::I, ID::J, ID::K, ID::L, ID::M, ID::N, ID::O, ID::P, ID::S, ID::T, ID::U, ID::V}, {ID::Y}, true);
+	add(ID($_AOI3_), {ID::A, ID::B, ID::C}, {ID::Y}, true);
+	add(ID($_OAI3_), {ID::A, ID::B, ID::C}, {ID::Y}, true);
+	add(ID($_AOI4_), {ID::A, ID::B, ID::C, ID::D}, {ID::Y}, true);
+	add(ID($_OAI4_), {ID::A, ID::B, ID::C, ID::D}, {ID::Y}, true);
+
+	begin_group(STDCELLS_OTHER);
+	add(ID($_TBUF_), {ID::A, ID::E}, {ID::Y}, true);
+
+	begin_group(STDCELLS_MEM);
+	std::vector<char> list_np = {'N', 'P'}, list_01 = {'0', '1'};
+
+	// e.g. name("$_DFFE_", {'P', 'N', '0', 'P'}) is "$_DFFE_PN0P_"
+	auto name = [](const char *prefix, std::initializer_list<char> suffix) {
+		std::string str = prefix;
+		str.append(suffix.begin(), suffix.end());
+		str += '_';
+		return str;
+	};
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+		add(name("$_SR_", {c1, c2}), {ID::S, ID::R}, {ID::Q});
+
+	add(ID($_FF_), {ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+		add(name("$_DFF_", {c1}), {ID::C, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+		add(name("$_DFFE_", {c1, c2}), {ID::C, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+		add(name("$_DFF_", {c1, c2, c3}), {ID::C, ID::R, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+	for (auto c4 : list_np)
+		add(name("$_DFFE_", {c1, c2, c3, c4}), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+		add(name("$_ALDFF_", {c1, c2}), {ID::C, ID::L, ID::AD, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_np)
+		add(name("$_ALDFFE_", {c1, c2, c3}), {ID::C, ID::L, ID::AD, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_np)
+		add(name("$_DFFSR_", {c1, c2, c3}), {ID::C, ID::S, ID::R, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_np)
+	for (auto c4 : list_np)
+		add(name("$_DFFSRE_", {c1, c2, c3, c4}), {ID::C, ID::S, ID::R, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+		add(name("$_SDFF_", {c1, c2, c3}), {ID::C, ID::R, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+	for (auto c4 : list_np)
+		add(name("$_SDFFE_", {c1, c2, c3, c4}), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+	for (auto c4 : list_np)
+		add(name("$_SDFFCE_", {c1, c2, c3, c4}), {ID::C, ID::R, ID::D, ID::E}, {ID::Q});
+
+	for (auto c1 : list_np)
+		add(name("$_DLATCH_", {c1}), {ID::E, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_01)
+		add(name("$_DLATCH_", {c1, c2, c3}), {ID::E, ID::R, ID::D}, {ID::Q});
+
+	for (auto c1 : list_np)
+	for (auto c2 : list_np)
+	for (auto c3 : list_np)
+		add(name("$_DLATCHSR_", {c1, c2, c3}), {ID::E, ID::S, ID::R, ID::D}, {ID::Q});
+}
+
+void CellTypes::setup_builtin(BuiltinCellTypes::Group group)
+{
+	if (builtin == nullptr) {
+		builtin = &BuiltinCellTypes::get();
+		builtin_enabled.resize(GetSize(builtin->entries));
+	}
+
+	for (int i = builtin->group_begin[group]; i < builtin->group_end[group]; i++) {
+		builtin_enabled[i] = true;
+		if (!cell_types.empty())
+			cell_types.erase(builtin->entries[i].info.type);
+	}
+}
+
+void CellTypes::setup_type(RTLIL::IdString type, const pool<RTLIL::IdString> &inputs, const pool<RTLIL::IdString> &outputs, bool is_evaluable, bool is_combinatorial, bool is_synthesizable)
+{
+	// an explicitly registered type replaces the built-in definition
+	if (builtin != nullptr) {
+		int idx = builtin->find_entry(type);
+		if (idx >= 0)
+			builtin_enabled[idx] = false;
+	}
+
+	CellType ct = {type, inputs, outputs, is_evaluable, is_combinatorial, is_synthesizable};
+	cell_types[ct.type] = ct;
+}
+
+void CellTypes::erase(RTLIL::IdString type)
+{
+	if (builtin != nullptr) {
+		int idx = builtin->find_entry(type);
+		if (idx >= 0)
+			builtin_enabled[idx] = false;
+	}
+	cell_types.erase(type);
+}
+
+void CellTypes::clear()
+{
+	cell_types.clear();
+	builtin_enabled.assign(builtin_enabled.size(), false);
+}
+
+dict<RTLIL::IdString, CellType> CellTypes::all_types() const
+{
+	dict<RTLIL::IdString, CellType> result = cell_types;
+	if (builtin != nullptr)
+		for (int i = 0; i < GetSize(builtin->entries); i++)
+			if (builtin_enabled[i])
+				result[builtin->entries[i].info.type] = builtin->entries[i].info;
+	return result;
+}
+
+YOSYS_NAMESPACE_END
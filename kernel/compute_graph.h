@@ -39,25 +39,21 @@ private:
     // Functions are deduplicated by assigning unique ids
     idict<Fn> functions;
 
-    struct Node {
-        int fn_index;
-        int arg_offset;
-        int arg_count;
-        Attr attr;
+    // Nodes are stored as a struct of arrays, node i uses the function
+    // fn_indices[i] and the arguments args[arg_offsets[i] +: arg_counts[i]]
+    std::vector<int> fn_indices;
+    std::vector<int> arg_offsets;
+    std::vector<int> arg_counts;
+    std::vector<Attr> attrs;
 
-        Node(int fn_index, Attr &&attr, int arg_offset, int arg_count = 0)
-            : fn_index(fn_index), arg_offset(arg_offset), arg_count(arg_count), attr(std::move(attr)) {}
-
-        Node(int fn_index, Attr const &attr, int arg_offset, int arg_count = 0)
-            : fn_index(fn_index), arg_offset(arg_offset), arg_count(arg_count), attr(attr) {}
-    };
-
-
-    std::vector<Node> nodes;
     std::vector<int> args;
     dict<Key, int> keys_;
     dict<int, SparseAttr> sparse_attrs;
 
+    // Nodes added with add_unique(), indexed by attribute, function index
+    // and arguments. Cleared when the node indices change.
+    dict<std::pair<Attr, std::vector<int>>, int> unique_nodes;
+
 public:
     template<typename Graph>
     struct BaseRef
@@ -73,35 +69,32 @@ public:
 
         void check() const { log_assert(index_ < graph_->size()); }
 
-        Node const &deref() const { check(); return graph_->nodes[index_]; }
-
     public:
-        ComputeGraph const &graph() const { return graph_; }
+        ComputeGraph const &graph() const { return *graph_; }
         int index() const { return index_; }
 
-        int size() const { return deref().arg_count; }
+        int size() const { check(); return graph_->arg_counts[index_]; }
 
         BaseRef arg(int n) const
         {
-            Node const &node = deref();
-            log_assert(n >= 0 && n < node.arg_count);
-            return BaseRef(graph_, graph_->args[node.arg_offset + n]);
+            log_assert(n >= 0 && n < size());
+            return BaseRef(graph_, graph_->args[graph_->arg_offsets[index_] + n]);
         }
 
         std::vector<int>::const_iterator arg_indices_cbegin() const
         {
-            Node const &node = deref();
-            return graph_->args.cbegin() + node.arg_offset;
+            check();
+            return graph_->args.cbegin() + graph_->arg_offsets[index_];
         }
 
         std::vector<int>::const_iterator arg_indices_cend() const
         {
-            Node const &node = deref();
-            return graph_->args.cbegin() + node.arg_offset + node.arg_count;
+            check();
+            return graph_->args.cbegin() + graph_->arg_offsets[index_] + graph_->arg_counts[index_];
         }
 
-        Fn const &function() const { return graph_->functions[deref().fn_index]; }
-        Attr const &attr() const { return deref().attr; }
+        Fn const &function() const { check(); return graph_->functions[graph_->fn_indices[index_]]; }
+        Attr const &attr() const { check(); return graph_->attrs[index_]; }
 
         bool has_sparse_attr() const { return graph_->sparse_attrs.count(index_); }
 
@@ -120,17 +113,18 @@ public:
     private:
         friend struct ComputeGraph;
         Ref(ComputeGraph *graph, int index) : BaseRef<ComputeGraph>(graph, index) {}
-        Node &deref() const { this->check(); return this->graph_->nodes[this->index_]; }
 
     public:
         Ref(BaseRef<ComputeGraph> ref) : Ref(ref.graph_, ref.index_) {}
 
+        // Nodes added with add_unique() must not be modified
         void set_function(Fn const &function) const
         {
-            deref().fn_index = this->graph_->functions(function);
+            this->check();
+            this->graph_->fn_indices[this->index_] = this->graph_->functions(function);
         }
 
-        Attr &attr() const { return deref().attr; }
+        Attr &attr() const { this->check(); return this->graph_->attrs[this->index_]; }
 
         void append_arg(ConstRef arg) const
         {
@@ -141,11 +135,13 @@ public:
         void append_arg(int arg) const
         {
             log_assert(arg >= 0 && arg < this->graph_->size());
-            Node &node = deref();
-            if (node.arg_offset + node.arg_count != GetSize(this->graph_->args))
-                move_args(node);
+            this->check();
+            int &arg_offset = this->graph_->arg_offsets[this->index_];
+            int &arg_count = this->graph_->arg_counts[this->index_];
+            if (arg_offset + arg_count != GetSize(this->graph_->args))
+                move_args(arg_offset, arg_count);
             this->graph_->args.push_back(arg);
-            node.arg_count++;
+            arg_count++;
         }
 
         operator ConstRef() const
@@ -169,12 +165,12 @@ public:
         }
 
     private:
-        void move_args(Node &node) const
+        void move_args(int &arg_offset, int arg_count) const
         {
             auto &args = this->graph_->args;
-            int old_offset = node.arg_offset;
-            node.arg_offset = GetSize(args);
-            for (int i = 0; i != node.arg_count; ++i)
+            int old_offset = arg_offset;
+            arg_offset = GetSize(args);
+            for (int i = 0; i != arg_count; ++i)
                 args.push_back(args[old_offset + i]);
         }
 
@@ -197,6 +193,9 @@ public:
         return (*this)[it->second];
     }
 
+    static int arg_index(int arg) { return arg; }
+    static int arg_index(ConstRef arg) { return arg.index(); }
+
     Ref operator()(Key const &key)
     {
         auto it = keys_.find(key);
@@ -204,24 +203,29 @@ public:
         return (*this)[it->second];
     }
 
-    int size() const { return GetSize(nodes); }
+    int size() const { return GetSize(fn_indices); }
+    int num_args() const { return GetSize(args); }
 
     ConstRef operator[](int index) const { return ConstRef(this, index); }
     Ref operator[](int index) { return Ref(this, index); }
 
     Ref add(Fn const &function, Attr &&attr)
     {
-        int index = GetSize(nodes);
-        int fn_index = functions(function);
-        nodes.emplace_back(fn_index, std::move(attr), GetSize(args));
+        int index = size();
+        fn_indices.push_back(functions(function));
+        arg_offsets.push_back(GetSize(args));
+        arg_counts.push_back(0);
+        attrs.push_back(std::move(attr));
         return Ref(this, index);
     }
 
     Ref add(Fn const &function, Attr const &attr)
     {
-        int index = GetSize(nodes);
-        int fn_index = functions(function);
-        nodes.emplace_back(fn_index, attr,  GetSize(args));
+        int index = size();
+        fn_indices.push_back(functions(function));
+        arg_offsets.push_back(GetSize(args));
+        arg_counts.push_back(0);
+        attrs.push_back(attr);
         return Ref(this, index);
     }
 
@@ -268,28 +272,94 @@ public:
         return added;
     }
 
+    // Returns an existing node with the same function, attribute and
+    // arguments as the requested one if there is one, or adds a new node.
+    // Only nodes added with add_unique() are considered.
+    template<typename T>
+    Ref add_unique(Fn const &function, Attr const &attr, T &&args)
+    {
+        std::vector<int> signature;
+        signature.push_back(functions(function));
+        for (auto arg : args)
+            signature.push_back(arg_index(arg));
+
+        auto key = std::make_pair(attr, std::move(signature));
+        auto found = unique_nodes.find(key);
+        if (found != unique_nodes.end())
+            return Ref(this, found->second);
+
+        Ref added = add(function, attr);
+        for (auto it = key.second.begin() + 1; it != key.second.end(); ++it)
+            added.append_arg(*it);
+        unique_nodes.emplace(std::move(key), added.index());
+        return added;
+    }
+
+    // Merges all nodes with the same function, attribute and arguments into
+    // the first of them, calling merge(kept, removed) before a node is
+    // dropped. The arguments of every node must precede it (as after a
+    // topological sort).
+    template<typename MergeFn>
+    void merge_duplicates(MergeFn merge)
+    {
+        dict<std::pair<Attr, std::vector<int>>, int> seen;
+        std::vector<int> perm, inv_perm;
+        inv_perm.reserve(size());
+        for (int i = 0; i < size(); ++i)
+        {
+            std::vector<int> signature;
+            signature.push_back(fn_indices[i]);
+            for (int j = 0; j < arg_counts[i]; ++j) {
+                int arg = args[arg_offsets[i] + j];
+                log_assert(arg < i);
+                signature.push_back(inv_perm[arg]);
+            }
+            auto found = seen.emplace(std::make_pair(attrs[i], std::move(signature)), GetSize(perm));
+            if (found.second) {
+                perm.push_back(i);
+            } else {
+                merge((*this)[perm[found.first->second]], (*this)[i]);
+            }
+            inv_perm.push_back(found.first->second);
+        }
+        if (GetSize(perm) != size())
+            permute(perm, inv_perm);
+    }
+
+    // Approximate number of bytes allocated for the nodes and arguments.
+    size_t memory_usage() const
+    {
+        size_t bytes = (sizeof(int) * 3 + sizeof(Attr)) * fn_indices.capacity();
+        bytes += sizeof(int) * args.capacity();
+        bytes += (sizeof(Fn) + 2 * sizeof(int)) * GetSize(functions);
+        bytes += (sizeof(Key) + 2 * sizeof(int)) * GetSize(keys_);
+        bytes += (sizeof(SparseAttr) + 3 * sizeof(int)) * GetSize(sparse_attrs);
+        return bytes;
+    }
+
     void compact_args()
     {
         std::vector<int> new_args;
-        for (auto &node : nodes)
+        new_args.reserve(args.size());
+        for (int i = 0; i < size(); i++)
         {
             int new_offset = GetSize(new_args);
-            for (int i = 0; i < node.arg_count; i++)
-                new_args.push_back(args[node.arg_offset + i]);
-            node.arg_offset = new_offset;
+            for (int j = 0; j < arg_counts[i]; j++)
+                new_args.push_back(args[arg_offsets[i] + j]);
+            arg_offsets[i] = new_offset;
         }
         std::swap(args, new_args);
     }
 
     void permute(std::vector<int> const &perm)
     {
-        log_assert(perm.size() <= nodes.size());
+        log_assert(GetSize(perm) <= size());
         std::vector<int> inv_perm;
-        inv_perm.resize(nodes.size(), -1);
+        inv_perm.resize(size(), -1);
         for (int i = 0; i < GetSize(perm); ++i)
         {
             int j = perm[i];
-            log_assert(j >= 0 && j < GetSize(nodes));
+            log_assert(j >= 0 && j < size());
             log_assert(inv_perm[j] == -1);
             inv_perm[j] = i;
         }
@@ -298,21 +368,32 @@ public:
 
     void permute(std::vector<int> const &perm, std::vector<int> const &inv_perm)
     {
-        log_assert(inv_perm.size() == nodes.size());
-        std::vector<Node> new_nodes;
-        new_nodes.reserve(perm.size());
+        log_assert(GetSize(inv_perm) == size());
+        std::vector<int> new_fn_indices, new_arg_offsets, new_arg_counts;
+        std::vector<Attr> new_attrs;
+        new_fn_indices.reserve(perm.size());
+        new_arg_offsets.reserve(perm.size());
+        new_arg_counts.reserve(perm.size());
+        new_attrs.reserve(perm.size());
         dict<int, SparseAttr> new_sparse_attrs;
         for (int i : perm)
         {
-            int j = GetSize(new_nodes);
-            new_nodes.emplace_back(std::move(nodes[i]));
+            int j = GetSize(new_fn_indices);
+            new_fn_indices.push_back(fn_indices[i]);
+            new_arg_offsets.push_back(arg_offsets[i]);
+            new_arg_counts.push_back(arg_counts[i]);
+            new_attrs.emplace_back(std::move(attrs[i]));
             auto found = sparse_attrs.find(i);
             if (found != sparse_attrs.end())
                 new_sparse_attrs.emplace(j, std::move(found->second));
         }
 
-        std::swap(nodes, new_nodes);
+        std::swap(fn_indices, new_fn_indices);
+        std::swap(arg_offsets, new_arg_offsets);
+        std::swap(arg_counts, new_arg_counts);
+        std::swap(attrs, new_attrs);
         std::swap(sparse_attrs, new_sparse_attrs);
+        unique_nodes.clear();
 
         compact_args();
         for (int &arg : args)
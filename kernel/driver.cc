@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/hashlib.h"
+#include "kernel/tracing.h"
 #include "libs/sha1/sha1.h"
 #define CXXOPTS_VECTOR_DELIMITER '\0'
 #include "libs/cxxopts/include/cxxopts.hpp"
@@ -200,6 +201,8 @@ int main(int argc, char **argv)
 	std::string depsfile = "";
 	std::string topmodule = "";
 	std::string perffile = "";
+	std::string tracefile = "";
+	bool memstats = false;
 	bool scriptfile_tcl = false;
 	bool scriptfile_python = false;
 	bool print_banner = true;
@@ -292,6 +295,10 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<feature>")
 		("g,debug", "globally enable debug log messages")
 		("perffile", "write a JSON performance log to <perffile>", cxxopts::value<std::string>(), "<perffile>")
+		("trace-json", "write a timeline of all executed commands in Chrome trace event format to <tracefile> " \
+						"(see 'help tracing' for details)", cxxopts::value<std::string>(), "<tracefile>")
+		("memstats", "record memory usage for every executed command and print the commands with the "
+						"largest peak memory increase at the end (see 'help internal_stats')")
 	;
 
 	options.parse_positional({"infile"});
@@ -360,7 +367,10 @@ int main(int argc, char **argv)
 				for (const auto& filename : result[key].as<std::vector<std::string>>()) {
 					if (FILE* f = fopen(filename.c_str(), "wt")) {
 						log_files.push_back(f);
-						if (key[0] == 'L') setvbuf(f, NULL, _IOLBF, 0);
+						if (key[0] == 'L')
+							setvbuf(f, NULL, _IOLBF, 0);
+						else
+							log_file_async(f);
 					} else {
 						std::cerr << "Can't open log file `" << filename << "' for writing!\n";
 						exit(1);
@@ -436,6 +446,8 @@ int main(int argc, char **argv)
 			log_experimentals_ignored.insert(ignores.begin(), ignores.end());
 		}
 		if (result.count("perffile")) perffile = result["perffile"].as<std::string>();
+		if (result.count("trace-json")) tracefile = result["trace-json"].as<std::string>();
+		if (result.count("memstats")) memstats = true;
 		if (result.count("infile")) {
 			frontend_files = result["infile"].as<std::vector<std::string>>();
 		}
@@ -521,6 +533,11 @@ int main(int argc, char **argv)
 #endif
 	log_error_atexit = yosys_atexit;
 
+	if (!tracefile.empty())
+		trace_start(tracefile);
+	if (memstats)
+		memstats_start();
+
 	for (auto &fn : plugin_filenames)
 		load_plugin(fn, {});
 
@@ -640,6 +657,8 @@ int main(int argc, char **argv)
 		fprintf(f, "\n");
 	}
 
+	trace_stop();
+
 	if (log_expect_no_warnings && log_warnings_count_noexpect)
 		log_error("Unexpected warnings found: %d unique messages, %d total, %d expected\n", GetSize(log_warnings),
 					log_warnings_count, log_warnings_count - log_warnings_count_noexpect);
@@ -727,6 +746,8 @@ int main(int argc, char **argv)
 			}
 			log("%s\n", out_count ? "" : " no commands executed");
 		}
+		if (memstats_enabled())
+			memstats_log_summary(timing_details ? 1000 : 10);
 		if(!perffile.empty())
 		{
 			FILE *f = fopen(perffile.c_str(), "wt");
@@ -663,6 +663,13 @@ void DriverMap::add(Module *module)
 // Add a single bit connection to the driver map.
 void DriverMap::add(DriveBit const &a, DriveBit const &b)
 {
+	// A new connection can change how undirected connections have to be
+	// oriented, so drop any orientation cached by earlier queries.
+	if (!oriented_present.empty()) {
+		connected_oriented = DriveBitGraph();
+		oriented_present.clear();
+	}
+
 	DriveBitId a_id = id_from_drive_bit(a);
 	DriveBitId b_id = id_from_drive_bit(b);
 
@@ -813,34 +820,20 @@ void DriverMap::orient_undirected(DriveBitId id)
 		oriented_present.emplace(seen_id);
 }
 
-DriveBit DriverMap::operator()(DriveBit const &bit)
+void DriverMap::resolve_repr(DriveBitId bit_repr_id, ResolvedBit &resolved)
 {
-	if (bit.type() == DriveType::MARKER || bit.type() == DriveType::NONE)
-		return bit;
-	if (bit.type() == DriveType::MULTIPLE)
-	{
-		DriveBit result;
-		for (auto const &inner : bit.multiple().multiple())
-			result.merge((*this)(inner));
-		return result;
-	}
-
-	DriveBitId bit_id = id_from_drive_bit(bit);
-
-	DriveBitId bit_repr_id = same_driver.find(bit_id);
-
 	DriveBit bit_repr = drive_bit_from_id(bit_repr_id);
 
 	BitMode mode = bit_mode(bit_repr);
 
-	if (mode == BitMode::KEEP && bit_repr_id != bit_id)
-		return bit_repr;
+	if (mode == BitMode::KEEP)
+		resolved.keep_repr = bit_repr;
 
 	int implicit_driver_count = connected_drivers.count(bit_repr_id);
 	if (connected_undirected.contains(bit_repr_id) && !oriented_present.count(bit_repr_id))
 		orient_undirected(bit_repr_id);
 
-	DriveBit driver;
+	DriveBit &driver = resolved.driver;
 
 	if (mode == BitMode::DRIVER || mode == BitMode::TRISTATE)
 		driver = bit_repr;
@@ -851,8 +844,43 @@ DriveBit DriverMap::operator()(DriveBit const &bit)
 	int oriented_driver_count = connected_oriented.count(bit_repr_id);
 	for (int i = 0; i != oriented_driver_count; ++i)
 		driver.merge(drive_bit_from_id(connected_oriented.at(bit_repr_id, i)));
+}
 
-	return driver;
+DriveBit DriverMap::resolve(DriveBit const &bit, dict<DriveBitId, ResolvedBit> *cache)
+{
+	if (bit.type() == DriveType::MARKER || bit.type() == DriveType::NONE)
+		return bit;
+	if (bit.type() == DriveType::MULTIPLE)
+	{
+		DriveBit result;
+		for (auto const &inner : bit.multiple().multiple())
+			result.merge(resolve(inner, cache));
+		return result;
+	}
+
+	DriveBitId bit_id = id_from_drive_bit(bit);
+
+	DriveBitId bit_repr_id = same_driver.find(bit_id);
+
+	ResolvedBit uncached;
+	ResolvedBit *resolved = &uncached;
+	if (cache != nullptr) {
+		auto emplaced = cache->emplace(bit_repr_id, ResolvedBit());
+		resolved = &emplaced.first->second;
+		if (emplaced.second)
+			resolve_repr(bit_repr_id, *resolved);
+	} else
+		resolve_repr(bit_repr_id, *resolved);
+
+	if (resolved->keep_repr.type() != DriveType::NONE && bit_repr_id != bit_id)
+		return resolved->keep_repr;
+
+	return resolved->driver;
+}
+
+DriveBit DriverMap::operator()(DriveBit const &bit)
+{
+	return resolve(bit, nullptr);
 }
 
 DriveSpec DriverMap::operator()(DriveSpec spec)
@@ -865,6 +893,21 @@ DriveSpec DriverMap::operator()(DriveSpec spec)
 	return result;
 }
 
+std::vector<DriveSpec> DriverMap::operator()(std::vector<DriveSpec> const &specs)
+{
+	dict<DriveBitId, ResolvedBit> cache;
+	std::vector<DriveSpec> results(specs.size());
+
+	for (int index = 0; index != GetSize(specs); ++index) {
+		DriveSpec const &spec = specs[index];
+		DriveSpec &result = results[index];
+		for (int i = 0, width = spec.size(); i != width; ++i)
+			result.append(resolve(spec[i], &cache));
+	}
+
+	return results;
+}
+
 const char *log_signal(DriveChunkWire const &chunk)
 {
 	const char *id = log_id(chunk.wire->name);
@@ -1246,11 +1246,27 @@ private:
 
 	void orient_undirected(DriveBitId id);
 
+	// Driver of a bit's representative, shared by all bits in the same
+	// `same_driver` class. The representative itself is only returned for
+	// kept wires and only when queried through another bit of the class.
+	struct ResolvedBit {
+		DriveBit driver;
+		DriveBit keep_repr;
+	};
+
+	void resolve_repr(DriveBitId repr_id, ResolvedBit &resolved);
+	DriveBit resolve(DriveBit const &bit, dict<DriveBitId, ResolvedBit> *cache);
+
 public:
 	DriveBit operator()(DriveBit const &bit);
 
 	DriveSpec operator()(DriveSpec spec);
 
+	// Batched query, resolving many specs at once. Bits that share a
+	// representative (e.g. all bits of a bus seen through several aliases)
+	// are only resolved once per batch.
+	std::vector<DriveSpec> operator()(std::vector<DriveSpec> const &specs);
+
 private:
 	bool keep_wire(Wire *wire) {
 		// TODO configurable
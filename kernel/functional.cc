@@ -561,6 +561,17 @@ private:
 		// - We ignore collision_x_mask because x is a dont care value for us anyway.
 		// - Since wr port j can only have priority over wr port i if j > i, if we do writes in
 		//   ascending index order the result will obey the priorty relation.
+		// resolve the drivers of all port signals in a single batch
+		vector<DriveSpec> port_sigs;
+		for (const auto &wr : mem->wr_ports) {
+			port_sigs.emplace_back(wr.en);
+			port_sigs.emplace_back(wr.addr);
+			port_sigs.emplace_back(wr.data);
+		}
+		for (const auto &rd : mem->rd_ports)
+			port_sigs.emplace_back(rd.addr);
+		vector<DriveSpec> port_drivers = driver_map(port_sigs);
+		auto next_driver = port_drivers.begin();
 		vector<Node> read_results;
 		auto &state = factory.add_state(mem->cell->name, ID($state), Sort(ceil_log2(mem->size), mem->width));
 		state.set_initial_value(MemContents(mem));
@@ -570,9 +581,9 @@ private:
 			if (wr.clk_enable)
 				log_error("Write port %zd of memory %s.%s is clocked. This is not supported by the functional backend. "
 					"Call async2sync or clk2fflogic to avoid this error.\n", i, log_id(mem->module), log_id(mem->memid));
-			Node en = enqueue(driver_map(DriveSpec(wr.en)));
-			Node addr = enqueue(driver_map(DriveSpec(wr.addr)));
-			Node new_data = enqueue(driver_map(DriveSpec(wr.data)));
+			Node en = enqueue(*next_driver++);
+			Node addr = enqueue(*next_driver++);
+			Node new_data = enqueue(*next_driver++);
 			Node old_data = factory.memory_read(node, addr);
 			Node wr_data = simplifier.bitwise_mux(old_data, new_data, en);
 			node = factory.memory_write(node, addr, wr_data);
@@ -585,7 +596,7 @@ private:
 			if (rd.clk_enable)
 				log_error("Read port %zd of memory %s.%s is clocked. This is not supported by the functional backend. "
 					"Call memory_nordff to avoid this error.\n", i, log_id(mem->module), log_id(mem->memid));
-			Node addr = enqueue(driver_map(DriveSpec(rd.addr)));
+			Node addr = enqueue(*next_driver++);
 			read_results.push_back(factory.memory_read(node, addr));
 		}
 		state.set_next_value(node);
@@ -721,15 +732,24 @@ public:
 };
 
 IR IR::from_module(Module *module) {
+	int64_t begin = PerformanceTimer::query();
 	IR ir;
     auto factory = ir.factory();
     FunctionalIRConstruction ctor(module, factory);
     ctor.process_queue();
+    ir._stat_nodes_built = ir.size();
     ir.topological_sort();
     ir.forward_buf();
+    ir.compact();
+    ir._stat_build_ns = PerformanceTimer::query() - begin;
     return ir;
 }
 
+void IR::log_stats() const {
+	log("Functional IR: %d nodes (%d before simplification), %d arguments, ~%zu KiB, built in %.3f ms.\n",
+		size(), _stat_nodes_built, _graph.num_args(), _graph.memory_usage() / 1024, _stat_build_ns / 1e6);
+}
+
 void IR::topological_sort() {
     Graph::SccAdaptor compute_graph_scc(_graph);
     bool scc = false;
@@ -797,6 +817,20 @@ void IR::forward_buf() {
     _graph.permute(perm, alias);
 }
 
+void IR::compact() {
+	_graph.merge_duplicates([](Graph::Ref kept, Graph::Ref removed) {
+		if(removed.has_sparse_attr()) {
+			if(kept.has_sparse_attr()) {
+				IdString id = merge_name(removed.sparse_attr(), kept.sparse_attr());
+				kept.sparse_attr() = id;
+			} else {
+				IdString id = removed.sparse_attr();
+				kept.sparse_attr() = id;
+			}
+		}
+	});
+}
+
 // Quoting routine to make error messages nicer
 static std::string quote_fmt(const char *fmt)
 {
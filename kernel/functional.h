@@ -207,10 +207,12 @@ namespace Functional {
 		friend class IRInput;
 		friend class IROutput;
 		friend class IRState;
-		// one NodeData is stored per Node, containing the function and non-node arguments
-		// note that NodeData is deduplicated by ComputeGraph
+		// one NodeData is stored per Node, containing the function, the sort and non-node arguments
+		// note that NodeData is deduplicated by ComputeGraph, so every node only stores an index
 		class NodeData {
+			friend class Factory;
 			Fn _fn;
+			Sort _sort;
 			std::variant<
 				std::monostate,
 				RTLIL::Const,
@@ -218,32 +220,34 @@ namespace Functional {
 				int
 			> _extra;
 		public:
-			NodeData() : _fn(Fn::invalid) {}
-			NodeData(Fn fn) : _fn(fn) {}
-			template<class T> NodeData(Fn fn, T &&extra) : _fn(fn), _extra(std::forward<T>(extra)) {}
+			NodeData() : _fn(Fn::invalid), _sort(0) {}
+			NodeData(Fn fn) : _fn(fn), _sort(0) {}
+			template<class T> NodeData(Fn fn, T &&extra) : _fn(fn), _sort(0), _extra(std::forward<T>(extra)) {}
 			Fn fn() const { return _fn; }
+			Sort const &sort() const { return _sort; }
 			const RTLIL::Const &as_const() const { return std::get<RTLIL::Const>(_extra); }
 			std::pair<IdString, IdString> as_idstring_pair() const { return std::get<std::pair<IdString, IdString>>(_extra); }
 			int as_int() const { return std::get<int>(_extra); }
 			[[nodiscard]] Hasher hash_into(Hasher h) const {
 				h.eat((unsigned int) _fn);
+				h = _sort.hash_into(h);
 				h.eat(_extra);
 				return h;
 			}
 			bool operator==(NodeData const &other) const {
-				return _fn == other._fn && _extra == other._extra;
+				return _fn == other._fn && _sort == other._sort && _extra == other._extra;
 			}
 		};
-		// Attr contains all the information about a note that should not be deduplicated
-		struct Attr {
-			Sort sort;
-		};
 		// our specialised version of ComputeGraph
+		// there are no per-node attributes, everything that describes a node is part of its NodeData
 		// the sparse_attr IdString stores a naming suggestion, retrieved with name()
 		// the key is currently used to identify the nodes that represent output and next state values
 		// the bool is true for next state values
-		using Graph = ComputeGraph<NodeData, Attr, IdString, std::tuple<IdString, IdString, bool>>;
+		using Graph = ComputeGraph<NodeData, std::tuple<>, IdString, std::tuple<IdString, IdString, bool>>;
 		Graph _graph;
+		// statistics collected by from_module(), see log_stats()
+		int _stat_nodes_built = 0;
+		int64_t _stat_build_ns = 0;
 		dict<std::pair<IdString, IdString>, IRInput> _inputs;
 		dict<std::pair<IdString, IdString>, IROutput> _outputs;
 		dict<std::pair<IdString, IdString>, IRState> _states;
@@ -255,6 +259,10 @@ namespace Functional {
 		Node operator[](int i);
 		void topological_sort();
 		void forward_buf();
+		// merges nodes that became identical after forward_buf(), requires a topologically sorted IR
+		void compact();
+		// logs the size of the IR and the time and memory it took to build it
+		void log_stats() const;
 		IRInput const& input(IdString name, IdString kind) const { return _inputs.at({name, kind}); }
 		IRInput const& input(IdString name) const { return input(name, ID($input)); }
 		IROutput const& output(IdString name, IdString kind) const { return _outputs.at({name, kind}); }
@@ -314,7 +322,7 @@ namespace Functional {
 				return std::string("\\n") + std::to_string(id());
 		}
 		Fn fn() const { return _ref.function().fn(); }
-		Sort sort() const { return _ref.attr().sort; }
+		Sort sort() const { return _ref.function().sort(); }
 		// returns the width of a bitvector node, errors out for other nodes
 		int width() const { return sort().width(); }
 		size_t arg_count() const { return _ref.size(); }
@@ -452,13 +460,15 @@ namespace Functional {
 		friend class IR;
 		IR &_ir;
 		explicit Factory(IR &ir) : _ir(ir) {}
+		// nodes are hash-consed: adding a node that already exists returns the existing node
 		Node add(IR::NodeData &&fn, Sort const &sort, std::initializer_list<Node> args) {
 			log_assert(!sort.is_signal() || sort.width() > 0);
 			log_assert(!sort.is_memory() || (sort.addr_width() > 0 && sort.data_width() > 0));
-			IR::Graph::Ref ref = _ir._graph.add(std::move(fn), {std::move(sort)});
+			fn._sort = sort;
+			std::vector<int> arg_ids;
 			for (auto arg : args)
-				ref.append_arg(IR::Graph::ConstRef(arg));
-			return Node(ref);
+				arg_ids.push_back(arg.id());
+			return Node(_ir._graph.add_unique(std::move(fn), {}, arg_ids));
 		}
 		void check_basic_binary(Node const &a, Node const &b) { log_assert(a.sort().is_signal() && a.sort() == b.sort()); }
 		void check_shift(Node const &a, Node const &b) { log_assert(a.sort().is_signal() && b.sort().is_signal() && b.width() == ceil_log2(a.width())); }
@@ -542,11 +552,14 @@ namespace Functional {
 			int s = value.size();
 			return add(IR::NodeData(Fn::constant, std::move(value)), Sort(s), {});
 		}
+		// pending nodes are modified later and must not be shared, so they bypass hash-consing
 		Node create_pending(int width) {
-			return add(Fn::buf, Sort(width), {});
+			IR::NodeData fn(Fn::buf);
+			fn._sort = Sort(width);
+			return Node(_ir._graph.add(std::move(fn), {}));
 		}
 		void update_pending(Node node, Node value) {
-			log_assert(node._ref.function() == Fn::buf && node._ref.size() == 0);
+			log_assert(node._ref.function().fn() == Fn::buf && node._ref.size() == 0);
 			log_assert(node.sort() == value.sort());
 			_ir.mutate(node).append_arg(value._ref);
 		}
@@ -1,6 +1,7 @@
 #include "kernel/yosys_common.h"
 #include "kernel/log.h"
 #include "kernel/gzip.h"
+#include "kernel/threading.h"
 #include <iostream>
 #include <string>
 #include <cstdarg>
@@ -17,31 +18,229 @@ YOSYS_NAMESPACE_BEGIN
 
 #ifdef YOSYS_ENABLE_ZLIB
 
+struct gzip_ostream::obuf::Block {
+	std::vector<char> in;
+	int len = 0;
+	std::string dict;
+	std::vector<unsigned char> out;
+	unsigned long crc = 0;
+	bool ok = false;
+	bool done = false;
+
+	Block() : in(block_size) { }
+
+	// Compress to a raw deflate segment ending on a byte boundary (sync
+	// flush), so that the segments of all blocks can be concatenated
+	void compress()
+	{
+		using namespace Zlib;
+		z_stream zs = {};
+		ok = false;
+		if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return;
+		if (!dict.empty())
+			deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dict.data()), dict.size());
+		out.resize(deflateBound(&zs, len) + 16);
+		zs.next_in = reinterpret_cast<Bytef*>(in.data());
+		zs.avail_in = len;
+		size_t produced = 0;
+		while (1) {
+			zs.next_out = out.data() + produced;
+			zs.avail_out = out.size() - produced;
+			int ret = deflate(&zs, Z_SYNC_FLUSH);
+			produced = out.size() - zs.avail_out;
+			if (ret != Z_OK && ret != Z_BUF_ERROR)
+				break;
+			if (zs.avail_in == 0 && zs.avail_out != 0) {
+				ok = true;
+				break;
+			}
+			out.resize(out.size() * 2);
+		}
+		out.resize(produced);
+		deflateEnd(&zs);
+		crc = crc32(0, reinterpret_cast<const Bytef*>(in.data()), len);
+	}
+};
+
+#ifdef YOSYS_ENABLE_THREADS
+struct gzip_ostream::obuf::Workers {
+	ConcurrentQueue<std::shared_ptr<Block>> queue;
+	std::mutex mutex;
+	std::condition_variable cond;
+	ThreadPool pool;
+
+	Workers(int num_threads) : pool(num_threads, [this](int) {
+		while (auto block = queue.pop_front()) {
+			(*block)->compress();
+			std::unique_lock<std::mutex> lock(mutex);
+			(*block)->done = true;
+			cond.notify_all();
+		}
+	}) { }
+
+	~Workers() {
+		queue.close();
+	}
+
+	bool is_done(Block &block) {
+		std::unique_lock<std::mutex> lock(mutex);
+		return block.done;
+	}
+
+	void wait_done(Block &block) {
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [&block] { return block.done; });
+	}
+};
+#else
+struct gzip_ostream::obuf::Workers {
+};
+#endif
+
 gzip_ostream::obuf::obuf() {
-    setp(buffer, buffer + buffer_size - 1);
+	current = std::make_shared<Block>();
+	setp(current->in.data(), current->in.data() + block_size);
 }
 
 bool gzip_ostream::obuf::open(const std::string &filename) {
-    gzf = Zlib::gzopen(filename.c_str(), "wb");
-    return gzf != nullptr;
+	f = fopen(filename.c_str(), "wb");
+	if (f == nullptr)
+		return false;
+	// gzip header: magic, deflate, no flags, no mtime, no extra flags, Unix
+	static const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+	write_raw(header, sizeof(header));
+	crc = Zlib::crc32(0, nullptr, 0);
+	return !failed;
 }
 
+void gzip_ostream::obuf::write_raw(const void *data, size_t len) {
+	if (!failed && fwrite(data, 1, len, f) != len)
+		failed = true;
+}
+
+void gzip_ostream::obuf::submit_current() {
+	current->len = pptr() - pbase();
+	if (current->len == 0)
+		return;
+
+	current->dict = dict_tail;
+	if (current->len >= dict_size)
+		dict_tail.assign(current->in.data() + current->len - dict_size, dict_size);
+	else {
+		dict_tail.append(current->in.data(), current->len);
+		if (GetSize(dict_tail) > dict_size)
+			dict_tail.erase(0, dict_tail.size() - dict_size);
+	}
+
+	// Don't bother starting threads for small files
+	if (!workers_checked && current->len == block_size) {
+		workers_checked = true;
+#ifdef YOSYS_ENABLE_THREADS
+		int num_threads = ThreadPool::pool_size(1, 8);
+		if (num_threads > 0)
+			workers = std::make_unique<Workers>(num_threads);
+#endif
+	}
+
+	current->done = false;
+	pending.push_back(current);
+#ifdef YOSYS_ENABLE_THREADS
+	if (workers)
+		workers->queue.push_back(current);
+	else
+#endif
+	{
+		current->compress();
+		current->done = true;
+	}
+
+	write_finished(false);
+
+	if (spare.empty())
+		current = std::make_shared<Block>();
+	else {
+		current = spare.back();
+		spare.pop_back();
+	}
+	setp(current->in.data(), current->in.data() + block_size);
+}
+
+// Write out compressed blocks in order. Unless wait_all is set, this only
+// blocks when too many blocks are in flight, which bounds the memory use.
+void gzip_ostream::obuf::write_finished(bool wait_all) {
+#ifndef YOSYS_ENABLE_THREADS
+	(void)wait_all;
+#endif
+	while (!pending.empty()) {
+		Block &block = *pending.front();
+#ifdef YOSYS_ENABLE_THREADS
+		if (workers && !workers->is_done(block)) {
+			if (!wait_all && GetSize(pending) <= 2 * workers->pool.num_threads())
+				break;
+			workers->wait_done(block);
+		}
+#endif
+		log_assert(block.done);
+		if (!block.ok)
+			failed = true;
+		write_raw(block.out.data(), block.out.size());
+		crc = Zlib::crc32_combine(crc, block.crc, block.len);
+		total_size += block.len;
+		spare.push_back(pending.front());
+		pending.pop_front();
+	}
+}
+
+gzip_ostream::obuf::int_type gzip_ostream::obuf::overflow(int_type c) {
+	if (f == nullptr)
+		return traits_type::eof();
+	submit_current();
+	if (failed)
+		return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+// Flushing only writes out blocks that are already compressed. Cutting the
+// current block short would make the output depend on how often the caller
+// flushes (e.g. with std::endl) and hurt the compression ratio.
 int gzip_ostream::obuf::sync() {
-    int num = pptr() - pbase();
-    if (num > 0) {
-        if (Zlib::gzwrite(gzf, reinterpret_cast<const void*>(pbase()), num) != num) {
-            return -1;
-        }
-        pbump(-num);
-    }
-    return 0;
+	if (f == nullptr)
+		return -1;
+	write_finished(false);
+	if (fflush(f) != 0)
+		failed = true;
+	return failed ? -1 : 0;
+}
+
+void gzip_ostream::obuf::finish() {
+	submit_current();
+	write_finished(true);
+	workers.reset();
+
+	// empty final block with fixed Huffman codes, then the gzip trailer
+	static const unsigned char final_block[2] = {0x03, 0x00};
+	write_raw(final_block, sizeof(final_block));
+	unsigned char trailer[8];
+	for (int i = 0; i < 4; i++) {
+		trailer[i] = (crc >> (8*i)) & 0xff;
+		trailer[4+i] = (total_size >> (8*i)) & 0xff;
+	}
+	write_raw(trailer, sizeof(trailer));
+	if (fclose(f) != 0)
+		failed = true;
+	f = nullptr;
+	if (failed)
+		log_warning("Error while writing gzip compressed output.\n");
 }
 
 gzip_ostream::obuf::~obuf() {
-    if (gzf) {
-        sync();
-        Zlib::gzclose(gzf);
-    }
+	if (f)
+		finish();
 }
 
 bool gzip_istream::ibuf::open(const std::string& filename) {
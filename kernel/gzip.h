@@ -1,4 +1,5 @@
 #include <string>
+#include <deque>
 #include "kernel/yosys_common.h"
 
 #ifndef YOSYS_GZIP_H
@@ -13,8 +14,14 @@ namespace Zlib {
 }
 
 /*
-An output stream that uses a stringbuf to buffer data internally,
-using zlib to write gzip-compressed data every time the stream is flushed.
+An output stream that writes a gzip-compressed file with bounded memory use.
+
+The uncompressed data is collected in fixed-size blocks. Every block is
+compressed as an independent raw deflate segment (primed with the tail of the
+previous block as dictionary) and the segments are concatenated into a single
+valid gzip member, like pigz does. This lets the blocks be compressed on
+worker threads while the main thread keeps producing output. The compressed
+file does not depend on the number of threads used.
 */
 class gzip_ostream : public std::ostream {
 public:
@@ -25,16 +32,37 @@ public:
 		return outbuf.open(filename);
 	}
 private:
-	class obuf : public std::stringbuf {
+	class obuf : public std::streambuf {
 	public:
 		obuf();
 		bool open(const std::string &filename);
-		virtual int sync() override;
 		virtual ~obuf();
+	protected:
+		virtual int_type overflow(int_type c) override;
+		virtual int sync() override;
 	private:
-		static const int buffer_size = 4096;
-		char buffer[buffer_size];             // Internal buffer for compressed data
-		Zlib::gzFile gzf = nullptr;                 // Handle to the gzip file
+		struct Block;
+		static const int block_size = 128 * 1024;
+		static const int dict_size = 32 * 1024;
+
+		FILE *f = nullptr;
+		bool failed = false;
+		// blocks submitted for compression, in file order
+		std::deque<std::shared_ptr<Block>> pending;
+		// finished blocks kept for reuse, so the buffers are allocated once
+		std::vector<std::shared_ptr<Block>> spare;
+		std::shared_ptr<Block> current;
+		// last bytes of uncompressed data, used as dictionary for the next block
+		std::string dict_tail;
+		unsigned long crc = 0, total_size = 0;
+		struct Workers;
+		std::unique_ptr<Workers> workers;
+		bool workers_checked = false;
+
+		void submit_current();
+		void write_finished(bool wait_all);
+		void write_raw(const void *data, size_t len);
+		void finish();
 	};
 
 	obuf outbuf;  // The stream buffer instance
@@ -51,10 +51,15 @@ namespace hashlib {
  * We implement associative data structures with separate chaining.
  * Linked lists use integers into the indirection hashtable array
  * instead of pointers.
+ *
+ * A dict with up to hashtable_small_size entries doesn't allocate the
+ * hashtable and finds keys with a linear search instead. These are very
+ * common, e.g. the connections, parameters and attributes of most cells.
  */
 
 const int hashtable_size_trigger = 2;
 const int hashtable_size_factor = 3;
+const int hashtable_small_size = 4;
 
 namespace legacy {
 	inline uint32_t djb2_add(uint32_t a, uint32_t b) {
@@ -392,6 +397,11 @@ class dict {
 	void do_rehash()
 	{
 		hashtable.clear();
+		if (int(entries.size()) <= hashtable_small_size) {
+			for (auto &entry : entries)
+				entry.next = -1;
+			return;
+		}
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
 		for (int i = 0; i < int(entries.size()); i++) {
@@ -405,9 +415,16 @@ class dict {
 	int do_erase(int index, Hasher::hash_t hash)
 	{
 		do_assert(index < int(entries.size()));
-		if (hashtable.empty() || index < 0)
+		if (index < 0)
 			return 0;
 
+		if (hashtable.empty()) {
+			if (index != int(entries.size())-1)
+				entries[index] = std::move(entries.back());
+			entries.pop_back();
+			return 1;
+		}
+
 		int k = hashtable[hash];
 		do_assert(0 <= k && k < int(entries.size()));
 
@@ -453,14 +470,18 @@ class dict {
 
 	int do_lookup(const K &key, Hasher::hash_t &hash) const
 	{
-		if (hashtable.empty())
-			return -1;
-
-		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
+		if (!hashtable.empty() && entries.size() * hashtable_size_trigger > hashtable.size()) {
 			((dict*)this)->do_rehash();
 			hash = do_hash(key);
 		}
 
+		if (hashtable.empty()) {
+			for (int index = 0; index < int(entries.size()); index++)
+				if (ops.cmp(entries[index].udata.first, key))
+					return index;
+			return -1;
+		}
+
 		int index = hashtable[hash];
 
 		while (index >= 0 && !ops.cmp(entries[index].udata.first, key)) {
@@ -475,8 +496,10 @@ class dict {
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(std::pair<K, T>(key, T()), -1);
-			do_rehash();
-			hash = do_hash(key);
+			if (int(entries.size()) > hashtable_small_size) {
+				do_rehash();
+				hash = do_hash(key);
+			}
 		} else {
 			entries.emplace_back(std::pair<K, T>(key, T()), hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -488,8 +511,10 @@ class dict {
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(value, -1);
-			do_rehash();
-			hash = do_hash(value.first);
+			if (int(entries.size()) > hashtable_small_size) {
+				do_rehash();
+				hash = do_hash(value.first);
+			}
 		} else {
 			entries.emplace_back(value, hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -500,10 +525,11 @@ class dict {
 	int do_insert(std::pair<K, T> &&rvalue, Hasher::hash_t &hash)
 	{
 		if (hashtable.empty()) {
-			auto key = rvalue.first;
 			entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), -1);
-			do_rehash();
-			hash = do_hash(key);
+			if (int(entries.size()) > hashtable_small_size) {
+				do_rehash();
+				hash = do_hash(entries.back().udata.first);
+			}
 		} else {
 			entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), hashtable[hash]);
 			hashtable[hash] = entries.size() - 1;
@@ -803,6 +829,9 @@ public:
 	bool empty() const { return entries.empty(); }
 	void clear() { hashtable.clear(); entries.clear(); }
 
+	// heap memory held by the table itself, not counting memory owned by the elements
+	size_t table_bytes() const { return hashtable.capacity() * sizeof(int) + entries.capacity() * sizeof(entry_t); }
+
 	iterator begin() { return iterator(this, int(entries.size())-1); }
 	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
 	iterator end() { return iterator(nullptr, -1); }
@@ -1170,6 +1199,9 @@ public:
 	bool empty() const { return entries.empty(); }
 	void clear() { hashtable.clear(); entries.clear(); }
 
+	// heap memory held by the table itself, not counting memory owned by the elements
+	size_t table_bytes() const { return hashtable.capacity() * sizeof(int) + entries.capacity() * sizeof(entry_t); }
+
 	iterator begin() { return iterator(this, int(entries.size())-1); }
 	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
 	iterator end() { return iterator(nullptr, -1); }
@@ -1,11 +1,15 @@
 #include "kernel/yosys_common.h"
 #include "kernel/log.h"
+#include <chrono>
 #include <iostream>
 #include <string>
 
 #if !defined(WIN32)
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #else
 #include <io.h>
 #endif
@@ -384,6 +388,123 @@ std::string escape_filename_spaces(const std::string& filename)
 	return out;
 }
 
+std::string canonical_path(const std::string &filename)
+{
+#ifdef _WIN32
+	char *path = _fullpath(nullptr, filename.c_str(), 0);
+#else
+	char *path = realpath(filename.c_str(), nullptr);
+#endif
+	if (path == nullptr)
+		return filename;
+	std::string result = path;
+	free(path);
+	return result;
+}
+
+bool FileStamp::read(const std::string &filename)
+{
+	taken = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(filename.c_str(), &st) != 0 || (st.st_mode & _S_IFDIR) != 0)
+		return false;
+	bool regular = (st.st_mode & _S_IFREG) != 0;
+	mtime = int64_t(st.st_mtime) * 1000000000;
+	ctime = int64_t(st.st_ctime) * 1000000000;
+#else
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return false;
+	bool regular = S_ISREG(st.st_mode);
+#  ifdef __APPLE__
+	mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+	ctime = int64_t(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+#  else
+	mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	ctime = int64_t(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+#  endif
+	dev = st.st_dev;
+	ino = st.st_ino;
+#endif
+	size = regular ? int64_t(st.st_size) : -1;
+	return true;
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+	close();
+#ifdef _WIN32
+	std::ifstream f(filename, std::ios::binary);
+	if (f.fail())
+		return false;
+	buffer.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+	if (buffer.empty())
+		return false;
+	data = buffer.data();
+	size = buffer.size();
+	return true;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+	data = (const char *)mapped;
+	size = info.st_size;
+	return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	buffer.clear();
+#else
+	if (data != nullptr)
+		munmap((void *)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+bool mapped_istream::open(const std::string &filename)
+{
+	if (!file.open(filename))
+		return false;
+	inbuf.set(file.data, file.size);
+	clear();
+	return true;
+}
+
+void mapped_istream::ibuf::set(const char *data, size_t size)
+{
+	char *begin = const_cast<char *>(data);
+	setg(begin, begin, begin + size);
+}
+
+std::streambuf::pos_type mapped_istream::ibuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode)
+{
+	char *base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+	if (off < eback() - base || off > egptr() - base)
+		return pos_type(off_type(-1));
+	setg(eback(), base + off, egptr());
+	return pos_type(gptr() - eback());
+}
+
+std::streambuf::pos_type mapped_istream::ibuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
 void format_emit_unescaped(std::string &result, std::string_view fmt)
 {
 	result.reserve(result.size() + fmt.size());
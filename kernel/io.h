@@ -454,6 +454,81 @@ bool is_absolute_path(std::string filename);
 void remove_directory(std::string dirname);
 bool create_directory(const std::string& dirname);
 std::string escape_filename_spaces(const std::string& filename);
+// Returns the absolute path of filename with symbolic links resolved, or
+// filename itself if that fails
+std::string canonical_path(const std::string &filename);
+
+// What data derived from a file, e.g. by a cache, is checked against: the
+// size, the modification and status change times in nanoseconds where the
+// platform has them, and device and inode. A file can still be rewritten
+// within the timestamp granularity of its file system without changing any
+// of this, see racy().
+struct FileStamp
+{
+	int64_t size = -1, mtime = 0, ctime = 0;
+	uint64_t dev = 0, ino = 0;
+	// when read() was called, not compared
+	int64_t taken = 0;
+
+	// how long after a change data read from a file must not be reused
+	static constexpr int64_t racy_ns = 2000000000;
+
+	// Returns false for directories and files that don't exist, size is set
+	// to -1 for files other than regular files
+	bool read(const std::string &filename);
+
+	// Whether the file was modified so shortly before read() was called that
+	// it could since have been rewritten without changing the stamp. Like git
+	// does for its index, data read after read() from such a file must not
+	// be reused later.
+	bool racy() const { return std::max(mtime, ctime) > taken - racy_ns; }
+
+	bool operator==(const FileStamp &other) const {
+		return size == other.size && mtime == other.mtime && ctime == other.ctime &&
+				dev == other.dev && ino == other.ino;
+	}
+	bool operator!=(const FileStamp &other) const { return !(*this == other); }
+};
+
+// Read-only view of a whole file, memory mapped where supported
+struct MappedFile
+{
+	const char *data = nullptr;
+	size_t size = 0;
+
+	MappedFile() {}
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	~MappedFile() { close(); }
+
+	// returns false if the file can't be opened or is empty
+	bool open(const std::string &filename);
+	void close();
+
+private:
+#ifdef _WIN32
+	std::string buffer;
+#endif
+};
+
+// Input stream over a MappedFile, for parsers that read from a std::istream
+class mapped_istream final : public std::istream {
+public:
+	mapped_istream() : std::istream(&inbuf) {}
+	// returns false if the file can't be mapped, see MappedFile::open
+	bool open(const std::string &filename);
+private:
+	class ibuf final : public std::streambuf {
+	public:
+		void set(const char *data, size_t size);
+	protected:
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+	};
+
+	MappedFile file;
+	ibuf inbuf;
+};
 
 YOSYS_NAMESPACE_END
 
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "libs/sha1/sha1.h"
 #include "backends/rtlil/rtlil_backend.h"
+#include "kernel/threading.h"
 
 #if !defined(_WIN32) || defined(__MINGW32__)
 #  include <sys/time.h>
@@ -81,6 +82,106 @@ static void log_id_cache_clear()
 	log_id_cache.clear();
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+// Writes the files registered with log_file_async() on a background thread.
+// Messages are appended to a per-file batch on the logging thread without
+// any locking, only full batches and flush requests go through the queue.
+struct LogAsyncWriter
+{
+	static const size_t batch_size = 64 * 1024;
+
+	struct Item {
+		// nullptr for a flush request
+		FILE *f;
+		std::string data;
+	};
+
+	pool<FILE*> files;
+	dict<FILE*, std::string> batches;
+	ConcurrentQueue<Item> queue;
+	std::mutex mutex;
+	std::condition_variable cond;
+	int flush_requested = 0, flush_done = 0;
+	ThreadPool writer;
+
+	LogAsyncWriter() : writer(1, [this](int) {
+		while (auto item = queue.pop_front()) {
+			if (item->f != nullptr) {
+				fwrite(item->data.data(), 1, item->data.size(), item->f);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			flush_done++;
+			cond.notify_all();
+		}
+	}) { }
+
+	~LogAsyncWriter() {
+		flush();
+		queue.close();
+	}
+
+	void write(FILE *f, const std::string &str) {
+		std::string &batch = batches[f];
+		batch += str;
+		if (batch.size() >= batch_size) {
+			queue.push_back({f, std::move(batch)});
+			batch.clear();
+		}
+	}
+
+	// Returns once everything logged so far has been written
+	void flush() {
+		for (auto &it : batches)
+			if (!it.second.empty()) {
+				queue.push_back({it.first, std::move(it.second)});
+				it.second.clear();
+			}
+		queue.push_back({nullptr, {}});
+		int request = ++flush_requested;
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [&] { return flush_done >= request; });
+	}
+};
+
+static LogAsyncWriter *log_async_writer = nullptr;
+#endif
+
+void log_file_async(FILE *f)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async_writer == nullptr) {
+		log_async_writer = new LogAsyncWriter;
+		// don't lose buffered output when something calls exit()
+		atexit(log_async_stop);
+	}
+	log_async_writer->files.insert(f);
+#else
+	(void)f;
+#endif
+}
+
+void log_async_stop()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	delete log_async_writer;
+	log_async_writer = nullptr;
+#endif
+}
+
+static void log_write_files(const std::string &str)
+{
+	for (auto f : log_files) {
+#ifdef YOSYS_ENABLE_THREADS
+		if (log_async_writer != nullptr && log_async_writer->files.count(f)) {
+			log_async_writer->write(f, str);
+			continue;
+		}
+#endif
+		fputs(str.c_str(), f);
+	}
+}
+
 #if defined(_WIN32) && !defined(__MINGW32__)
 // this will get time information and return it in timeval, simulating gettimeofday()
 int gettimeofday(struct timeval *tv, struct timezone *tz)
@@ -153,15 +254,13 @@ void logv(const char *format, va_list ap)
 		if (!strcmp(format, "%s") && str.back() == '\n')
 			next_print_log = true;
 
-		for (auto f : log_files)
-			fputs(time_str.c_str(), f);
+		log_write_files(time_str);
 
 		for (auto f : log_streams)
 			*f << time_str;
 	}
 
-	for (auto f : log_files)
-		fputs(str.c_str(), f);
+	log_write_files(str);
 
 	for (auto f : log_streams)
 		*f << str;
@@ -609,6 +708,11 @@ void log_reset_stack()
 
 void log_flush()
 {
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_async_writer != nullptr)
+		log_async_writer->flush();
+#endif
+
 	for (auto f : log_files)
 		fflush(f);
 
@@ -150,6 +150,12 @@ static inline bool ys_debug(int = 0) { return false; }
 #endif
 #  define log_debug(...) do { if (ys_debug(1)) log(__VA_ARGS__); } while (0)
 
+// True if plain log() messages are currently discarded (see LogMakeDebugHdl),
+// so callers can skip building expensive arguments such as log_signal()
+static inline bool log_is_suppressed() {
+	return log_make_debug && !ys_debug();
+}
+
 static inline void log_suppressed() {
 	if (log_debug_suppressed && !log_make_debug) {
 		log("<suppressed ~%d debug messages>\n", log_debug_suppressed);
@@ -181,6 +187,13 @@ struct LogMakeDebugHdl {
 	}
 };
 
+// Write the log file f on a background thread. Messages are still formatted
+// by the caller and handed over in batches, the file is complete after
+// log_flush(). Without ENABLE_THREADS=1 this does nothing.
+void log_file_async(FILE *f);
+// Flush all pending output and stop the background writer
+void log_async_stop();
+
 void log_spacer();
 void log_push();
 void log_pop();
@@ -0,0 +1,500 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/patterneval.h"
+#include "kernel/ff.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// fixed indices for constant bits, SINK is written by cells that drive constants
+enum { BIT_S0, BIT_S1, BIT_SX, BIT_SINK, NUM_FIXED_BITS };
+
+int PatternEval::index(RTLIL::SigBit bit) const
+{
+	bit = sigmap(bit);
+	if (bit.wire == nullptr)
+		return bit == RTLIL::State::S0 ? BIT_S0 : bit == RTLIL::State::S1 ? BIT_S1 : BIT_SX;
+	return NUM_FIXED_BITS + bit_index.at(bit);
+}
+
+int PatternEval::add_operand(RTLIL::SigSpec sig, int width, bool is_signed)
+{
+	int begin = GetSize(operands);
+	sigmap.apply(sig);
+	for (int i = 0; i < width; i++) {
+		if (i < GetSize(sig))
+			operands.push_back(index(sig[i]));
+		else if (is_signed && GetSize(sig) > 0)
+			operands.push_back(index(sig.msb()));
+		else
+			operands.push_back(BIT_S0);
+	}
+	return begin;
+}
+
+int PatternEval::add_output(RTLIL::SigSpec sig)
+{
+	int begin = GetSize(operands);
+	for (auto bit : sigmap(sig))
+		operands.push_back(bit.wire ? index(bit) : int(BIT_SINK));
+	return begin;
+}
+
+bool PatternEval::add_comb_cell(RTLIL::Cell *cell, Op &op)
+{
+	static const dict<RTLIL::IdString, OpKind> gate_ops = {
+		{ID($_BUF_), OP_BUF}, {ID($_NOT_), OP_NOT}, {ID($_AND_), OP_AND}, {ID($_NAND_), OP_NAND},
+		{ID($_OR_), OP_OR}, {ID($_NOR_), OP_NOR}, {ID($_XOR_), OP_XOR}, {ID($_XNOR_), OP_XNOR},
+		{ID($_ANDNOT_), OP_ANDNOT}, {ID($_ORNOT_), OP_ORNOT}, {ID($_MUX_), OP_MUX}, {ID($_NMUX_), OP_NMUX},
+		{ID($_AOI3_), OP_AOI3}, {ID($_OAI3_), OP_OAI3}, {ID($_AOI4_), OP_AOI4}, {ID($_OAI4_), OP_OAI4},
+	};
+	static const dict<RTLIL::IdString, OpKind> word_ops = {
+		// $equiv is modelled as Y = A, like in SatGen
+		{ID($not), OP_NOT}, {ID($pos), OP_BUF}, {ID($buf), OP_BUF}, {ID($equiv), OP_BUF},
+		{ID($and), OP_AND}, {ID($or), OP_OR}, {ID($xor), OP_XOR}, {ID($xnor), OP_XNOR},
+		{ID($reduce_and), OP_REDUCE_AND}, {ID($reduce_or), OP_REDUCE_OR}, {ID($reduce_bool), OP_REDUCE_OR},
+		{ID($reduce_xor), OP_REDUCE_XOR}, {ID($reduce_xnor), OP_REDUCE_XNOR},
+		{ID($logic_not), OP_LOGIC_NOT}, {ID($logic_and), OP_LOGIC_AND}, {ID($logic_or), OP_LOGIC_OR},
+		{ID($eq), OP_EQ}, {ID($ne), OP_NE}, {ID($add), OP_ADD}, {ID($sub), OP_SUB}, {ID($neg), OP_SUB},
+		{ID($lt), OP_LT}, {ID($le), OP_LE}, {ID($gt), OP_GT}, {ID($ge), OP_GE}, {ID($mux), OP_MUX},
+	};
+
+	for (int i = 0; i < 4; i++)
+		op.arg[i] = op.arg_width[i] = 0;
+
+	auto it = gate_ops.find(cell->type);
+	if (it != gate_ops.end()) {
+		op.kind = it->second;
+		op.y = add_output(cell->getPort(ID::Y));
+		op.y_width = 1;
+		std::vector<RTLIL::IdString> ports = {ID::A, ID::B};
+		if (op.kind == OP_MUX || op.kind == OP_NMUX)
+			ports.push_back(ID::S);
+		if (op.kind == OP_AOI3 || op.kind == OP_OAI3 || op.kind == OP_AOI4 || op.kind == OP_OAI4)
+			ports.push_back(ID::C);
+		if (op.kind == OP_AOI4 || op.kind == OP_OAI4)
+			ports.push_back(ID::D);
+		if (op.kind == OP_BUF || op.kind == OP_NOT)
+			ports.pop_back();
+		for (int i = 0; i < GetSize(ports); i++) {
+			op.arg[i] = add_operand(cell->getPort(ports[i]), 1, false);
+			op.arg_width[i] = 1;
+		}
+		return true;
+	}
+
+	it = word_ops.find(cell->type);
+	if (it == word_ops.end())
+		return false;
+	op.kind = it->second;
+
+	RTLIL::SigSpec sig_a = cell->getPort(ID::A), sig_y = cell->getPort(ID::Y);
+	RTLIL::SigSpec sig_b = cell->hasPort(ID::B) ? cell->getPort(ID::B) : RTLIL::SigSpec();
+	bool is_signed = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+	if (cell->hasParam(ID::B_SIGNED))
+		is_signed = is_signed && cell->getParam(ID::B_SIGNED).as_bool();
+	int y_width = GetSize(sig_y);
+
+	op.y = add_output(sig_y);
+	op.y_width = y_width;
+
+	switch (op.kind)
+	{
+	case OP_MUX:
+		op.arg[0] = add_operand(sig_a, y_width, false);
+		op.arg[1] = add_operand(sig_b, y_width, false);
+		op.arg[2] = add_operand(RTLIL::SigSpec(cell->getPort(ID::S), y_width), y_width, false);
+		op.arg_width[0] = op.arg_width[1] = op.arg_width[2] = y_width;
+		break;
+
+	case OP_REDUCE_AND: case OP_REDUCE_OR: case OP_REDUCE_XOR: case OP_REDUCE_XNOR:
+	case OP_LOGIC_NOT: case OP_LOGIC_AND: case OP_LOGIC_OR:
+		op.arg[0] = add_operand(sig_a, GetSize(sig_a), false);
+		op.arg_width[0] = GetSize(sig_a);
+		op.arg[1] = add_operand(sig_b, GetSize(sig_b), false);
+		op.arg_width[1] = GetSize(sig_b);
+		break;
+
+	case OP_EQ: case OP_NE: case OP_LT: case OP_LE: case OP_GT: case OP_GE: {
+		// one extra bit so that the sign of the difference is the comparison result
+		int width = std::max(GetSize(sig_a), GetSize(sig_b)) + (op.kind == OP_EQ || op.kind == OP_NE ? 0 : 1);
+		op.arg[0] = add_operand(sig_a, width, is_signed);
+		op.arg[1] = add_operand(sig_b, width, is_signed);
+		op.arg_width[0] = op.arg_width[1] = width;
+		break;
+	}
+
+	default:
+		if (cell->type == ID($neg)) {
+			op.arg[0] = add_operand(RTLIL::SigSpec(RTLIL::State::S0, y_width), y_width, false);
+			op.arg[1] = add_operand(sig_a, y_width, is_signed);
+			op.arg_width[0] = op.arg_width[1] = y_width;
+			break;
+		}
+		op.arg[0] = add_operand(sig_a, y_width, is_signed);
+		op.arg_width[0] = y_width;
+		if (!sig_b.empty()) {
+			op.arg[1] = add_operand(sig_b, y_width, is_signed);
+			op.arg_width[1] = y_width;
+		}
+		break;
+	}
+	return true;
+}
+
+PatternEval::PatternEval(RTLIL::Module *module, const SigMap &sigmap, const CellTypes &ct, int num_words, uint64_t seed) :
+		sigmap(sigmap), num_words_(num_words), rng_state(seed ? seed : 1)
+{
+	log_assert(num_words > 0);
+
+	for (auto wire : module->wires())
+		for (auto bit : sigmap(wire))
+			if (bit.wire != nullptr)
+				bit_index(bit);
+	int num_bits = NUM_FIXED_BITS + GetSize(bit_index);
+
+	std::vector<int> driver_count(num_bits);
+	std::vector<Op> comb_ops;
+
+	for (auto cell : module->cells())
+	{
+		if (!ct.cell_known(cell->type))
+			continue;
+
+		Op op;
+		if (cell->type.in(ID($dff), ID($ff), ID($_DFF_P_), ID($_DFF_N_), ID($_FF_))) {
+			RTLIL::SigSpec sig_d = cell->getPort(ID::D), sig_q = cell->getPort(ID::Q);
+			for (int i = 0; i < GetSize(sig_q); i++) {
+				sigmap.apply(sig_q[i]);
+				if (sig_q[i].wire == nullptr)
+					continue;
+				flip_flops.push_back({index(sig_d[i]), index(sig_q[i])});
+				driver_count[flip_flops.back().q]++;
+			}
+			continue;
+		}
+
+		if (!RTLIL::builtin_ff_cell_types().count(cell->type) && add_comb_cell(cell, op)) {
+			comb_ops.push_back(op);
+		} else {
+			// known cell without a model here, or a flip-flop that can't be
+			// stepped: outputs are undefined
+			RTLIL::SigSpec outputs;
+			for (auto &conn : cell->connections())
+				if (ct.cell_output(cell->type, conn.first))
+					outputs.append(conn.second);
+			if (RTLIL::builtin_ff_cell_types().count(cell->type)) {
+				for (auto bit : sigmap(outputs))
+					if (bit.wire != nullptr) {
+						undef_ff_bits.push_back(index(bit));
+						driver_count[undef_ff_bits.back()]++;
+					}
+				continue;
+			}
+			op.kind = OP_UNDEF;
+			op.y = add_output(outputs);
+			op.y_width = GetSize(outputs);
+			for (int i = 0; i < 4; i++)
+				op.arg[i] = op.arg_width[i] = 0;
+			comb_ops.push_back(op);
+		}
+
+		for (int i = 0; i < comb_ops.back().y_width; i++)
+			driver_count[operands[comb_ops.back().y + i]]++;
+	}
+
+	// a bit with several drivers could be inconsistent in a SAT model, so
+	// its drivers are treated as undefined
+	driver_count[BIT_SINK] = 0;
+	for (auto &op : comb_ops)
+		for (int i = 0; i < op.y_width; i++)
+			if (driver_count[operands[op.y + i]] > 1)
+				op.kind = OP_UNDEF;
+	for (auto &ff : flip_flops)
+		if (driver_count[ff.q] > 1)
+			comb_ops.push_back({OP_UNDEF, add_output(bit_index[ff.q - NUM_FIXED_BITS]), 1, {}, {}});
+	for (int bit : undef_ff_bits)
+		if (driver_count[bit] > 1)
+			comb_ops.push_back({OP_UNDEF, add_output(bit_index[bit - NUM_FIXED_BITS]), 1, {}, {}});
+
+	for (int i = NUM_FIXED_BITS; i < num_bits; i++)
+		if (driver_count[i] == 0)
+			free_bits.push_back(i);
+
+	// order the cells topologically, cells that are part of or depend on a
+	// logic loop are never ready and end up undefined
+	std::vector<int> bit_driver(num_bits, -1), pending(GetSize(comb_ops));
+	std::vector<std::vector<int>> consumers(GetSize(comb_ops));
+	for (int i = 0; i < GetSize(comb_ops); i++)
+		for (int j = 0; j < comb_ops[i].y_width; j++)
+			bit_driver[operands[comb_ops[i].y + j]] = i;
+	bit_driver[BIT_SINK] = -1;
+	for (int i = 0; i < GetSize(comb_ops); i++) {
+		auto &op = comb_ops[i];
+		if (op.kind == OP_UNDEF)
+			continue;
+		for (int k = 0; k < 4; k++)
+			for (int j = 0; j < op.arg_width[k]; j++) {
+				int driver = bit_driver[operands[op.arg[k] + j]];
+				if (driver >= 0) {
+					pending[i]++;
+					consumers[driver].push_back(i);
+				}
+			}
+	}
+
+	std::vector<int> queue;
+	for (int i = 0; i < GetSize(comb_ops); i++)
+		if (pending[i] == 0)
+			queue.push_back(i);
+	for (int q = 0; q < GetSize(queue); q++)
+		for (int consumer : consumers[queue[q]])
+			if (--pending[consumer] == 0)
+				queue.push_back(consumer);
+
+	for (int i = 0; i < GetSize(comb_ops); i++)
+		if (pending[i] != 0) {
+			comb_ops[i].kind = OP_UNDEF;
+			ops.push_back(comb_ops[i]);
+		}
+	for (int i : queue)
+		ops.push_back(comb_ops[i]);
+
+	values.resize(num_bits * num_words);
+	defs.resize(num_bits * num_words);
+	for (int w = 0; w < num_words; w++) {
+		values[BIT_S0 * num_words + w] = 0;
+		defs[BIT_S0 * num_words + w] = ~word_t(0);
+		values[BIT_S1 * num_words + w] = ~word_t(0);
+		defs[BIT_S1 * num_words + w] = ~word_t(0);
+	}
+}
+
+PatternEval::word_t PatternEval::random_word()
+{
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 2685821657736338717ULL;
+}
+
+void PatternEval::eval(const Op &op)
+{
+	int nw = num_words_;
+	auto val = [&](int base, int i) { return &values[operands[base + i] * nw]; };
+	auto def = [&](int base, int i) { return &defs[operands[base + i] * nw]; };
+
+	if (op.kind == OP_UNDEF) {
+		for (int i = 0; i < op.y_width; i++)
+			for (int w = 0; w < nw; w++)
+				def(op.y, i)[w] = 0;
+		return;
+	}
+
+	if (op.kind <= OP_OAI4)
+	{
+		// bitwise operations, all operands have the width of Y
+		int num_args = 0;
+		while (num_args < 4 && op.arg_width[num_args] != 0)
+			num_args++;
+		for (int i = 0; i < op.y_width; i++)
+		for (int w = 0; w < nw; w++)
+		{
+			word_t a = 0, b = 0, c = 0, d = 0, dy = ~word_t(0);
+			word_t *args[4] = {&a, &b, &c, &d};
+			for (int k = 0; k < num_args; k++) {
+				*args[k] = val(op.arg[k], i)[w];
+				dy &= def(op.arg[k], i)[w];
+			}
+			word_t y = 0;
+			switch (op.kind) {
+				case OP_BUF: y = a; break;
+				case OP_NOT: y = ~a; break;
+				case OP_AND: y = a & b; break;
+				case OP_NAND: y = ~(a & b); break;
+				case OP_OR: y = a | b; break;
+				case OP_NOR: y = ~(a | b); break;
+				case OP_XOR: y = a ^ b; break;
+				case OP_XNOR: y = ~(a ^ b); break;
+				case OP_ANDNOT: y = a & ~b; break;
+				case OP_ORNOT: y = a | ~b; break;
+				case OP_MUX: y = (a & ~c) | (b & c); break;
+				case OP_NMUX: y = ~((a & ~c) | (b & c)); break;
+				case OP_AOI3: y = ~((a & b) | c); break;
+				case OP_OAI3: y = ~((a | b) & c); break;
+				case OP_AOI4: y = ~((a & b) | (c & d)); break;
+				case OP_OAI4: y = ~((a | b) & (c | d)); break;
+				default: log_abort();
+			}
+			val(op.y, i)[w] = y;
+			def(op.y, i)[w] = dy;
+		}
+		return;
+	}
+
+	for (int w = 0; w < nw; w++)
+	{
+		// all other operations depend on all input bits
+		word_t dy = ~word_t(0);
+		for (int k = 0; k < 2; k++)
+			for (int i = 0; i < op.arg_width[k]; i++)
+				dy &= def(op.arg[k], i)[w];
+
+		auto reduce_or = [&](int k) {
+			word_t r = 0;
+			for (int i = 0; i < op.arg_width[k]; i++)
+				r |= val(op.arg[k], i)[w];
+			return r;
+		};
+
+		// result for Y[0] of the single-bit operations
+		word_t y0 = 0;
+		bool single_bit = true;
+
+		switch (op.kind)
+		{
+		case OP_REDUCE_AND:
+			y0 = ~word_t(0);
+			for (int i = 0; i < op.arg_width[0]; i++)
+				y0 &= val(op.arg[0], i)[w];
+			break;
+		case OP_REDUCE_OR:
+			y0 = reduce_or(0);
+			break;
+		case OP_REDUCE_XOR:
+		case OP_REDUCE_XNOR:
+			for (int i = 0; i < op.arg_width[0]; i++)
+				y0 ^= val(op.arg[0], i)[w];
+			if (op.kind == OP_REDUCE_XNOR)
+				y0 = ~y0;
+			break;
+		case OP_LOGIC_NOT:
+			y0 = ~reduce_or(0);
+			break;
+		case OP_LOGIC_AND:
+			y0 = reduce_or(0) & reduce_or(1);
+			break;
+		case OP_LOGIC_OR:
+			y0 = reduce_or(0) | reduce_or(1);
+			break;
+		case OP_EQ:
+		case OP_NE:
+			y0 = ~word_t(0);
+			for (int i = 0; i < op.arg_width[0]; i++)
+				y0 &= ~(val(op.arg[0], i)[w] ^ val(op.arg[1], i)[w]);
+			if (op.kind == OP_NE)
+				y0 = ~y0;
+			break;
+		case OP_LT: case OP_LE: case OP_GT: case OP_GE: {
+			// sign of a-b (for LT/GE) or b-a (for GT/LE) on the extended operands
+			bool swap = op.kind == OP_GT || op.kind == OP_LE;
+			int lhs = swap ? op.arg[1] : op.arg[0], rhs = swap ? op.arg[0] : op.arg[1];
+			word_t carry = ~word_t(0), diff = 0;
+			for (int i = 0; i < op.arg_width[0]; i++) {
+				word_t a = val(lhs, i)[w], b = ~val(rhs, i)[w];
+				diff = a ^ b ^ carry;
+				carry = (a & b) | (carry & (a ^ b));
+			}
+			y0 = (op.kind == OP_LT || op.kind == OP_GT) ? diff : ~diff;
+			break;
+		}
+		case OP_ADD:
+		case OP_SUB: {
+			single_bit = false;
+			word_t carry = op.kind == OP_SUB ? ~word_t(0) : 0;
+			for (int i = 0; i < op.y_width; i++) {
+				word_t a = val(op.arg[0], i)[w], b = val(op.arg[1], i)[w];
+				if (op.kind == OP_SUB)
+					b = ~b;
+				val(op.y, i)[w] = a ^ b ^ carry;
+				def(op.y, i)[w] = dy;
+				carry = (a & b) | (carry & (a ^ b));
+			}
+			break;
+		}
+		default:
+			log_abort();
+		}
+
+		if (single_bit)
+			for (int i = 0; i < op.y_width; i++) {
+				val(op.y, i)[w] = i == 0 ? y0 : 0;
+				def(op.y, i)[w] = i == 0 ? dy : ~word_t(0);
+			}
+	}
+}
+
+void PatternEval::eval_all()
+{
+	for (auto &op : ops)
+		eval(op);
+}
+
+void PatternEval::randomize()
+{
+	auto set_random = [&](int bit) {
+		for (int w = 0; w < num_words_; w++) {
+			values[bit * num_words_ + w] = random_word();
+			defs[bit * num_words_ + w] = ~word_t(0);
+		}
+	};
+	for (int bit : free_bits)
+		set_random(bit);
+	for (auto &ff : flip_flops)
+		set_random(ff.q);
+	for (int bit : undef_ff_bits)
+		set_random(bit);
+	eval_all();
+}
+
+void PatternEval::step()
+{
+	int nw = num_words_;
+	std::vector<word_t> next_values(GetSize(flip_flops) * nw), next_defs(GetSize(flip_flops) * nw);
+	for (int i = 0; i < GetSize(flip_flops); i++)
+		for (int w = 0; w < nw; w++) {
+			next_values[i * nw + w] = values[flip_flops[i].d * nw + w];
+			next_defs[i * nw + w] = defs[flip_flops[i].d * nw + w];
+		}
+	for (int i = 0; i < GetSize(flip_flops); i++)
+		for (int w = 0; w < nw; w++) {
+			values[flip_flops[i].q * nw + w] = next_values[i * nw + w];
+			defs[flip_flops[i].q * nw + w] = next_defs[i * nw + w];
+		}
+
+	for (int bit : undef_ff_bits)
+		for (int w = 0; w < nw; w++)
+			defs[bit * nw + w] = 0;
+
+	for (int bit : free_bits)
+		for (int w = 0; w < nw; w++) {
+			values[bit * nw + w] = random_word();
+			defs[bit * nw + w] = ~word_t(0);
+		}
+	eval_all();
+}
+
+PatternEval::word_t PatternEval::differ(RTLIL::SigBit a, RTLIL::SigBit b, int word) const
+{
+	int ia = index(a) * num_words_ + word, ib = index(b) * num_words_ + word;
+	return (values[ia] ^ values[ib]) & defs[ia] & defs[ib];
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,112 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PATTERNEVAL_H
+#define PATTERNEVAL_H
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Bit-parallel simulation of a module on 64 * num_words random input
+// patterns at once. Every signal bit holds one word per 64 patterns for its
+// value and one for whether it is defined.
+//
+// Bits driven by a cell that is known to the CellTypes passed to the
+// constructor are computed from the cell, if it is a supported combinational
+// cell or a simple flip-flop. Outputs of other known cells, such as
+// multipliers, are undefined. All remaining bits, such as module inputs,
+// undriven wires and outputs of unknown cells, are free inputs that get
+// random defined values.
+//
+// Undefined inputs of a cell make all of its dependent outputs undefined,
+// which is never less pessimistic than SatGen. Two signals that are both
+// defined and differ in some pattern are therefore also different in a SAT
+// model of the same cells, and that check can be skipped.
+struct PatternEval
+{
+	typedef uint64_t word_t;
+
+	PatternEval(RTLIL::Module *module, const SigMap &sigmap, const CellTypes &ct, int num_words = 4, uint64_t seed = 1);
+
+	// assign new random values to all free inputs, set flip-flop outputs to
+	// random values and evaluate the combinational cells
+	void randomize();
+
+	// advance by one clock cycle: simple flip-flops load their D input, the
+	// outputs of other flip-flops become undefined, free inputs get new
+	// random values and the combinational cells are evaluated again
+	void step();
+
+	int num_words() const { return num_words_; }
+	int num_patterns() const { return 64 * num_words_; }
+
+	// pointers to num_words() words for a (sigmapped) bit
+	const word_t *value(RTLIL::SigBit bit) const { return &values[index(bit) * num_words_]; }
+	const word_t *defined(RTLIL::SigBit bit) const { return &defs[index(bit) * num_words_]; }
+
+	// the set of patterns (limited to the given word) for which both bits
+	// are defined and have different values
+	word_t differ(RTLIL::SigBit a, RTLIL::SigBit b, int word) const;
+
+private:
+	enum OpKind : char {
+		OP_BUF, OP_NOT, OP_AND, OP_NAND, OP_OR, OP_NOR, OP_XOR, OP_XNOR, OP_ANDNOT, OP_ORNOT,
+		OP_MUX, OP_NMUX, OP_AOI3, OP_OAI3, OP_AOI4, OP_OAI4,
+		OP_REDUCE_AND, OP_REDUCE_OR, OP_REDUCE_XOR, OP_REDUCE_XNOR, OP_LOGIC_NOT, OP_LOGIC_AND, OP_LOGIC_OR,
+		OP_EQ, OP_NE, OP_ADD, OP_SUB, OP_LT, OP_LE, OP_GT, OP_GE,
+		OP_UNDEF
+	};
+
+	// up to four operands, all stored as index ranges in operands
+	struct Op {
+		OpKind kind;
+		int y, y_width;
+		int arg[4], arg_width[4];
+	};
+
+	struct FlipFlop {
+		int d, q;
+	};
+
+	const SigMap &sigmap;
+	int num_words_;
+	uint64_t rng_state;
+
+	idict<RTLIL::SigBit> bit_index;
+	std::vector<word_t> values, defs;
+	std::vector<int> operands;
+	std::vector<Op> ops;
+	std::vector<int> free_bits, undef_ff_bits;
+	std::vector<FlipFlop> flip_flops;
+
+	int index(RTLIL::SigBit bit) const;
+	int add_operand(RTLIL::SigSpec sig, int width, bool is_signed);
+	int add_output(RTLIL::SigSpec sig);
+	bool add_comb_cell(RTLIL::Cell *cell, Op &op);
+	word_t random_word();
+	void eval(const Op &op);
+	void eval_all();
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
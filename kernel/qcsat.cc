@@ -38,6 +38,7 @@ int QuickConeSat::importSigBit(SigBit bit)
 
 void QuickConeSat::prepare()
 {
+	int imported_count = 0;
 	while (!bits_queue.empty())
 	{
 		pool<ModWalker::PortBit> portbits;
@@ -58,23 +59,71 @@ void QuickConeSat::prepare()
 
 		for (auto &pbit : portbits)
 		{
-			if (imported_cells.count(pbit.cell))
+			if (imported_cells.count(pbit.cell)) {
+				stat_reused++;
 				continue;
+			}
 			if (cell_complexity(pbit.cell) > max_cell_complexity)
 				continue;
 			if (max_cell_outs && GetSize(modwalker.cell_outputs[pbit.cell]) > max_cell_outs)
 				continue;
+			imported_cells.insert(pbit.cell);
+			imported_count++;
+			if (structural_hashing && import_merged(pbit.cell)) {
+				stat_merged++;
+				continue;
+			}
 			auto &inputs = modwalker.cell_inputs[pbit.cell];
 			bits_queue.insert(inputs.begin(), inputs.end());
 			satgen.importCell(pbit.cell);
-			imported_cells.insert(pbit.cell);
+			stat_imported++;
 		}
 
-		if (max_cell_count && GetSize(imported_cells) > max_cell_count)
+		if (max_cell_count && imported_count > max_cell_count)
 			break;
 	}
 }
 
+bool QuickConeSat::import_merged(RTLIL::Cell *cell)
+{
+	std::vector<std::pair<RTLIL::IdString, RTLIL::Const>> params(cell->parameters.begin(), cell->parameters.end());
+	std::vector<std::pair<RTLIL::IdString, RTLIL::SigSpec>> inputs, outputs;
+	for (auto &conn : cell->connections()) {
+		if (modwalker.ct.cell_output(cell->type, conn.first))
+			outputs.emplace_back(conn.first, conn.second);
+		else
+			inputs.emplace_back(conn.first, modwalker.sigmap(conn.second));
+	}
+	auto by_name = [](const auto &a, const auto &b) { return a.first < b.first; };
+	std::sort(params.begin(), params.end(), by_name);
+	std::sort(inputs.begin(), inputs.end(), by_name);
+
+	cell_key_t key(cell->type, std::move(params), std::move(inputs));
+	auto it = structural_cells.find(key);
+	if (it == structural_cells.end()) {
+		structural_cells.emplace(std::move(key), cell);
+		return false;
+	}
+
+	RTLIL::Cell *other = it->second;
+	for (auto &out : outputs) {
+		if (!other->hasPort(out.first) || GetSize(other->getPort(out.first)) != GetSize(out.second))
+			return false;
+	}
+	for (auto &out : outputs) {
+		std::vector<int> sig = satgen.importSigSpec(modwalker.sigmap(out.second));
+		std::vector<int> other_sig = satgen.importSigSpec(modwalker.sigmap(other->getPort(out.first)));
+		ez->assume(ez->vec_eq(sig, other_sig));
+	}
+	return true;
+}
+
+void QuickConeSat::log_stats(const char *indent) const
+{
+	log("%sSAT context: %d cells imported, %d merged with identical cells, %d reused; %d variables, %d clauses.\n",
+			indent, stat_imported, stat_merged, stat_reused, ez->numCnfVariables(), ez->numCnfClauses());
+}
+
 int QuickConeSat::cell_complexity(RTLIL::Cell *cell)
 {
 	if (cell->type.in(ID($concat), ID($slice), ID($pos), ID($buf), ID($_BUF_)))
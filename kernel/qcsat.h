@@ -33,6 +33,11 @@ YOSYS_NAMESPACE_BEGIN
 // skipped and the solver spuriously returns SAT with a solution that
 // cannot exist in reality due to skipped constraints (ie. only UNSAT results
 // from this class should be considered binding).
+//
+// One instance can (and should) be kept for many queries on the same module:
+// cells are imported only once, and queries are expected to pass their
+// conditions as assumptions to ez->solve() rather than adding them with
+// ez->assume(), so that the solver can keep everything it learned.
 struct QuickConeSat {
 	ModWalker &modwalker;
 	ezSatPtr ez;
@@ -46,16 +51,30 @@ struct QuickConeSat {
 	// - 3: shifts
 	// - 4: multiplication, division, power
 	int max_cell_complexity = 2;
-	// The maximum number of cells to import, or 0 for no limit.
+	// The maximum number of cells to import in one prepare() call, or 0 for
+	// no limit.
 	int max_cell_count = 0;
 	// If non-0, skip importing cells with more than this number of output bits.
 	int max_cell_outs = 0;
 
+	// If set, a cell with the same type, parameters and inputs as an already
+	// imported cell is not imported again, its outputs are tied to the
+	// outputs of that cell instead.
+	bool structural_hashing = true;
+
+	// Statistics: cells added to the solver, cells merged with an identical
+	// cell, and cells found in a cone that were already in the solver from
+	// an earlier query.
+	int stat_imported = 0, stat_merged = 0, stat_reused = 0;
+
 	// Internal state.
 	pool<RTLIL::Cell*> imported_cells;
 	pool<RTLIL::Wire*> imported_onehot;
 	pool<RTLIL::SigBit> bits_queue;
 
+	typedef std::tuple<RTLIL::IdString, std::vector<std::pair<RTLIL::IdString, RTLIL::Const>>, std::vector<std::pair<RTLIL::IdString, RTLIL::SigSpec>>> cell_key_t;
+	dict<cell_key_t, RTLIL::Cell*> structural_cells;
+
 	QuickConeSat(ModWalker &modwalker) : modwalker(modwalker), ez(), satgen(ez.get(), &modwalker.sigmap) {}
 
 	// Imports a signal into the SAT solver, queues its input cone to be
@@ -69,6 +88,12 @@ struct QuickConeSat {
 
 	// Returns the "complexity level" of a given cell.
 	static int cell_complexity(RTLIL::Cell *cell);
+
+	// Logs the statistics and the size of the SAT problem.
+	void log_stats(const char *indent = "") const;
+
+private:
+	bool import_merged(RTLIL::Cell *cell);
 };
 
 YOSYS_NAMESPACE_END
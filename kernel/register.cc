@@ -21,6 +21,7 @@
 #include "kernel/satgen.h"
 #include "kernel/json.h"
 #include "kernel/gzip.h"
+#include "kernel/tracing.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -98,6 +99,7 @@ Pass::pre_post_exec_state_t Pass::pre_execute()
 	state.begin_ns = PerformanceTimer::query();
 	state.parent_pass = current_pass;
 	current_pass = this;
+	trace_pass_begin(this, state.parent_pass);
 	clear_flags();
 	return state;
 }
@@ -106,6 +108,7 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 {
 	IdString::checkpoint();
 	log_suppressed();
+	trace_pass_end(this);
 
 	int64_t time_ns = PerformanceTimer::query() - state.begin_ns;
 	runtime_ns += time_ns;
@@ -256,11 +259,16 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 		log_experimental("%s", args[0].c_str());
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
+	trace_command(args);
 	auto state = pass_register[args[0]]->pre_execute();
 	pass_register[args[0]]->execute(args, design);
 	pass_register[args[0]]->post_execute(state);
 	while (design->selection_stack.size() > orig_sel_stack_pos)
 		design->pop_selection();
+
+	// see RTLIL::Module::sigmap()
+	for (auto module : design->modules())
+		module->invalidate_sigmap();
 }
 
 void Pass::call_on_selection(RTLIL::Design *design, const RTLIL::Selection &selection, std::string command)
@@ -867,7 +875,7 @@ struct HelpPass : public Pass {
 
 		// iterate over cells
 		bool raise_error = false;
-		for (auto &it : yosys_celltypes.cell_types) {
+		for (auto &it : yosys_celltypes.all_types()) {
 			auto name = it.first.str();
 			if (cell_help_messages.contains(name)) {
 				auto cell_help = cell_help_messages.get(name);
@@ -996,7 +1004,7 @@ struct HelpPass : public Pass {
 			// this option is also undocumented as it is for internal use only
 			else if (args[1] == "-write-rst-cells-manual") {
 				bool raise_error = false;
-				for (auto &it : yosys_celltypes.cell_types) {
+				for (auto &it : yosys_celltypes.all_types()) {
 					auto name = it.first.str();
 					if (cell_help_messages.contains(name)) {
 						write_cell_rst(cell_help_messages.get(name), it.second);
@@ -1299,12 +1299,13 @@ RTLIL::Module::Module()
 
 RTLIL::Module::~Module()
 {
+	delete sigmap_;
 	for (auto &pr : wires_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : memories)
 		delete pr.second;
 	for (auto &pr : cells_)
-		delete pr.second;
+		destroy(pr.second);
 	for (auto &pr : processes)
 		delete pr.second;
 	for (auto binding : bindings_)
@@ -1335,7 +1336,7 @@ void RTLIL::Module::makeblackbox()
 	memories.clear();
 
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	cells_.clear();
 
 	for (auto it = processes.begin(); it != processes.end(); ++it)
@@ -2507,6 +2508,7 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 		void operator()(RTLIL::SigSpec &sig)
 		{
 			sig.pack();
+			sig.hash_ = 0;
 			for (auto &c : sig.chunks_)
 				if (c.wire != NULL)
 					c.wire = mod->wires_.at(c.wire->name);
@@ -2658,6 +2660,7 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 
 		void operator()(RTLIL::SigSpec &sig) {
 			sig.pack();
+			sig.hash_ = 0;
 			for (auto &c : sig.chunks_)
 				if (c.wire != NULL && wires_p->count(c.wire)) {
 					c.wire = module->addWire(stringf("$delete_wire$%d", autoidx++), c.width);
@@ -2677,11 +2680,12 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 	delete_wire_worker.module = this;
 	delete_wire_worker.wires_p = &wires;
 	rewrite_sigspecs2(delete_wire_worker);
+	invalidate_sigmap();
 
 	for (auto &it : wires) {
 		log_assert(wires_.count(it->name) != 0);
 		wires_.erase(it->name);
-		delete it;
+		destroy(it);
 	}
 }
 
@@ -2693,7 +2697,7 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	log_assert(cells_.count(cell->name) != 0);
 	log_assert(refcount_cells_ == 0);
 	cells_.erase(cell->name);
-	delete cell;
+	destroy(cell);
 }
 
 void RTLIL::Module::remove(RTLIL::Process *process)
@@ -2703,6 +2707,18 @@ void RTLIL::Module::remove(RTLIL::Process *process)
 	delete process;
 }
 
+void RTLIL::Module::destroy(RTLIL::Wire *wire)
+{
+	wire->~Wire();
+	wire_slab_.release(wire);
+}
+
+void RTLIL::Module::destroy(RTLIL::Cell *cell)
+{
+	cell->~Cell();
+	cell_slab_.release(cell);
+}
+
 void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
 {
 	log_assert(wires_[wire->name] == wire);
@@ -2710,6 +2726,8 @@ void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
 	wires_.erase(wire->name);
 	wire->name = new_name;
 	add(wire);
+	// SigBit hashes depend on the wire name
+	invalidate_sigmap();
 }
 
 void RTLIL::Module::rename(RTLIL::Cell *cell, RTLIL::IdString new_name)
@@ -2745,6 +2763,7 @@ void RTLIL::Module::swap_names(RTLIL::Wire *w1, RTLIL::Wire *w2)
 
 	wires_[w1->name] = w1;
 	wires_[w2->name] = w2;
+	invalidate_sigmap();
 }
 
 void RTLIL::Module::swap_names(RTLIL::Cell *c1, RTLIL::Cell *c2)
@@ -2851,6 +2870,19 @@ void RTLIL::Module::new_connections(const std::vector<RTLIL::SigSig> &new_conn)
 	connections_ = new_conn;
 }
 
+const SigMap &RTLIL::Module::sigmap()
+{
+	if (sigmap_ == nullptr)
+		sigmap_ = new IncrementalSigMap(this);
+	return sigmap_->get();
+}
+
+void RTLIL::Module::invalidate_sigmap()
+{
+	if (sigmap_ != nullptr)
+		sigmap_->invalidate();
+}
+
 const std::vector<RTLIL::SigSig> &RTLIL::Module::connections() const
 {
 	return connections_;
@@ -2877,7 +2909,7 @@ void RTLIL::Module::fixup_ports()
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
+	RTLIL::Wire *wire = new (wire_slab_.allocate()) RTLIL::Wire;
 	wire->name = name;
 	wire->width = width;
 	add(wire);
@@ -2900,7 +2932,7 @@ RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *oth
 
 RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
 {
-	RTLIL::Cell *cell = new RTLIL::Cell;
+	RTLIL::Cell *cell = new (cell_slab_.allocate()) RTLIL::Cell;
 	cell->name = name;
 	cell->type = type;
 	add(cell);
@@ -3922,11 +3954,14 @@ RTLIL::SigSpec RTLIL::Module::FutureFF(RTLIL::IdString name, const RTLIL::SigSpe
 	return sig;
 }
 
+int64_t RTLIL::Wire::live_count = 0;
+
 RTLIL::Wire::Wire()
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
 	hashidx_ = hashidx_count;
+	live_count++;
 
 	module = nullptr;
 	width = 1;
@@ -3944,6 +3979,7 @@ RTLIL::Wire::Wire()
 
 RTLIL::Wire::~Wire()
 {
+	live_count--;
 #ifdef WITH_PYTHON
 	RTLIL::Wire::get_all_wires()->erase(hashidx_);
 #endif
@@ -3978,11 +4014,14 @@ RTLIL::Process::Process() : module(nullptr)
 	hashidx_ = hashidx_count;
 }
 
+int64_t RTLIL::Cell::live_count = 0;
+
 RTLIL::Cell::Cell() : module(nullptr)
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
 	hashidx_ = hashidx_count;
+	live_count++;
 
 	// log("#memtrace# %p\n", this);
 	memhasher();
@@ -3994,6 +4033,7 @@ RTLIL::Cell::Cell() : module(nullptr)
 
 RTLIL::Cell::~Cell()
 {
+	live_count--;
 #ifdef WITH_PYTHON
 	RTLIL::Cell::get_all_cells()->erase(hashidx_);
 #endif
@@ -4436,6 +4476,94 @@ bool RTLIL::SigChunk::operator !=(const RTLIL::SigChunk &other) const
 	return true;
 }
 
+RTLIL::SigChunkVector::SigChunkVector(const RTLIL::SigChunkVector &other) : heap_(other.heap_), has_chunk_(other.has_chunk_)
+{
+	if (heap_)
+		new ((void*)&vec_) chunkvectype(other.vec_);
+	else if (has_chunk_)
+		new ((void*)&chunk_) RTLIL::SigChunk(other.chunk_);
+}
+
+RTLIL::SigChunkVector::SigChunkVector(RTLIL::SigChunkVector &&other) : heap_(other.heap_), has_chunk_(other.has_chunk_)
+{
+	if (heap_)
+		new ((void*)&vec_) chunkvectype(std::move(other.vec_));
+	else if (has_chunk_)
+		new ((void*)&chunk_) RTLIL::SigChunk(std::move(other.chunk_));
+	other.clear();
+}
+
+RTLIL::SigChunkVector::SigChunkVector(const std::vector<RTLIL::SigChunk> &chunks) : heap_(false), has_chunk_(false)
+{
+	reserve(chunks.size());
+	for (auto &chunk : chunks)
+		push_back(chunk);
+}
+
+RTLIL::SigChunkVector &RTLIL::SigChunkVector::operator=(const RTLIL::SigChunkVector &other)
+{
+	if (this == &other)
+		return *this;
+	if (heap_ && other.heap_) {
+		vec_ = other.vec_;
+		return *this;
+	}
+	clear();
+	if (other.heap_) {
+		new ((void*)&vec_) chunkvectype(other.vec_);
+		heap_ = true;
+	} else if (other.has_chunk_) {
+		new ((void*)&chunk_) RTLIL::SigChunk(other.chunk_);
+		has_chunk_ = true;
+	}
+	return *this;
+}
+
+RTLIL::SigChunkVector &RTLIL::SigChunkVector::operator=(RTLIL::SigChunkVector &&other)
+{
+	if (this == &other)
+		return *this;
+	clear();
+	if (other.heap_) {
+		new ((void*)&vec_) chunkvectype(std::move(other.vec_));
+		heap_ = true;
+	} else if (other.has_chunk_) {
+		new ((void*)&chunk_) RTLIL::SigChunk(std::move(other.chunk_));
+		has_chunk_ = true;
+	}
+	other.clear();
+	return *this;
+}
+
+void RTLIL::SigChunkVector::move_to_heap(size_t capacity)
+{
+	log_assert(!heap_);
+	chunkvectype vec;
+	vec.reserve(capacity);
+	if (has_chunk_) {
+		vec.push_back(std::move(chunk_));
+		chunk_.~SigChunk();
+		has_chunk_ = false;
+	}
+	new ((void*)&vec_) chunkvectype(std::move(vec));
+	heap_ = true;
+}
+
+void RTLIL::SigChunkVector::clear()
+{
+	if (heap_) {
+		vec_.~chunkvectype();
+		heap_ = false;
+	} else if (has_chunk_) {
+		chunk_.~SigChunk();
+		has_chunk_ = false;
+	}
+}
+
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+std::atomic<int64_t> RTLIL::SigSpec::LiveCounter::count;
+#endif
+
 RTLIL::SigSpec::SigSpec(std::initializer_list<RTLIL::SigSpec> parts)
 {
 	cover("kernel.rtlil.sigspec.init.list");
@@ -4653,6 +4781,17 @@ void RTLIL::SigSpec::pack() const
 	std::vector<RTLIL::SigBit> old_bits;
 	old_bits.swap(that->bits_);
 
+	// count the chunks first, so that chunks_ is allocated only once
+	// and a single chunk ends up in the inline storage
+	int num_chunks = 0;
+	const RTLIL::SigBit *prev = NULL;
+	for (auto &bit : old_bits) {
+		if (!prev || bit.wire != prev->wire || (bit.wire != NULL && bit.offset != prev->offset + 1))
+			num_chunks++;
+		prev = &bit;
+	}
+	that->chunks_.reserve(num_chunks);
+
 	RTLIL::SigChunk *last = NULL;
 	int last_end_offset = 0;
 
@@ -4691,8 +4830,9 @@ void RTLIL::SigSpec::unpack() const
 		for (int i = 0; i < c.width; i++)
 			that->bits_.emplace_back(c, i);
 
+	// releases the chunk storage, the hash stays valid as it doesn't
+	// depend on the representation
 	that->chunks_.clear();
-	that->hash_ = 0;
 }
 
 void RTLIL::SigSpec::updhash() const
@@ -4724,6 +4864,7 @@ void RTLIL::SigSpec::sort()
 {
 	unpack();
 	cover("kernel.rtlil.sigspec.sort");
+	hash_ = 0;
 	std::sort(bits_.begin(), bits_.end());
 }
 
@@ -4758,6 +4899,7 @@ void RTLIL::SigSpec::replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec
 	with.unpack();
 	unpack();
 	other->unpack();
+	other->hash_ = 0;
 
 	dict<RTLIL::SigBit, int> pattern_to_with;
 	for (int i = 0; i < GetSize(pattern.bits_); i++) {
@@ -4791,6 +4933,7 @@ void RTLIL::SigSpec::replace(const dict<RTLIL::SigBit, RTLIL::SigBit> &rules, RT
 	if (rules.empty()) return;
 	unpack();
 	other->unpack();
+	other->hash_ = 0;
 
 	for (int i = 0; i < GetSize(bits_); i++) {
 		auto it = rules.find(bits_[i]);
@@ -4816,6 +4959,7 @@ void RTLIL::SigSpec::replace(const std::map<RTLIL::SigBit, RTLIL::SigBit> &rules
 	if (rules.empty()) return;
 	unpack();
 	other->unpack();
+	other->hash_ = 0;
 
 	for (int i = 0; i < GetSize(bits_); i++) {
 		auto it = rules.find(bits_[i]);
@@ -4845,9 +4989,11 @@ void RTLIL::SigSpec::remove2(const RTLIL::SigSpec &pattern, RTLIL::SigSpec *othe
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	hash_ = 0;
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->hash_ = 0;
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--)
@@ -4890,10 +5036,12 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::SigBit> &pattern, RTLIL::SigSpec
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	hash_ = 0;
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->hash_ = 0;
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
@@ -4918,10 +5066,12 @@ void RTLIL::SigSpec::remove2(const std::set<RTLIL::SigBit> &pattern, RTLIL::SigS
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	hash_ = 0;
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->hash_ = 0;
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
@@ -4946,10 +5096,12 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::Wire*> &pattern, RTLIL::SigSpec *
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	hash_ = 0;
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->hash_ = 0;
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
@@ -5034,6 +5186,7 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 
 	unpack();
 	with.unpack();
+	hash_ = 0;
 
 	log_assert(offset >= 0);
 	log_assert(with.width_ >= 0);
@@ -5051,7 +5204,7 @@ void RTLIL::SigSpec::remove_const()
 	{
 		cover("kernel.rtlil.sigspec.remove_const.packed");
 
-		std::vector<RTLIL::SigChunk> new_chunks;
+		RTLIL::SigChunkVector new_chunks;
 		new_chunks.reserve(GetSize(chunks_));
 
 		width_ = 0;
@@ -5067,7 +5220,7 @@ void RTLIL::SigSpec::remove_const()
 				width_ += chunk.width;
 			}
 
-		chunks_.swap(new_chunks);
+		chunks_ = std::move(new_chunks);
 	}
 	else
 	{
@@ -5084,6 +5237,7 @@ void RTLIL::SigSpec::remove_const()
 		width_ = bits_.size();
 	}
 
+	hash_ = 0;
 	check();
 }
 
@@ -5092,6 +5246,7 @@ void RTLIL::SigSpec::remove(int offset, int length)
 	cover("kernel.rtlil.sigspec.remove_pos");
 
 	unpack();
+	hash_ = 0;
 
 	log_assert(offset >= 0);
 	log_assert(length >= 0);
@@ -5176,6 +5331,7 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 		bits_.insert(bits_.end(), signal.bits_.begin(), signal.bits_.end());
 
 	width_ += signal.width_;
+	hash_ = 0;
 	check();
 }
 
@@ -5207,6 +5363,7 @@ void RTLIL::SigSpec::append(const RTLIL::SigBit &bit)
 	}
 
 	width_++;
+	hash_ = 0;
 	check();
 }
 
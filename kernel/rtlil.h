@@ -26,8 +26,15 @@
 #include <string_view>
 #include <unordered_map>
 
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+#  include <atomic>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
+struct SigMap;
+struct IncrementalSigMap;
+
 namespace RTLIL
 {
 	enum State : unsigned char {
@@ -94,6 +101,7 @@ namespace RTLIL
 	struct Memory;
 	struct Cell;
 	struct SigChunk;
+	struct SigChunkVector;
 	struct SigBit;
 	struct SigSpecIterator;
 	struct SigSpecConstIterator;
@@ -105,6 +113,7 @@ namespace RTLIL
 	struct Process;
 	struct Binding;
 	struct IdString;
+	template<typename T> struct ObjectSlab;
 
 	typedef std::pair<SigSpec, SigSpec> SigSig;
 };
@@ -1024,14 +1033,115 @@ struct RTLIL::SigSpecConstIterator
 	inline void operator++() { index++; }
 };
 
+// Storage for the chunks of a packed SigSpec. Behaves like a (minimal)
+// std::vector<SigChunk>, but keeps a single chunk inline: most signals in
+// gate-level netlists are a single wire or a single bit, and this way they
+// don't need a heap allocation. clear() releases the heap storage.
+struct RTLIL::SigChunkVector
+{
+	typedef RTLIL::SigChunk value_type;
+	typedef RTLIL::SigChunk *iterator;
+	typedef const RTLIL::SigChunk *const_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	typedef size_t size_type;
+
+private:
+	using chunkvectype = std::vector<RTLIL::SigChunk>;
+	// if heap_ is false then chunk_ holds the only chunk when has_chunk_ is
+	// set and is not constructed otherwise
+	bool heap_;
+	bool has_chunk_;
+	union {
+		RTLIL::SigChunk chunk_;
+		chunkvectype vec_;
+	};
+
+	void move_to_heap(size_t capacity);
+
+public:
+	SigChunkVector() : heap_(false), has_chunk_(false) {}
+	SigChunkVector(const SigChunkVector &other);
+	SigChunkVector(SigChunkVector &&other);
+	SigChunkVector(const std::vector<RTLIL::SigChunk> &chunks);
+	SigChunkVector &operator=(const SigChunkVector &other);
+	SigChunkVector &operator=(SigChunkVector &&other);
+	~SigChunkVector() { clear(); }
+
+	inline bool is_inline() const { return !heap_; }
+
+	inline size_t size() const { return heap_ ? vec_.size() : has_chunk_; }
+	inline bool empty() const { return size() == 0; }
+
+	inline RTLIL::SigChunk *data() { return heap_ ? vec_.data() : &chunk_; }
+	inline const RTLIL::SigChunk *data() const { return heap_ ? vec_.data() : &chunk_; }
+
+	inline iterator begin() { return data(); }
+	inline iterator end() { return data() + size(); }
+	inline const_iterator begin() const { return data(); }
+	inline const_iterator end() const { return data() + size(); }
+	inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	inline RTLIL::SigChunk &operator[](size_t index) { return data()[index]; }
+	inline const RTLIL::SigChunk &operator[](size_t index) const { return data()[index]; }
+	inline const RTLIL::SigChunk &at(size_t index) const { log_assert(index < size()); return data()[index]; }
+	inline RTLIL::SigChunk &front() { return data()[0]; }
+	inline const RTLIL::SigChunk &front() const { return data()[0]; }
+	inline RTLIL::SigChunk &back() { return data()[size() - 1]; }
+	inline const RTLIL::SigChunk &back() const { return data()[size() - 1]; }
+
+	template<typename... Args>
+	RTLIL::SigChunk &emplace_back(Args &&...args) {
+		if (heap_)
+			return vec_.emplace_back(std::forward<Args>(args)...);
+		if (!has_chunk_) {
+			new ((void*)&chunk_) RTLIL::SigChunk(std::forward<Args>(args)...);
+			has_chunk_ = true;
+			return chunk_;
+		}
+		// the arguments may refer to chunk_, construct before moving it
+		RTLIL::SigChunk chunk(std::forward<Args>(args)...);
+		move_to_heap(2);
+		return vec_.emplace_back(std::move(chunk));
+	}
+	inline void push_back(const RTLIL::SigChunk &chunk) { emplace_back(chunk); }
+	inline void push_back(RTLIL::SigChunk &&chunk) { emplace_back(std::move(chunk)); }
+
+	void reserve(size_t capacity) {
+		if (heap_)
+			vec_.reserve(capacity);
+		else if (capacity > 1)
+			move_to_heap(capacity);
+	}
+	void clear();
+
+	operator std::vector<RTLIL::SigChunk>() const { return std::vector<RTLIL::SigChunk>(begin(), end()); }
+
+	bool operator==(const SigChunkVector &other) const { return std::equal(begin(), end(), other.begin(), other.end()); }
+	bool operator!=(const SigChunkVector &other) const { return !(*this == other); }
+};
+
 struct RTLIL::SigSpec
 {
 private:
 	int width_;
 	Hasher::hash_t hash_;
-	std::vector<RTLIL::SigChunk> chunks_; // LSB at index 0
+	// Only one of chunks_ and bits_ is in use at any time, see pack() and
+	// unpack(). hash_ is 0 when not computed yet, it is kept across const
+	// accesses that convert between the two forms.
+	RTLIL::SigChunkVector chunks_; // LSB at index 0
 	std::vector<RTLIL::SigBit> bits_; // LSB at index 0
 
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+	struct LiveCounter {
+		static std::atomic<int64_t> count;
+		LiveCounter() { count++; }
+		LiveCounter(const LiveCounter &) { count++; }
+		~LiveCounter() { count--; }
+		LiveCounter &operator=(const LiveCounter &) { return *this; }
+	} live_counter_;
+#endif
+
 	void pack() const;
 	void unpack() const;
 	void updhash() const;
@@ -1069,13 +1179,18 @@ public:
 	SigSpec(const std::set<RTLIL::SigBit> &bits);
 	explicit SigSpec(bool bit);
 
-	inline const std::vector<RTLIL::SigChunk> &chunks() const { pack(); return chunks_; }
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+	// number of SigSpec objects currently alive, see "internal_stats"
+	static int64_t live_count() { return LiveCounter::count; }
+#endif
+
+	inline const RTLIL::SigChunkVector &chunks() const { pack(); return chunks_; }
 	inline const std::vector<RTLIL::SigBit> &bits() const { inline_unpack(); return bits_; }
 
 	inline int size() const { return width_; }
 	inline bool empty() const { return width_ == 0; }
 
-	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); return bits_.at(index); }
+	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); hash_ = 0; return bits_.at(index); }
 	inline const RTLIL::SigBit &operator[](int index) const { inline_unpack(); return bits_.at(index); }
 
 	inline RTLIL::SigSpecIterator begin() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = 0; return it; }
@@ -1132,7 +1247,7 @@ public:
 
 	RTLIL::SigSpec repeat(int num) const;
 
-	void reverse() { inline_unpack(); std::reverse(bits_.begin(), bits_.end()); }
+	void reverse() { inline_unpack(); hash_ = 0; std::reverse(bits_.begin(), bits_.end()); }
 
 	bool operator <(const RTLIL::SigSpec &other) const;
 	bool operator ==(const RTLIL::SigSpec &other) const;
@@ -1486,6 +1601,54 @@ struct RTLIL::Design
 #endif
 };
 
+// Memory for objects of one type, allocated in blocks of increasing size.
+// Released slots are kept on a free list and reused. Module uses this for
+// its wires and cells so that they are close together in memory, and so
+// that destroying a module only frees a few blocks. This only manages the
+// memory, the owner constructs and destroys the objects.
+template<typename T>
+struct RTLIL::ObjectSlab
+{
+	ObjectSlab() {}
+	ObjectSlab(const ObjectSlab &) = delete;
+	ObjectSlab &operator=(const ObjectSlab &) = delete;
+
+	void *allocate() {
+		if (free_list != nullptr) {
+			Slot *slot = free_list;
+			free_list = slot->next;
+			return slot;
+		}
+		if (blocks.empty() || last_used == last_size) {
+			last_size = blocks.empty() ? 16 : std::min(2 * last_size, 4096);
+			blocks.emplace_back(new Slot[last_size]);
+			num_slots += last_size;
+			last_used = 0;
+		}
+		return &blocks.back()[last_used++];
+	}
+
+	void release(void *ptr) {
+		Slot *slot = static_cast<Slot*>(ptr);
+		slot->next = free_list;
+		free_list = slot;
+	}
+
+	// heap memory held, including free slots
+	size_t capacity_bytes() const { return num_slots * sizeof(Slot); }
+
+private:
+	union Slot {
+		Slot *next;
+		alignas(T) unsigned char storage[sizeof(T)];
+		Slot() {}
+	};
+	std::vector<std::unique_ptr<Slot[]>> blocks;
+	int last_used = 0, last_size = 0;
+	size_t num_slots = 0;
+	Slot *free_list = nullptr;
+};
+
 struct RTLIL::Module : public RTLIL::NamedObject
 {
 	Hasher::hash_t hashidx_;
@@ -1496,6 +1659,11 @@ protected:
 	void add(RTLIL::Cell *cell);
 	void add(RTLIL::Process *process);
 
+	RTLIL::ObjectSlab<RTLIL::Wire> wire_slab_;
+	RTLIL::ObjectSlab<RTLIL::Cell> cell_slab_;
+	void destroy(RTLIL::Wire *wire);
+	void destroy(RTLIL::Cell *cell);
+
 public:
 	RTLIL::Design *design;
 	pool<RTLIL::Monitor*> monitors;
@@ -1527,6 +1695,9 @@ public:
 	virtual void optimize();
 	virtual void makeblackbox();
 
+	// memory held for the wire and cell objects of this module
+	size_t object_bytes() const { return wire_slab_.capacity_bytes() + cell_slab_.capacity_bytes(); }
+
 	bool get_blackbox_attribute(bool ignore_wb=false) const {
 		return get_bool_attribute(ID::blackbox) || (!ignore_wb && get_bool_attribute(ID::whitebox));
 	}
@@ -1536,6 +1707,17 @@ public:
 	void new_connections(const std::vector<RTLIL::SigSig> &new_conn);
 	const std::vector<RTLIL::SigSig> &connections() const;
 
+	// SigMap of all connections in this module that is kept up to date by
+	// connect() and rebuilt on demand after new_connections() or removing
+	// or renaming wires. Borrowing it avoids rebuilding a SigMap for every
+	// module in a pass. Code that modifies connections_ directly must call
+	// invalidate_sigmap() afterwards. Pass::call() invalidates it after
+	// every command, so such code outside of the kernel can only make it
+	// stale for the rest of the same command.
+	IncrementalSigMap *sigmap_ = nullptr;
+	const SigMap &sigmap();
+	void invalidate_sigmap();
+
 	std::vector<RTLIL::IdString> ports;
 	void fixup_ports();
 
@@ -1872,6 +2054,9 @@ public:
 	int width, start_offset, port_id;
 	bool port_input, port_output, upto, is_signed;
 
+	// number of wires currently allocated, see "internal_stats"
+	static int64_t live_count;
+
 	RTLIL::Cell *driverCell() const    { log_assert(driverCell_); return driverCell_; };
 	RTLIL::IdString driverPort() const { log_assert(driverCell_); return driverPort_; };
 
@@ -1932,6 +2117,9 @@ public:
 	dict<RTLIL::IdString, RTLIL::SigSpec> connections_;
 	dict<RTLIL::IdString, RTLIL::Const> parameters;
 
+	// number of cells currently allocated, see "internal_stats"
+	static int64_t live_count;
+
 	// access cell ports
 	bool hasPort(const RTLIL::IdString &portname) const;
 	void unsetPort(const RTLIL::IdString &portname);
@@ -2111,6 +2299,7 @@ void RTLIL::Module::rewrite_sigspecs(T &functor)
 		functor(it.first);
 		functor(it.second);
 	}
+	invalidate_sigmap();
 }
 
 template<typename T>
@@ -2123,6 +2312,7 @@ void RTLIL::Module::rewrite_sigspecs2(T &functor)
 	for (auto &it : connections_) {
 		functor(it.first, it.second);
 	}
+	invalidate_sigmap();
 }
 
 template<typename T>
@@ -362,6 +362,62 @@ struct SigMap
 	}
 };
 
+// The SigMap behind RTLIL::Module::sigmap(). It is owned by the module and
+// follows module->connect() calls through the RTLIL::Monitor interface.
+// Changes that can remove connections only mark it invalid and it is
+// rebuilt on the next access.
+struct IncrementalSigMap : public RTLIL::Monitor
+{
+	RTLIL::Module *module;
+	SigMap sigmap;
+	bool valid = false;
+
+	IncrementalSigMap(RTLIL::Module *module) : module(module)
+	{
+		module->monitors.insert(this);
+	}
+
+	~IncrementalSigMap()
+	{
+		module->monitors.erase(this);
+	}
+
+	const SigMap &get()
+	{
+		if (!valid) {
+			sigmap.set(module);
+			valid = true;
+		}
+		return sigmap;
+	}
+
+	// Keep the old contents so references handed out earlier stay usable
+	// until the next get()
+	void invalidate()
+	{
+		valid = false;
+	}
+
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override
+	{
+		log_assert(module == mod);
+		if (valid)
+			sigmap.add(sigsig.first, sigsig.second);
+	}
+
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&) override
+	{
+		log_assert(module == mod);
+		invalidate();
+	}
+
+	void notify_blackout(RTLIL::Module *mod) override
+	{
+		log_assert(module == mod);
+		invalidate();
+	}
+};
+
 YOSYS_NAMESPACE_END
 
 #endif /* SIGTOOLS_H */
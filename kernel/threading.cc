@@ -0,0 +1,63 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/threading.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+int ThreadPool::pool_size(int reserved_cores, int max_threads)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	int available = std::thread::hardware_concurrency();
+	const char *env = getenv("YOSYS_MAX_THREADS");
+	if (env != nullptr) {
+		int env_max = atoi(env);
+		if (env_max > 0 && (available == 0 || env_max < available))
+			available = env_max;
+	}
+	int size = std::min(available - reserved_cores, max_threads);
+	return std::max(size, 0);
+#else
+	(void)reserved_cores;
+	(void)max_threads;
+	return 0;
+#endif
+}
+
+ThreadPool::ThreadPool(int num_threads, std::function<void(int)> body) : body(body)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	threads.reserve(num_threads);
+	for (int i = 0; i < num_threads; i++)
+		threads.emplace_back([this, i] { this->body(i); });
+#else
+	log_assert(num_threads == 0);
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	for (auto &t : threads)
+		t.join();
+#endif
+}
+
+YOSYS_NAMESPACE_END
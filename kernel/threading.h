@@ -0,0 +1,121 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys_common.h"
+
+#include <deque>
+#ifdef YOSYS_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+// Minimal helpers for running work on worker threads. Yosys data structures
+// (RTLIL, IdString, log) are not thread safe: worker threads must only touch
+// data that is private to them or explicitly synchronized, and hand results
+// back to the main thread for anything that modifies the design or logs.
+//
+// Without ENABLE_THREADS=1 all pools have size zero and callers are expected
+// to do the work on the calling thread instead.
+
+class ThreadPool
+{
+public:
+	// Number of worker threads to use for a job that can use up to
+	// max_threads threads, leaving reserved_cores cores for the calling
+	// thread. Returns 0 when the job should run on the calling thread.
+	// The YOSYS_MAX_THREADS environment variable limits the result.
+	static int pool_size(int reserved_cores, int max_threads);
+
+	// Start num_threads threads, each running body(thread_index)
+	ThreadPool(int num_threads, std::function<void(int)> body);
+	// Waits for all threads to return
+	~ThreadPool();
+
+	int num_threads() const { return GetSize(threads); }
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+private:
+	std::function<void(int)> body;
+#ifdef YOSYS_ENABLE_THREADS
+	std::vector<std::thread> threads;
+#else
+	std::vector<int> threads;
+#endif
+};
+
+// Unbounded FIFO for handing work items between threads. pop_front() blocks
+// until an item is available or the queue was closed.
+template<typename T>
+class ConcurrentQueue
+{
+public:
+	void push_back(T item) {
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		items.push_back(std::move(item));
+		cond.notify_one();
+#else
+		items.push_back(std::move(item));
+#endif
+	}
+
+	// Make all current and future pop_front() calls on an empty queue
+	// return std::nullopt
+	void close() {
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		closed = true;
+		cond.notify_all();
+#else
+		closed = true;
+#endif
+	}
+
+	std::optional<T> pop_front() {
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this] { return closed || !items.empty(); });
+#endif
+		if (items.empty())
+			return std::nullopt;
+		std::optional<T> item = std::move(items.front());
+		items.pop_front();
+		return item;
+	}
+
+private:
+#ifdef YOSYS_ENABLE_THREADS
+	std::mutex mutex;
+	std::condition_variable cond;
+#endif
+	std::deque<T> items;
+	bool closed = false;
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -21,6 +21,9 @@
 #define TOPO_SCC_H
 
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
+
+#include <atomic>
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -352,6 +355,337 @@ public:
     }
 };
 
+// Computes the same SCCs as TopoSortedSccs, but also partitions them into
+// levels such that all successors of a component are in lower levels. The
+// components of one level don't depend on each other and can be processed
+// in parallel, and processing the levels in increasing order visits
+// successors before predecessors, like the order of TopoSortedSccs.
+//
+// Acyclic parts of the graph are levelized by trimming waves of nodes whose
+// successors (or predecessors) were all trimmed already, with large waves
+// split across worker threads. Only the remaining core, which contains all
+// cycles, goes through the sequential TopoSortedSccs.
+//
+// enumerate_successors() is called concurrently from several threads, so it
+// must not modify the graph. All dfs_index values must be -1 initially and
+// are INT_MAX when done, as with TopoSortedSccs.
+template<typename G>
+class LevelizedSccs
+{
+    typedef typename G::node_enumerator node_enumerator;
+    typedef typename G::successor_enumerator successor_enumerator;
+
+public:
+    typedef typename G::node_type node_type;
+
+    // all nodes of the graph, grouped into components ordered by level
+    std::vector<node_type> nodes;
+    // component c consists of nodes[component_begin[c]] .. nodes[component_begin[c+1]-1]
+    std::vector<int> component_begin;
+    // level l consists of the components level_begin[l] .. level_begin[l+1]-1
+    std::vector<int> level_begin;
+
+    int num_components() const { return GetSize(component_begin) - 1; }
+    int num_levels() const { return GetSize(level_begin) - 1; }
+
+    // waves with fewer nodes than min_wave_size are processed on the calling thread
+    LevelizedSccs(G &graph, int max_threads = 16, int min_wave_size = 4096)
+    : graph(graph), min_wave_size(min_wave_size)
+    {
+        num_workers = ThreadPool::pool_size(1, max_threads - 1);
+        build_edges();
+        trim_backward();
+        trim_forward();
+        process_core();
+        levelize_forward();
+        collect();
+    }
+
+    // invoke callback(begin, end) for each component in level order
+    template<typename ComponentCallback>
+    void process_all(ComponentCallback callback) {
+        for (int c = 0; c < num_components(); c++)
+            callback(nodes.data() + component_begin[c], nodes.data() + component_begin[c + 1]);
+    }
+
+private:
+    enum : char { UNTRIMMED, TRIMMED_BACKWARD, TRIMMED_FORWARD };
+
+    // view of the untrimmed nodes for running TopoSortedSccs on them
+    struct CoreGraph {
+        typedef int node_type;
+
+        struct successor_enumerator {
+            const int *current, *end;
+            bool finished() const { return current == end; }
+            node_type next() {
+                log_assert(!finished());
+                return *current++;
+            }
+        };
+
+        struct node_enumerator {
+            int current, end;
+            bool finished() const { return current == end; }
+            node_type next() {
+                log_assert(!finished());
+                return current++;
+            }
+        };
+
+        LevelizedSccs &self;
+        std::vector<int> indices_;
+
+        node_enumerator enumerate_nodes() { return {0, GetSize(indices_)}; }
+        successor_enumerator enumerate_successors(int node) const {
+            return {self.succ.data() + self.succ_begin[node], self.succ.data() + self.succ_begin[node + 1]};
+        }
+        int &dfs_index(int node) { return indices_[node]; }
+    };
+
+    G &graph;
+    int min_wave_size;
+    int num_workers;
+
+    // the graph in CSR form over dense node indices, in both directions
+    std::vector<node_type> dense_nodes;
+    std::vector<int> succ_begin, succ, pred_begin, pred;
+
+    std::vector<char> state;
+    std::vector<int> level;
+    std::vector<std::vector<int>> forward_waves;
+
+    // components in the order they were found, as ranges of comp_nodes
+    std::vector<int> comp_nodes, comp_begin;
+
+    // run body(begin, end, worker) on disjoint subranges of [0, size)
+    template<typename F>
+    void parallel_for(int size, F body) {
+        int workers = std::min(num_workers, size / std::max(min_wave_size, 1));
+        if (workers == 0) {
+            body(0, size, 0);
+            return;
+        }
+        auto range_begin = [&](int i) { return int(int64_t(size) * i / (workers + 1)); };
+        ThreadPool pool(workers, [&](int i) {
+            body(range_begin(i + 1), range_begin(i + 2), i + 1);
+        });
+        body(0, range_begin(1), 0);
+    }
+
+    // Processes waves of nodes until no more nodes become ready. For each
+    // node of a wave, visit(node, ready) appends the nodes it makes ready to
+    // ready. The waves are sorted to make the result independent of thread
+    // scheduling.
+    template<typename F>
+    void run_waves(std::vector<int> wave, std::vector<std::vector<int>> *waves, F visit) {
+        std::vector<std::vector<int>> ready(num_workers + 1);
+        for (int wave_index = 0; !wave.empty(); wave_index++) {
+            parallel_for(GetSize(wave), [&](int begin, int end, int worker) {
+                for (int i = begin; i < end; i++)
+                    visit(wave[i], wave_index, ready[worker]);
+            });
+            if (waves != nullptr)
+                waves->push_back(std::move(wave));
+            wave.clear();
+            for (auto &nodes : ready) {
+                wave.insert(wave.end(), nodes.begin(), nodes.end());
+                nodes.clear();
+            }
+            std::sort(wave.begin(), wave.end());
+        }
+    }
+
+    void build_edges() {
+        node_enumerator node_enum = graph.enumerate_nodes();
+        while (!node_enum.finished()) {
+            node_type node = node_enum.next();
+            log_assert(graph.dfs_index(node) < 0);
+            graph.dfs_index(node) = GetSize(dense_nodes);
+            dense_nodes.push_back(node);
+        }
+        int n = GetSize(dense_nodes);
+
+        succ_begin.resize(n + 1);
+        parallel_for(n, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                int count = 0;
+                for (successor_enumerator succ_enum = graph.enumerate_successors(dense_nodes[i]); !succ_enum.finished(); succ_enum.next())
+                    count++;
+                succ_begin[i + 1] = count;
+            }
+        });
+        for (int i = 0; i < n; i++)
+            succ_begin[i + 1] += succ_begin[i];
+
+        succ.resize(succ_begin[n]);
+        std::vector<std::atomic<int>> pred_count(n + 1);
+        parallel_for(n, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                int *out = succ.data() + succ_begin[i];
+                for (successor_enumerator succ_enum = graph.enumerate_successors(dense_nodes[i]); !succ_enum.finished();) {
+                    int s = graph.dfs_index(succ_enum.next());
+                    *out++ = s;
+                    pred_count[s + 1].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        pred_begin.resize(n + 1);
+        pred_begin[0] = 0;
+        for (int i = 0; i < n; i++)
+            pred_begin[i + 1] = pred_begin[i] + pred_count[i + 1].load(std::memory_order_relaxed);
+
+        // the order within each predecessor list depends on scheduling,
+        // which is fine as only the set of predecessors is used
+        pred.resize(pred_begin[n]);
+        for (int i = 0; i < n; i++)
+            pred_count[i].store(pred_begin[i], std::memory_order_relaxed);
+        parallel_for(n, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++)
+                for (int j = succ_begin[i]; j < succ_begin[i + 1]; j++)
+                    pred[pred_count[succ[j]].fetch_add(1, std::memory_order_relaxed)] = i;
+        });
+
+        state.assign(n, UNTRIMMED);
+        level.assign(n, -1);
+    }
+
+    // trim nodes whose successors are all trimmed, starting at the sinks,
+    // the level of such a node is the index of the wave it's trimmed in
+    void trim_backward() {
+        int n = GetSize(dense_nodes);
+        std::vector<std::atomic<int>> remaining(n);
+        std::vector<int> wave;
+        for (int i = 0; i < n; i++) {
+            remaining[i].store(succ_begin[i + 1] - succ_begin[i], std::memory_order_relaxed);
+            if (succ_begin[i + 1] == succ_begin[i])
+                wave.push_back(i);
+        }
+        run_waves(std::move(wave), nullptr, [&](int node, int wave_index, std::vector<int> &ready) {
+            state[node] = TRIMMED_BACKWARD;
+            level[node] = wave_index;
+            for (int j = pred_begin[node]; j < pred_begin[node + 1]; j++)
+                if (remaining[pred[j]].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    ready.push_back(pred[j]);
+        });
+    }
+
+    // trim nodes whose predecessors are all trimmed, starting at the
+    // sources. Their levels depend on the core and are computed later.
+    void trim_forward() {
+        int n = GetSize(dense_nodes);
+        std::vector<std::atomic<int>> remaining(n);
+        std::vector<int> wave;
+        for (int i = 0; i < n; i++) {
+            if (state[i] != UNTRIMMED)
+                continue;
+            // all predecessors of an untrimmed node are untrimmed
+            remaining[i].store(pred_begin[i + 1] - pred_begin[i], std::memory_order_relaxed);
+            if (pred_begin[i + 1] == pred_begin[i])
+                wave.push_back(i);
+        }
+        run_waves(std::move(wave), &forward_waves, [&](int node, int, std::vector<int> &ready) {
+            state[node] = TRIMMED_FORWARD;
+            for (int j = succ_begin[node]; j < succ_begin[node + 1]; j++) {
+                int s = succ[j];
+                if (state[s] != TRIMMED_BACKWARD && remaining[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    ready.push_back(s);
+            }
+        });
+    }
+
+    void add_component(const int *begin, const int *end) {
+        comp_begin.push_back(GetSize(comp_nodes));
+        comp_nodes.insert(comp_nodes.end(), begin, end);
+    }
+
+    void process_core() {
+        int n = GetSize(dense_nodes);
+
+        for (int i = 0; i < n; i++)
+            if (state[i] == TRIMMED_BACKWARD)
+                add_component(&i, &i + 1);
+
+        CoreGraph core{*this, {}};
+        core.indices_.resize(n, INT_MAX);
+        for (int i = 0; i < n; i++)
+            if (state[i] == UNTRIMMED)
+                core.indices_[i] = -1;
+
+        // every successor outside of a component was emitted before, so it
+        // has a level and nodes of the component itself still have level -1
+        auto callback = [&](int *begin, int *end) {
+            int component_level = 0;
+            for (int *node = begin; node != end; ++node)
+                for (int j = succ_begin[*node]; j < succ_begin[*node + 1]; j++)
+                    component_level = std::max(component_level, level[succ[j]] + 1);
+            for (int *node = begin; node != end; ++node)
+                level[*node] = component_level;
+            add_component(begin, end);
+        };
+        TopoSortedSccs<CoreGraph, decltype(callback)> sccs(core, callback);
+        for (int i = 0; i < n; i++)
+            if (state[i] == UNTRIMMED)
+                sccs.process(i);
+    }
+
+    void levelize_forward() {
+        for (int w = GetSize(forward_waves) - 1; w >= 0; w--) {
+            auto &wave = forward_waves[w];
+            parallel_for(GetSize(wave), [&](int begin, int end, int) {
+                for (int i = begin; i < end; i++) {
+                    int node = wave[i], node_level = 0;
+                    for (int j = succ_begin[node]; j < succ_begin[node + 1]; j++)
+                        node_level = std::max(node_level, level[succ[j]] + 1);
+                    level[node] = node_level;
+                }
+            });
+        }
+        for (auto &wave : forward_waves)
+            for (int node : wave)
+                add_component(&node, &node + 1);
+    }
+
+    void collect() {
+        int n = GetSize(dense_nodes);
+        int num_comps = GetSize(comp_begin);
+        comp_begin.push_back(n);
+
+        int max_level = -1;
+        for (int c = 0; c < num_comps; c++)
+            max_level = std::max(max_level, level[comp_nodes[comp_begin[c]]]);
+
+        level_begin.assign(max_level + 2, 0);
+        std::vector<int> level_nodes(max_level + 2, 0);
+        for (int c = 0; c < num_comps; c++) {
+            int l = level[comp_nodes[comp_begin[c]]];
+            level_begin[l + 1]++;
+            level_nodes[l + 1] += comp_begin[c + 1] - comp_begin[c];
+        }
+        for (int l = 0; l <= max_level; l++) {
+            level_begin[l + 1] += level_begin[l];
+            level_nodes[l + 1] += level_nodes[l];
+        }
+
+        // stable counting sort of the components by level
+        std::vector<int> next_comp(level_begin.begin(), level_begin.end() - 1);
+        std::vector<int> next_node(level_nodes.begin(), level_nodes.end() - 1);
+        component_begin.resize(num_comps + 1);
+        nodes.resize(n);
+        for (int c = 0; c < num_comps; c++) {
+            int l = level[comp_nodes[comp_begin[c]]];
+            component_begin[next_comp[l]++] = next_node[l];
+            for (int j = comp_begin[c]; j < comp_begin[c + 1]; j++)
+                nodes[next_node[l]++] = dense_nodes[comp_nodes[j]];
+        }
+        component_begin[num_comps] = n;
+
+        for (int i = 0; i < n; i++)
+            graph.dfs_index(dense_nodes[i]) = INT_MAX;
+    }
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
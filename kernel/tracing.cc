@@ -0,0 +1,584 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/tracing.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <mach/task.h>
+#include <mach/mach_init.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+using json11::Json;
+
+bool trace_active = false;
+
+static FILE *trace_file = nullptr;
+static std::mutex trace_mutex;
+static std::chrono::steady_clock::time_point trace_epoch;
+static std::string trace_pending_command;
+static std::atomic<int> trace_next_tid{1};
+static int trace_pid = 1;
+static bool trace_first_event = true;
+
+// Number of spans opened on the calling thread that have not been closed
+// yet, so that trace_stop() can terminate the ones of the main thread.
+static thread_local int trace_open_spans = 0;
+
+static int trace_tid()
+{
+	static thread_local int tid = trace_next_tid++;
+	return tid;
+}
+
+static int64_t trace_timestamp_us()
+{
+	auto elapsed = std::chrono::steady_clock::now() - trace_epoch;
+	return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+static void trace_emit(const char *phase, const std::string *name, const char *category, const Json::object &args, const char *extra = nullptr)
+{
+	std::string buf = "{\"ph\":\"";
+	buf += phase;
+	buf += "\"";
+	if (name != nullptr)
+		buf += ",\"name\":" + Json(*name).dump();
+	if (category != nullptr)
+		buf += ",\"cat\":" + Json(category).dump();
+	if (extra != nullptr)
+		buf += extra;
+	buf += stringf(",\"ts\":%lld,\"pid\":%d,\"tid\":%d", (long long)trace_timestamp_us(), trace_pid, trace_tid());
+	if (!args.empty())
+		buf += ",\"args\":" + Json(args).dump();
+	buf += "}";
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	if (trace_file != nullptr) {
+		fputs(trace_first_event ? "\n" : ",\n", trace_file);
+		fputs(buf.c_str(), trace_file);
+		trace_first_event = false;
+	}
+}
+
+void trace_start(const std::string &filename)
+{
+	trace_stop();
+
+	trace_file = fopen(filename.c_str(), "wt");
+	if (trace_file == nullptr)
+		log_cmd_error("Can't open trace file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+	yosys_output_files.insert(filename);
+
+#ifndef _WIN32
+	trace_pid = getpid();
+#endif
+	trace_epoch = std::chrono::steady_clock::now();
+	trace_open_spans = 0;
+	trace_first_event = true;
+	trace_active = true;
+
+	// The JSON array format allows the closing bracket to be omitted, so
+	// the file stays loadable if we never get to trace_stop().
+	fputs("[", trace_file);
+	std::string process_name = "process_name";
+	trace_emit("M", &process_name, nullptr, Json::object{{"name", "yosys"}});
+	trace_sample_memory();
+}
+
+void trace_stop()
+{
+	if (!trace_active)
+		return;
+
+	while (trace_open_spans > 0)
+		trace_end();
+	trace_sample_memory();
+	trace_active = false;
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	fputs("\n]\n", trace_file);
+	fclose(trace_file);
+	trace_file = nullptr;
+	trace_pending_command.clear();
+}
+
+void trace_begin(const std::string &name, const char *category, const Json::object &args)
+{
+	if (!trace_active)
+		return;
+	trace_open_spans++;
+	trace_emit("B", &name, category, args);
+}
+
+void trace_end(const Json::object &args)
+{
+	if (!trace_active || trace_open_spans == 0)
+		return;
+	trace_open_spans--;
+	trace_emit("E", nullptr, nullptr, args);
+}
+
+void trace_instant(const std::string &name, const char *category, const Json::object &args)
+{
+	if (!trace_active)
+		return;
+	trace_emit("i", &name, category, args, ",\"s\":\"g\"");
+}
+
+void trace_counter(const std::string &name, const Json::object &values)
+{
+	if (!trace_active)
+		return;
+	trace_emit("C", &name, nullptr, values);
+}
+
+void trace_sample_memory()
+{
+	if (!trace_active)
+		return;
+	if (auto mem = current_mem_bytes())
+		trace_counter("memory", Json::object{{"rss_mb", *mem / (1024.0 * 1024.0)}});
+}
+
+static void trace_design_stats(RTLIL::Design *design, Json::object &args, const char *suffix)
+{
+	if (design == nullptr)
+		return;
+	int num_cells = 0, num_wires = 0;
+	for (auto &it : design->modules_) {
+		num_cells += GetSize(it.second->cells_);
+		num_wires += GetSize(it.second->wires_);
+	}
+	args[stringf("modules%s", suffix)] = GetSize(design->modules_);
+	args[stringf("cells%s", suffix)] = num_cells;
+	args[stringf("wires%s", suffix)] = num_wires;
+}
+
+void trace_command(const std::vector<std::string> &args)
+{
+	if (!trace_active && !memstats_active)
+		return;
+	trace_pending_command.clear();
+	for (auto &arg : args)
+		trace_pending_command += (trace_pending_command.empty() ? "" : " ") + arg;
+}
+
+static void memstats_pass_begin(Pass *pass, Pass *parent);
+static void memstats_pass_end(Pass *pass);
+
+void trace_pass_begin(Pass *pass, Pass *parent)
+{
+	if (memstats_active)
+		memstats_pass_begin(pass, parent);
+
+	if (trace_active)
+	{
+		// close spans left open by commands that were aborted with an error
+		if (parent == nullptr)
+			while (trace_open_spans > 0)
+				trace_end();
+
+		Json::object args;
+		if (!trace_pending_command.empty())
+			args["command"] = trace_pending_command;
+		trace_design_stats(yosys_design, args, "_before");
+		if (auto mem = current_mem_bytes())
+			args["rss_mb_before"] = *mem / (1024.0 * 1024.0);
+
+		trace_sample_memory();
+		trace_begin(pass->pass_name, "pass", args);
+	}
+
+	trace_pending_command.clear();
+}
+
+void trace_pass_end(Pass *pass)
+{
+	if (memstats_active)
+		memstats_pass_end(pass);
+
+	if (!trace_active)
+		return;
+
+	Json::object args;
+	trace_design_stats(yosys_design, args, "_after");
+	if (auto mem = current_mem_bytes())
+		args["rss_mb_after"] = *mem / (1024.0 * 1024.0);
+
+	trace_end(args);
+	trace_sample_memory();
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	fflush(trace_file);
+}
+
+std::optional<uint64_t> current_mem_bytes()
+{
+#if defined(__APPLE__)
+	task_basic_info_64_data_t basicInfo;
+	mach_msg_type_number_t count = TASK_BASIC_INFO_64_COUNT;
+	kern_return_t error = task_info(mach_task_self(), TASK_BASIC_INFO_64, (task_info_t)&basicInfo, &count);
+	if (error != KERN_SUCCESS)
+		return {}; // Error getting task information
+	return basicInfo.resident_size;
+
+#elif defined(__linux__)
+	// Not all linux distributions have to have this file
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (f == nullptr)
+		return {};
+	unsigned long long size = 0, resident = 0;
+	int n = fscanf(f, "%llu %llu", &size, &resident);
+	fclose(f);
+	if (n != 2)
+		return {};
+	return (uint64_t)resident * sysconf(_SC_PAGESIZE);
+
+#else
+	return {};
+#endif
+}
+
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+static std::atomic<int64_t> alloc_stats_count, alloc_stats_bytes, alloc_stats_live_bytes;
+#endif
+
+bool alloc_stats_available()
+{
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+MemSnapshot MemSnapshot::now()
+{
+	MemSnapshot snapshot;
+	if (auto mem = current_mem_bytes())
+		snapshot.rss = *mem;
+	snapshot.cells = RTLIL::Cell::live_count;
+	snapshot.wires = RTLIL::Wire::live_count;
+	snapshot.idstrings = GetSize(RTLIL::IdString::global_id_storage_);
+#ifndef YOSYS_NO_IDS_REFCNT
+	snapshot.idstrings -= GetSize(RTLIL::IdString::global_free_idx_list_);
+#endif
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+	snapshot.sigspecs = RTLIL::SigSpec::live_count();
+	snapshot.alloc_count = alloc_stats_count;
+	snapshot.alloc_bytes = alloc_stats_bytes;
+	snapshot.alloc_live_bytes = alloc_stats_live_bytes;
+#endif
+	return snapshot;
+}
+
+Json::object MemSnapshot::to_json() const
+{
+	// json11 has no 64-bit integers, doubles are exact up to 2^53
+	Json::object obj;
+	if (rss >= 0)
+		obj["rss"] = double(rss);
+	obj["cells"] = double(cells);
+	obj["wires"] = double(wires);
+	obj["idstrings"] = double(idstrings);
+	if (sigspecs >= 0)
+		obj["sigspecs"] = double(sigspecs);
+	if (alloc_count >= 0) {
+		obj["alloc_count"] = double(alloc_count);
+		obj["alloc_bytes"] = double(alloc_bytes);
+		obj["alloc_live_bytes"] = double(alloc_live_bytes);
+	}
+	return obj;
+}
+
+Json::object PassMemRecord::to_json() const
+{
+	Json::object obj;
+	obj["pass"] = pass_name;
+	obj["command"] = command;
+	obj["depth"] = depth;
+	obj["finished"] = finished;
+	obj["before"] = before.to_json();
+	if (finished)
+		obj["after"] = after.to_json();
+	if (peak_rss >= 0) {
+		obj["peak_rss"] = double(peak_rss);
+		obj["peak_rss_delta"] = double(peak_rss_delta());
+	}
+	return obj;
+}
+
+bool memstats_active = false;
+
+static std::vector<PassMemRecord> memstats_records_;
+// indices into memstats_records_ of the commands currently executing
+static std::vector<int> memstats_stack;
+// process-wide peak RSS at the start of each entry in memstats_stack
+static std::vector<int64_t> memstats_stack_hwm;
+static bool memstats_can_reset_peak = false;
+
+// Peak resident set size of the process. On Linux this is VmHWM, which
+// memstats_reset_peak() can set back to the current RSS.
+static int64_t memstats_read_peak()
+{
+#if defined(__linux__)
+	FILE *f = fopen("/proc/self/status", "r");
+	if (f != nullptr) {
+		char line[256];
+		long long kb = -1;
+		while (fgets(line, sizeof(line), f))
+			if (sscanf(line, "VmHWM: %lld kB", &kb) == 1)
+				break;
+		fclose(f);
+		if (kb >= 0)
+			return kb * 1024;
+	}
+#endif
+#if !defined(_WIN32)
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#  if defined(__APPLE__)
+		return ru.ru_maxrss;
+#  else
+		return int64_t(ru.ru_maxrss) * 1024;
+#  endif
+	}
+#endif
+	return -1;
+}
+
+static void memstats_reset_peak()
+{
+#if defined(__linux__)
+	if (!memstats_can_reset_peak)
+		return;
+	// "5" resets the peak RSS counter, see proc(5)
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	if (f == nullptr) {
+		memstats_can_reset_peak = false;
+		return;
+	}
+	fputs("5", f);
+	if (fclose(f) != 0)
+		memstats_can_reset_peak = false;
+#endif
+}
+
+void memstats_start()
+{
+	if (memstats_active)
+		return;
+	memstats_active = true;
+#if defined(__linux__)
+	memstats_can_reset_peak = true;
+	memstats_reset_peak();
+#endif
+}
+
+void memstats_stop()
+{
+	memstats_active = false;
+	memstats_stack.clear();
+	memstats_stack_hwm.clear();
+}
+
+void memstats_clear()
+{
+	memstats_records_.clear();
+	memstats_stack.clear();
+	memstats_stack_hwm.clear();
+}
+
+const std::vector<PassMemRecord> &memstats_records()
+{
+	return memstats_records_;
+}
+
+// The peak of a command is the maximum of the peak RSS while it runs and
+// the peaks of its sub-commands. When the kernel lets us reset the peak
+// counter we do so at every command boundary and fold the peak seen so far
+// into the enclosing command. Otherwise we only learn about the peak during
+// a command if it raised the process-wide maximum.
+static void memstats_fold_peak(int64_t peak_now)
+{
+	if (memstats_stack.empty() || peak_now < 0)
+		return;
+	auto &rec = memstats_records_[memstats_stack.back()];
+	if (memstats_can_reset_peak || peak_now > memstats_stack_hwm.back())
+		rec.peak_rss = std::max(rec.peak_rss, peak_now);
+}
+
+static void memstats_pass_begin(Pass *pass, Pass *parent)
+{
+	// forget commands that were aborted with an error
+	if (parent == nullptr) {
+		memstats_stack.clear();
+		memstats_stack_hwm.clear();
+	}
+
+	memstats_fold_peak(memstats_read_peak());
+	memstats_reset_peak();
+
+	PassMemRecord rec;
+	rec.pass_name = pass->pass_name;
+	rec.command = trace_pending_command.empty() ? pass->pass_name : trace_pending_command;
+	rec.depth = GetSize(memstats_stack);
+	rec.before = MemSnapshot::now();
+	rec.peak_rss = rec.before.rss;
+
+	memstats_stack.push_back(GetSize(memstats_records_));
+	memstats_stack_hwm.push_back(memstats_read_peak());
+	memstats_records_.push_back(std::move(rec));
+}
+
+static void memstats_pass_end(Pass *pass)
+{
+	if (memstats_stack.empty() || memstats_records_[memstats_stack.back()].pass_name != pass->pass_name)
+		return;
+
+	memstats_fold_peak(memstats_read_peak());
+
+	auto &rec = memstats_records_[memstats_stack.back()];
+	rec.finished = true;
+	rec.after = MemSnapshot::now();
+	rec.peak_rss = std::max(rec.peak_rss, rec.after.rss);
+	int64_t peak = rec.peak_rss;
+
+	memstats_stack.pop_back();
+	memstats_stack_hwm.pop_back();
+
+	if (!memstats_stack.empty()) {
+		auto &parent_rec = memstats_records_[memstats_stack.back()];
+		parent_rec.peak_rss = std::max(parent_rec.peak_rss, peak);
+	}
+	memstats_reset_peak();
+}
+
+void memstats_log_summary(int max_lines)
+{
+	struct summary_t {
+		int calls = 0;
+		int64_t peak_delta = -1, net_delta = 0, alloc_bytes = 0;
+	};
+	dict<std::string, summary_t> summary;
+
+	for (auto &rec : memstats_records_) {
+		if (!rec.finished)
+			continue;
+		auto &s = summary[rec.pass_name];
+		s.calls++;
+		s.peak_delta = std::max(s.peak_delta, rec.peak_rss_delta());
+		// only count top-level commands to avoid adding up nested commands
+		if (rec.depth == 0 && rec.before.rss >= 0 && rec.after.rss >= 0)
+			s.net_delta += rec.after.rss - rec.before.rss;
+		if (rec.after.alloc_bytes >= 0)
+			s.alloc_bytes += rec.after.alloc_bytes - rec.before.alloc_bytes;
+	}
+
+	if (summary.empty())
+		return;
+
+	std::vector<std::pair<std::string, summary_t>> sorted(summary.begin(), summary.end());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, summary_t> &a, const std::pair<std::string, summary_t> &b) {
+		return a.second.peak_delta > b.second.peak_delta;
+	});
+
+	log("Memory use per command (largest peak RSS increase first):\n");
+	int count = 0;
+	for (auto &it : sorted) {
+		if (count++ >= max_lines) {
+			log("  ...\n");
+			break;
+		}
+		std::string alloc_info;
+		if (alloc_stats_available())
+			alloc_info = stringf(" %10.2f MB allocated", it.second.alloc_bytes / (1024.0 * 1024.0));
+		log("  %+10.2f MB peak %+10.2f MB net%s %5d calls %s\n", it.second.peak_delta / (1024.0 * 1024.0),
+				it.second.net_delta / (1024.0 * 1024.0), alloc_info.c_str(), it.second.calls, it.first.c_str());
+	}
+}
+
+YOSYS_NAMESPACE_END
+
+#ifdef YOSYS_ENABLE_ALLOC_STATS
+
+// Replacements of the global allocation functions that keep the counters
+// used by MemSnapshot. The array and nothrow variants of the standard
+// library forward to these.
+
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#  define YOSYS_ALLOC_USABLE_SIZE(p) malloc_usable_size(p)
+#elif defined(__APPLE__)
+#  include <malloc/malloc.h>
+#  define YOSYS_ALLOC_USABLE_SIZE(p) malloc_size(p)
+#else
+#  define YOSYS_ALLOC_USABLE_SIZE(p) size_t(0)
+#endif
+
+void *operator new(std::size_t size)
+{
+	void *p = malloc(size ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	Yosys::alloc_stats_count.fetch_add(1, std::memory_order_relaxed);
+	Yosys::alloc_stats_bytes.fetch_add(size, std::memory_order_relaxed);
+	Yosys::alloc_stats_live_bytes.fetch_add(YOSYS_ALLOC_USABLE_SIZE(p), std::memory_order_relaxed);
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	if (p == nullptr)
+		return;
+	Yosys::alloc_stats_live_bytes.fetch_sub(YOSYS_ALLOC_USABLE_SIZE(p), std::memory_order_relaxed);
+	free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	operator delete(p);
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete[](void *p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+	operator delete(p);
+}
+
+#endif
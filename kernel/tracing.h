@@ -0,0 +1,140 @@
+/* -*- c++ -*-
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include "kernel/yosys.h"
+#include "libs/json11/json11.hpp"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Timeline export of command execution in the Chrome trace event format,
+// which can be loaded into chrome://tracing, Perfetto or speedscope. Events
+// are streamed to the trace file as they happen, so a trace of a run that
+// gets killed (e.g. by the OOM killer) is still usable.
+//
+// Enabled with "yosys --trace-json <file>" or the "tracing" command. All
+// functions below are no-ops while no trace file is open; use
+// trace_enabled() to skip building expensive event arguments.
+
+extern bool trace_active;
+
+static inline bool trace_enabled() { return trace_active; }
+
+void trace_start(const std::string &filename);
+void trace_stop();
+
+// Generic events. Spans must be properly nested per thread.
+void trace_begin(const std::string &name, const char *category, const json11::Json::object &args = {});
+void trace_end(const json11::Json::object &args = {});
+void trace_instant(const std::string &name, const char *category, const json11::Json::object &args = {});
+void trace_counter(const std::string &name, const json11::Json::object &values);
+
+// Emit an RSS counter sample
+void trace_sample_memory();
+
+// Hooks used by Pass::pre_execute() and Pass::post_execute(), these also
+// do the bookkeeping for the per-command memory accounting below
+void trace_command(const std::vector<std::string> &args);
+void trace_pass_begin(Pass *pass, Pass *parent);
+void trace_pass_end(Pass *pass);
+
+// RAII span for work inside a pass, typically one module:
+//
+//	for (auto module : design->selected_modules()) {
+//		TraceScope trace_scope(module);
+//		...
+//	}
+struct TraceScope
+{
+	bool active;
+
+	TraceScope(const std::string &name, const char *category = "scope", const json11::Json::object &args = {}) : active(trace_active) {
+		if (active)
+			trace_begin(name, category, args);
+	}
+	TraceScope(RTLIL::Module *module) : active(trace_active) {
+		if (active)
+			trace_begin(log_id(module), "module", json11::Json::object{
+					{"cells", GetSize(module->cells_)}, {"wires", GetSize(module->wires_)}});
+	}
+	~TraceScope() {
+		if (active)
+			trace_end();
+	}
+
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+};
+
+// Resident set size of the running process, if the platform can tell us
+std::optional<uint64_t> current_mem_bytes();
+
+// Per-command memory accounting, enabled with "yosys --memstats" or
+// "internal_stats -track". A record is kept for every executed command
+// (including sub-commands), see "help internal_stats". Fields that are
+// not available on this platform or in this build are -1.
+
+struct MemSnapshot
+{
+	int64_t rss = -1;
+	int64_t cells = 0, wires = 0, idstrings = 0;
+	// only with ENABLE_ALLOC_STATS=1
+	int64_t sigspecs = -1;
+	int64_t alloc_count = -1, alloc_bytes = -1, alloc_live_bytes = -1;
+
+	static MemSnapshot now();
+	json11::Json::object to_json() const;
+};
+
+struct PassMemRecord
+{
+	std::string pass_name, command;
+	int depth = 0;
+	// false if the command was aborted with an error
+	bool finished = false;
+	MemSnapshot before, after;
+	int64_t peak_rss = -1;
+
+	int64_t peak_rss_delta() const {
+		return peak_rss < 0 || before.rss < 0 ? -1 : peak_rss - before.rss;
+	}
+	json11::Json::object to_json() const;
+};
+
+extern bool memstats_active;
+
+static inline bool memstats_enabled() { return memstats_active; }
+
+void memstats_start();
+void memstats_stop();
+void memstats_clear();
+const std::vector<PassMemRecord> &memstats_records();
+
+// Print the commands with the largest peak memory increase
+void memstats_log_summary(int max_lines = 10);
+
+// True if Yosys was built with ENABLE_ALLOC_STATS=1, which counts all heap
+// allocations through a replacement of the global operator new
+bool alloc_stats_available();
+
+YOSYS_NAMESPACE_END
+
+#endif
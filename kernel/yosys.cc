@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
+#include "kernel/tracing.h"
 
 #ifdef YOSYS_ENABLE_READLINE
 #  include <readline/readline.h>
@@ -234,11 +235,14 @@ void yosys_shutdown()
 	already_shutdown = true;
 	log_pop();
 
+	trace_stop();
+
 	Pass::done_register();
 
 	delete yosys_design;
 	yosys_design = NULL;
 
+	log_async_stop();
 	for (auto f : log_files)
 		if (f != stderr)
 			fclose(f);
@@ -174,7 +174,7 @@ unsigned int abstract_state(Module* mod, EnableLogic enable, const std::vector<S
 	std::vector<FfData> ffs;
 	// Abstract flop inputs if they're driving a selected output rep
 	for (auto cell : mod->cells()) {
-		if (!ct.cell_types.count(cell->type))
+		if (!ct.cell_known(cell->type))
 			continue;
 		FfData ff(nullptr, cell);
 		if (ff.has_sr)
@@ -255,6 +255,7 @@ bool abstract_value_mod_port(Module* mod, Wire* wire, std::set<int> offsets, Ena
 		}
 	}
 	mod->connections_.push_back(SigSig(direct_lhs, direct_rhs));
+	mod->invalidate_sigmap();
 	emit_mux_anyseq(mod, mux_input, mux_output, enable);
 	return true;
 }
@@ -22,52 +22,90 @@
 #include <stdint.h>
 
 #include "kernel/yosys.h"
+#include "kernel/tracing.h"
+#include "kernel/json.h"
 #include "kernel/celltypes.h"
 #include "passes/techmap/libparse.h"
 #include "kernel/cost.h"
 #include "frontends/ast/ast.h"
 #include "libs/json11/json11.hpp"
 
-#if defined(__APPLE__) && defined(__MACH__)
-#include <mach/task.h>
-#include <mach/mach_init.h>
-#endif
-
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-std::optional<uint64_t> current_mem_bytes() {
-
-#if defined(__APPLE__)
-    task_basic_info_64_data_t basicInfo;
-    mach_msg_type_number_t count = TASK_BASIC_INFO_64_COUNT;
-    kern_return_t error = task_info(mach_task_self(), TASK_BASIC_INFO_64, (task_info_t)&basicInfo, &count);
-    if (error != KERN_SUCCESS) {
-        return {}; // Error getting task information
-    }
-    return basicInfo.resident_size; // Return RSS in KB
-
-#elif defined(__linux__)
-	// Not all linux distributions have to have this file
-    std::ifstream statusFile("/proc/self/status");
-    std::string line;
-    while (std::getline(statusFile, line)) {
-        if (line.find("VmRSS:") == 0) {
-            std::istringstream iss(line);
-            std::string token;
-			// Skip prefix
-            iss >> token;
-            uint64_t rss;
-            iss >> rss;
-            return rss * 1024;
-        }
-    }
-	// Error reading /proc/self/status
-    return {};
-
-#else
-	return {};
-#endif
+// Sizes of the containers owned by the design. Walks the whole design, so
+// this is only computed on request and not for every command.
+struct DesignMemStats
+{
+	int64_t modules = 0, wires = 0, cells = 0, object_bytes = 0;
+	int64_t sigspecs = 0, sigspec_bits = 0, sigspec_chunks = 0;
+	int64_t hashlib_tables = 0, hashlib_entries = 0, hashlib_bytes = 0;
+
+	template<typename T>
+	void add_table(const T &table) {
+		hashlib_tables++;
+		hashlib_entries += table.size();
+		hashlib_bytes += table.table_bytes();
+	}
+
+	void add_sigspec(const RTLIL::SigSpec &sig) {
+		sigspecs++;
+		sigspec_bits += sig.size();
+		sigspec_chunks += GetSize(sig.chunks());
+	}
+
+	DesignMemStats(RTLIL::Design *design)
+	{
+		add_table(design->modules_);
+		for (auto module : design->modules()) {
+			modules++;
+			object_bytes += module->object_bytes();
+			add_table(module->wires_);
+			add_table(module->cells_);
+			add_table(module->memories);
+			add_table(module->processes);
+			add_table(module->attributes);
+			for (auto &conn : module->connections()) {
+				add_sigspec(conn.first);
+				add_sigspec(conn.second);
+			}
+			for (auto wire : module->wires()) {
+				wires++;
+				add_table(wire->attributes);
+			}
+			for (auto cell : module->cells()) {
+				cells++;
+				add_table(cell->connections_);
+				add_table(cell->parameters);
+				add_table(cell->attributes);
+				for (auto &conn : cell->connections())
+					add_sigspec(conn.second);
+			}
+		}
+	}
+
+	json11::Json::object to_json() const
+	{
+		return json11::Json::object {
+			{"modules", double(modules)},
+			{"wires", double(wires)},
+			{"cells", double(cells)},
+			{"object_bytes", double(object_bytes)},
+			{"sigspecs", double(sigspecs)},
+			{"sigspec_bits", double(sigspec_bits)},
+			{"sigspec_chunks", double(sigspec_chunks)},
+			{"hashlib_tables", double(hashlib_tables)},
+			{"hashlib_entries", double(hashlib_entries)},
+			{"hashlib_bytes", double(hashlib_bytes)},
+		};
+	}
+};
+
+static std::string format_bytes(int64_t bytes)
+{
+	if (bytes < 0)
+		return "n/a";
+	return stringf("%.2f MB", bytes / (1024.0 * 1024.0));
 }
 
 struct InternalStatsPass : public Pass {
@@ -75,11 +113,43 @@ struct InternalStatsPass : public Pass {
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
-		log("Print internal statistics for developers (experimental)\n");
+		log("\n");
+		log("    internal_stats [options]\n");
+		log("\n");
+		log("Print internal statistics for developers (experimental). This includes the\n");
+		log("current memory usage, the number of live cells, wires and IdStrings, and the\n");
+		log("number of entries and the memory held by the hash tables of the design.\n");
+		log("\n");
+		log("When Yosys is built with ENABLE_ALLOC_STATS=1, the number of live SigSpec\n");
+		log("objects and counters for all heap allocations are reported as well.\n");
+		log("\n");
+		log("    -json\n");
+		log("        print the statistics in JSON format. Use 'tee -o <file>' to write\n");
+		log("        them to a file.\n");
+		log("\n");
+		log("    -track\n");
+		log("        start recording memory statistics for every command executed from\n");
+		log("        now on (including sub-commands): resident memory before and after,\n");
+		log("        peak resident memory during the command, and the live object and\n");
+		log("        allocation counters before and after. The commands with the largest\n");
+		log("        peak increase are listed at the end of the run. 'yosys --memstats'\n");
+		log("        enables this from the start.\n");
+		log("\n");
+		log("    -notrack\n");
+		log("        stop recording memory statistics.\n");
+		log("\n");
+		log("    -passes\n");
+		log("        include the recorded per-command statistics in the output.\n");
+		log("\n");
+		log("    -clear\n");
+		log("        discard the recorded per-command statistics.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool json_mode = false;
+		bool passes_mode = false;
+		bool track = false, notrack = false, clear = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
@@ -88,6 +158,22 @@ struct InternalStatsPass : public Pass {
 				json_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-passes") {
+				passes_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-track") {
+				track = true;
+				continue;
+			}
+			if (args[argidx] == "-notrack") {
+				notrack = true;
+				continue;
+			}
+			if (args[argidx] == "-clear") {
+				clear = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -97,26 +183,83 @@ struct InternalStatsPass : public Pass {
 
 		log_experimental("internal_stats");
 
+		if (clear)
+			memstats_clear();
+		if (notrack)
+			memstats_stop();
+		if (track)
+			memstats_start();
+		if (track || notrack || clear)
+			return;
+
+		auto ast_bytes = AST::astnode_count() * (unsigned long long) sizeof(AST::AstNode);
+		MemSnapshot snapshot = MemSnapshot::now();
+		DesignMemStats design_stats(design);
+
 		if (json_mode) {
-			log("{\n");
-			log("   \"creator\": %s,\n", json11::Json(yosys_maybe_version()).dump().c_str());
+			PrettyJson json;
+			json.emit_to_log();
+			json.begin_object();
+			json.entry("creator", yosys_maybe_version());
 			std::stringstream invocation;
 			std::copy(args.begin(), args.end(), std::ostream_iterator<std::string>(invocation, " "));
-			log("   \"invocation\": %s,\n", json11::Json(invocation.str()).dump().c_str());
-			if (auto mem = current_mem_bytes()) {
-				log("   \"memory_now\": %s,\n", std::to_string(*mem).c_str());
+			json.entry("invocation", invocation.str());
+			if (snapshot.rss >= 0)
+				json.entry("memory_now", double(snapshot.rss));
+			json.entry("memory_ast", double(ast_bytes));
+			json.entry("live", snapshot.to_json());
+			json.entry("design", design_stats.to_json());
+			if (passes_mode) {
+				json.name("passes");
+				json.begin_array();
+				for (auto &rec : memstats_records()) {
+					json.compact();
+					json.value(rec.to_json());
+				}
+				json.end_array();
 			}
-			auto ast_bytes = AST::astnode_count() * (unsigned long long) sizeof(AST::AstNode);
-			log("   \"memory_ast\": %s,\n", std::to_string(ast_bytes).c_str());
+			json.end_object();
+			log("\n");
+			return;
 		}
 
-		// stats go here
+		log("Memory:\n");
+		log("  resident:          %s\n", format_bytes(snapshot.rss).c_str());
+		log("  AST nodes:         %s\n", format_bytes(ast_bytes).c_str());
+		if (snapshot.alloc_count >= 0) {
+			log("  heap (live):       %s\n", format_bytes(snapshot.alloc_live_bytes).c_str());
+			log("  heap (allocated):  %s in %lld allocations\n", format_bytes(snapshot.alloc_bytes).c_str(),
+					(long long)snapshot.alloc_count);
+		}
+		log("\n");
+		log("Live objects:\n");
+		log("  cells:             %lld\n", (long long)snapshot.cells);
+		log("  wires:             %lld\n", (long long)snapshot.wires);
+		log("  IdStrings:         %lld\n", (long long)snapshot.idstrings);
+		if (snapshot.sigspecs >= 0)
+			log("  SigSpecs:          %lld\n", (long long)snapshot.sigspecs);
+		log("\n");
+		log("Design:\n");
+		log("  modules:           %lld\n", (long long)design_stats.modules);
+		log("  cells:             %lld\n", (long long)design_stats.cells);
+		log("  wires:             %lld\n", (long long)design_stats.wires);
+		log("  cell/wire objects: %s\n", format_bytes(design_stats.object_bytes).c_str());
+		log("  connections:       %lld SigSpecs, %lld bits in %lld chunks\n", (long long)design_stats.sigspecs,
+				(long long)design_stats.sigspec_bits, (long long)design_stats.sigspec_chunks);
+		log("  hash tables:       %lld with %lld entries, %s\n", (long long)design_stats.hashlib_tables,
+				(long long)design_stats.hashlib_entries, format_bytes(design_stats.hashlib_bytes).c_str());
 
-		if (json_mode) {
+		if (passes_mode) {
 			log("\n");
-			log("}\n");
+			log("Per-command memory statistics:\n");
+			for (auto &rec : memstats_records()) {
+				if (!rec.finished)
+					continue;
+				log("  %*s%-20s rss %10s -> %10s, peak %10s, cells %lld -> %lld\n", 2*rec.depth, "", rec.pass_name.c_str(),
+						format_bytes(rec.before.rss).c_str(), format_bytes(rec.after.rss).c_str(), format_bytes(rec.peak_rss).c_str(),
+						(long long)rec.before.cells, (long long)rec.after.cells);
+			}
 		}
-
 	}
 } InternalStatsPass;
 
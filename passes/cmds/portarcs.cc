@@ -84,7 +84,7 @@ struct PortarcsPass : Pass {
 		if (icells_mode) {
 			CellTypes ct;
 			ct.setup_stdcells_eval();
-			for (auto [id, type] : ct.cell_types) {
+			for (auto [id, type] : ct.all_types()) {
 				auto &tdata = tinfo.data[id];
 				tdata.has_inputs = true;
 				for (auto inp : type.inputs)
@@ -346,22 +346,41 @@ statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTL
 	return mod_data;
 }
 
-void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string liberty_file)
+void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string liberty_file, RTLIL::Design *design)
 {
-	std::istream* f = uncompressed(liberty_file.c_str());
-	yosys_input_files.insert(liberty_file);
-	LibertyParser libparser(*f, liberty_file);
-	delete f;
+	// Only the areas of cell types instantiated in the design are looked up,
+	// which lets the liberty disk cache skip loading all other cells. If none
+	// of them are found in partially loaded data, the whole file is loaded,
+	// as a non-empty area table also enables reporting cells of unknown area.
+	pool<std::string> used_cells;
+	for (auto module : design->modules())
+		for (auto cell : module->cells())
+			if (cell->type.isPublic())
+				used_cells.insert(cell->type.str().substr(1));
 
-	for (auto cell : libparser.ast->children)
+	yosys_input_files.insert(liberty_file);
+	const pool<std::string> *cell_filters[] = {&used_cells, nullptr};
+	for (auto cells : cell_filters)
 	{
-		if (cell->id != "cell" || cell->args.size() != 1)
-			continue;
+		std::istream* f = uncompressed(liberty_file.c_str());
+		LibertyParser libparser(*f, liberty_file, cells);
+		delete f;
+
+		bool found = false;
+		for (auto cell : libparser.ast->children)
+		{
+			if (cell->id != "cell" || cell->args.size() != 1)
+				continue;
 
-		const LibertyAst *ar = cell->find("area");
-		bool is_flip_flop = cell->find("ff") != nullptr;
-		if (ar != nullptr && !ar->value.empty())
-			cell_area["\\" + cell->args[0]] = {/*area=*/atof(ar->value.c_str()), is_flip_flop};
+			const LibertyAst *ar = cell->find("area");
+			bool is_flip_flop = cell->find("ff") != nullptr;
+			if (ar != nullptr && !ar->value.empty()) {
+				cell_area["\\" + cell->args[0]] = {/*area=*/atof(ar->value.c_str()), is_flip_flop};
+				found = true;
+			}
+		}
+		if (found || !libparser.partial)
+			break;
 	}
 }
 
@@ -415,7 +434,7 @@ struct StatPass : public Pass {
 			if (args[argidx] == "-liberty" && argidx+1 < args.size()) {
 				string liberty_file = args[++argidx];
 				rewrite_filename(liberty_file);
-				read_liberty_cellarea(cell_area, liberty_file);
+				read_liberty_cellarea(cell_area, liberty_file, design);
 				continue;
 			}
 			if (args[argidx] == "-tech" && argidx+1 < args.size()) {
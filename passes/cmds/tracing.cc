@@ -0,0 +1,107 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/tracing.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct TracingPass : public Pass {
+	TracingPass() : Pass("tracing", "write a timeline of executed commands") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    tracing -o <file.json>\n");
+		log("    tracing -stop\n");
+		log("    tracing -mark <text>\n");
+		log("\n");
+		log("Record a timeline of all commands executed from now on to the given file, using\n");
+		log("the Chrome trace event format. The file can be loaded into chrome://tracing or\n");
+		log("https://ui.perfetto.dev.\n");
+		log("\n");
+		log("Every command, including commands called from within other commands (e.g. the\n");
+		log("sub-commands of 'opt' or 'synth'), is recorded as a nested span. The span\n");
+		log("arguments contain the command line, the number of modules, cells and wires in\n");
+		log("the design before and after the command, and the resident memory size. Passes\n");
+		log("that work module by module record a nested span for each module. The resident\n");
+		log("memory size is also recorded as a counter track.\n");
+		log("\n");
+		log("Events are written as they happen, so the trace of a run that is terminated\n");
+		log("prematurely can still be loaded.\n");
+		log("\n");
+		log("The same trace can be enabled for a whole run with 'yosys --trace-json <file>'.\n");
+		log("\n");
+		log("    -o <file.json>\n");
+		log("        start tracing to the specified file. An already running trace is\n");
+		log("        stopped first.\n");
+		log("\n");
+		log("    -stop\n");
+		log("        stop tracing and close the trace file.\n");
+		log("\n");
+		log("    -mark <text>\n");
+		log("        add an instant event with the given text to the timeline.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		std::string filename, mark;
+		bool stop = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-o" && argidx+1 < args.size()) {
+				filename = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-stop") {
+				stop = true;
+				continue;
+			}
+			if (args[argidx] == "-mark" && argidx+1 < args.size()) {
+				mark = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design, false);
+
+		if (filename.empty() && !stop && mark.empty())
+			log_cmd_error("At least one of -o, -stop or -mark is required.\n");
+
+		if (stop) {
+			if (!trace_enabled())
+				log_warning("Tracing is not active.\n");
+			trace_stop();
+		}
+
+		if (!filename.empty()) {
+			rewrite_filename(filename);
+			log("Writing trace to `%s'.\n", filename.c_str());
+			trace_start(filename);
+		}
+
+		if (!mark.empty())
+			trace_instant(mark, "mark");
+	}
+} TracingPass;
+
+PRIVATE_NAMESPACE_END
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/patterneval.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -31,6 +32,7 @@ struct EquivSimpleWorker
 
 	SigMap &sigmap;
 	dict<SigBit, Cell*> &bit2driver;
+	const PatternEval &sim;
 
 	ezSatPtr ez;
 	SatGen satgen;
@@ -40,9 +42,9 @@ struct EquivSimpleWorker
 
 	pool<pair<Cell*, int>> imported_cells_cache;
 
-	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
+	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, const PatternEval &sim, int max_seq, bool short_cones, bool verbose, bool model_undef) :
 			module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
-			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
+			sigmap(sigmap), bit2driver(bit2driver), sim(sim), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
 	{
 		satgen.model_undef = model_undef;
 	}
@@ -94,6 +96,13 @@ struct EquivSimpleWorker
 		SigBit bit_b = sigmap(equiv_cell->getPort(ID::B)).as_bit();
 		int ez_context = ez->frozen_literal();
 
+		// the simulation starts with free flip-flop states max_seq steps
+		// before the checked time step, so a pattern where A and B differ is
+		// a model of the SAT problem for every sequence length
+		bool sim_failed = false;
+		for (int w = 0; w < sim.num_words() && !sim_failed; w++)
+			sim_failed = sim.differ(bit_a, bit_b, w) != 0;
+
 		if (satgen.model_undef)
 		{
 			int ez_a = satgen.importSigBit(bit_a, max_seq+1);
@@ -201,6 +210,12 @@ struct EquivSimpleWorker
 			if (verbose)
 				log("    Problem size at t=%d: %d literals, %d clauses\n", step, ez->numCnfVariables(), ez->numCnfClauses());
 
+			if (sim_failed) {
+				if (verbose)
+					log("    Found counterexample in random simulation.\n");
+				break;
+			}
+
 			if (!ez->solve(ez_context)) {
 				log(verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n");
 				equiv_cell->setPort(ID::B, equiv_cell->getPort(ID::A));
@@ -374,6 +389,11 @@ struct EquivSimplePass : public Pass {
 							bit2driver[bit] = cell;
 			}
 
+			PatternEval sim(module, sigmap, ct);
+			sim.randomize();
+			for (int i = 0; i < max_seq; i++)
+				sim.step();
+
 			unproven_equiv_cells.sort();
 			for (auto it : unproven_equiv_cells)
 			{
@@ -383,7 +403,7 @@ struct EquivSimplePass : public Pass {
 				for (auto it2 : it.second)
 					cells.push_back(it2.second);
 
-				EquivSimpleWorker worker(cells, sigmap, bit2driver, max_seq, short_cones, verbose, model_undef);
+				EquivSimpleWorker worker(cells, sigmap, bit2driver, sim, max_seq, short_cones, verbose, model_undef);
 				success_counter += worker.run();
 			}
 		}
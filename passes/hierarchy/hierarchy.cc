@@ -439,8 +439,14 @@ void check_cell_connections(const RTLIL::Module &module, RTLIL::Cell &cell, RTLI
 	}
 }
 
+// Parametric variants derived in the current round of expand_module() calls,
+// by module name and parameter set. Further instances with the same
+// parameters reuse the variant without another trip through derive(), which
+// scans and logs the parameters of every instance.
+typedef dict<RTLIL::IdString, dict<dict<RTLIL::IdString, RTLIL::Const>, RTLIL::IdString>> DerivedVariants;
+
 bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check, bool flag_simcheck, bool flag_smtcheck,
-		   std::vector<std::string> &libdirs)
+		   std::vector<std::string> &libdirs, DerivedVariants &derived_variants)
 {
 	bool did_something = false;
 	std::map<RTLIL::Cell*, std::pair<int, int>> array_cells;
@@ -527,10 +533,25 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 			continue;
 		}
 
-		cell->type = mod->derive(design,
-					 cell->parameters,
-					 if_expander.interfaces_to_add_to_submodule,
-					 if_expander.modports_used_in_submodule);
+		if (if_expander.interfaces_to_add_to_submodule.empty() && if_expander.modports_used_in_submodule.empty()) {
+			auto &variants = derived_variants[mod->name];
+			auto it = variants.find(cell->parameters);
+			if (it != variants.end() && design->module(it->second) != nullptr) {
+				cell->type = it->second;
+			} else {
+				IdString derived_type = mod->derive(design,
+								    cell->parameters,
+								    if_expander.interfaces_to_add_to_submodule,
+								    if_expander.modports_used_in_submodule);
+				variants[cell->parameters] = derived_type;
+				cell->type = derived_type;
+			}
+		} else {
+			cell->type = mod->derive(design,
+						 cell->parameters,
+						 if_expander.interfaces_to_add_to_submodule,
+						 if_expander.modports_used_in_submodule);
+		}
 		cell->parameters.clear();
 		did_something = true;
 
@@ -1087,8 +1108,9 @@ struct HierarchyPass : public Pass {
 					used_modules.insert(mod);
 			}
 
+			DerivedVariants derived_variants;
 			for (auto module : used_modules) {
-				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs))
+				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs, derived_variants))
 					did_something = true;
 			}
 
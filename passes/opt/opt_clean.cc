@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
+#include "kernel/tracing.h"
 #include "kernel/ffinit.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -106,7 +107,7 @@ int count_rm_cells, count_rm_wires;
 
 void rmunused_module_cells(Module *module, bool verbose)
 {
-	SigMap sigmap(module);
+	const SigMap &sigmap = module->sigmap();
 	dict<IdString, pool<Cell*>> mem2cells;
 	pool<IdString> mem_unused;
 	pool<Cell*> queue, unused;
@@ -350,6 +351,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 
 	// we are removing all connections
 	module->connections_.clear();
+	module->invalidate_sigmap();
 
 	// used signals sigmapped
 	SigPool used_signals;
@@ -675,6 +677,7 @@ struct OptCleanPass : public Pass {
 		for (auto module : design->selected_whole_modules_warn()) {
 			if (module->has_processes_warn())
 				continue;
+			TraceScope trace_scope(module);
 			rmunused_module(module, purge_mode, true, true);
 		}
 
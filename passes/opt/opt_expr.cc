@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
+#include "kernel/tracing.h"
 #include "kernel/utils.h"
 #include "kernel/log.h"
 #include <stdlib.h>
@@ -33,7 +34,7 @@ bool did_something;
 
 void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 {
-	SigMap sigmap(module);
+	const SigMap &sigmap = module->sigmap();
 	SigPool driven_signals;
 	SigPool used_signals;
 	SigPool all_signals;
@@ -94,7 +95,7 @@ void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 
 	if (!revisit_initwires.empty())
 	{
-		SigMap sm2(module);
+		const SigMap &sm2 = module->sigmap();
 
 		for (auto wire : revisit_initwires) {
 			SigSpec sig = sm2(wire);
@@ -2257,7 +2258,7 @@ skip_alu_split:
 }
 
 void replace_const_connections(RTLIL::Module *module) {
-	SigMap assign_map(module);
+	const SigMap &assign_map = module->sigmap();
 	for (auto cell : module->selected_cells())
 	{
 		std::vector<std::pair<RTLIL::IdString, SigSpec>> changes;
@@ -2362,6 +2363,7 @@ struct OptExprPass : public Pass {
 		for (auto module : design->selected_modules())
 		{
 			log("Optimizing module %s.\n", log_id(module));
+			TraceScope trace_scope(module);
 
 			if (undriven) {
 				did_something = false;
@@ -49,9 +49,9 @@ struct OptMemPriorityPass : public Pass {
 		int total_count = 0;
 		for (auto module : design->selected_modules()) {
 			modwalker.setup(module);
+			QuickConeSat qcsat(modwalker);
 			for (auto &mem : Mem::get_selected_memories(module)) {
 				bool mem_changed = false;
-				QuickConeSat qcsat(modwalker);
 				for (int i = 0; i < GetSize(mem.wr_ports); i++) {
 					auto &wport1 = mem.wr_ports[i];
 					for (int j = 0; j < GetSize(mem.wr_ports); j++) {
@@ -22,6 +22,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
+#include "kernel/tracing.h"
 #include "libs/sha1/sha1.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,7 +38,7 @@ struct OptMergeWorker
 {
 	RTLIL::Design *design;
 	RTLIL::Module *module;
-	SigMap assign_map;
+	const SigMap &assign_map;
 	FfInitVals initvals;
 	bool mode_share_all;
 
@@ -227,7 +228,7 @@ struct OptMergeWorker
 	}
 
 	OptMergeWorker(RTLIL::Design *design, RTLIL::Module *module, bool mode_nomux, bool mode_share_all, bool mode_keepdc) :
-		design(design), module(module), assign_map(module), mode_share_all(mode_share_all)
+		design(design), module(module), assign_map(module->sigmap()), mode_share_all(mode_share_all)
 	{
 		total_count = 0;
 		ct.setup_internals();
@@ -236,20 +237,18 @@ struct OptMergeWorker
 		ct.setup_stdcells_mem();
 
 		if (mode_nomux) {
-			ct.cell_types.erase(ID($mux));
-			ct.cell_types.erase(ID($pmux));
+			ct.erase(ID($mux));
+			ct.erase(ID($pmux));
 		}
 
-		ct.cell_types.erase(ID($tribuf));
-		ct.cell_types.erase(ID($_TBUF_));
-		ct.cell_types.erase(ID($anyseq));
-		ct.cell_types.erase(ID($anyconst));
-		ct.cell_types.erase(ID($allseq));
-		ct.cell_types.erase(ID($allconst));
+		ct.erase(ID($tribuf));
+		ct.erase(ID($_TBUF_));
+		ct.erase(ID($anyseq));
+		ct.erase(ID($anyconst));
+		ct.erase(ID($allseq));
+		ct.erase(ID($allconst));
 
 		log("Finding identical cells in module `%s'.\n", module->name.c_str());
-		assign_map.set(module);
-
 		initvals.set(&assign_map, module);
 
 		bool did_something = true;
@@ -329,7 +328,6 @@ struct OptMergeWorker
 							initvals.remove_init(it.second);
 							initvals.remove_init(other_sig);
 							module->connect(RTLIL::SigSig(it.second, other_sig));
-							assign_map.add(it.second, other_sig);
 							initvals.set_init(other_sig, init);
 						}
 					}
@@ -394,6 +392,7 @@ struct OptMergePass : public Pass {
 
 		int total_count = 0;
 		for (auto module : design->selected_modules()) {
+			TraceScope trace_scope(module);
 			OptMergeWorker worker(design, module, mode_nomux, mode_share_all, mode_keepdc);
 			total_count += worker.total_count;
 		}
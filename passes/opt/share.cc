@@ -1039,6 +1039,28 @@ struct ShareWorker
 		return simplified;
 	}
 
+	// Checks if the patterns on their own (i.e. without considering their input cone) are mutually exclusive.
+	bool patterns_exclusive(const pool<ssc_pair_t> &activation_patterns, const pool<ssc_pair_t> &other_activation_patterns)
+	{
+		auto add_bits = [&](const ssc_pair_t &pattern, dict<SigBit, State> &bits) {
+			for (int i = 0; i < GetSize(pattern.second); i++) {
+				SigBit bit = modwalker.sigmap(pattern.first[i]);
+				State val = pattern.second[i];
+				if (bit.wire == nullptr ? bit.data != val : bits.emplace(bit, val).first->second != val)
+					return false;
+			}
+			return true;
+		};
+
+		for (auto &p1 : activation_patterns)
+			for (auto &p2 : other_activation_patterns) {
+				dict<SigBit, State> bits;
+				if (add_bits(p1, bits) && add_bits(p2, bits))
+					return false;
+			}
+		return true;
+	}
+
 	// Only valid if the patterns on their own (i.e. without considering their input cone) are mutually exclusive!
 	bool restrict_activation_patterns(pool<ssc_pair_t> &activation_patterns, pool<ssc_pair_t> &other_activation_patterns)
 	{
@@ -1214,16 +1236,16 @@ struct ShareWorker
 		fwd_ct.setup_internals();
 
 		cone_ct.setup_internals();
-		cone_ct.cell_types.erase(ID($mul));
-		cone_ct.cell_types.erase(ID($mod));
-		cone_ct.cell_types.erase(ID($div));
-		cone_ct.cell_types.erase(ID($modfloor));
-		cone_ct.cell_types.erase(ID($divfloor));
-		cone_ct.cell_types.erase(ID($pow));
-		cone_ct.cell_types.erase(ID($shl));
-		cone_ct.cell_types.erase(ID($shr));
-		cone_ct.cell_types.erase(ID($sshl));
-		cone_ct.cell_types.erase(ID($sshr));
+		cone_ct.erase(ID($mul));
+		cone_ct.erase(ID($mod));
+		cone_ct.erase(ID($div));
+		cone_ct.erase(ID($modfloor));
+		cone_ct.erase(ID($divfloor));
+		cone_ct.erase(ID($pow));
+		cone_ct.erase(ID($shl));
+		cone_ct.erase(ID($shr));
+		cone_ct.erase(ID($sshl));
+		cone_ct.erase(ID($sshr));
 	}
 
 	void operator()(RTLIL::Module *module) {
@@ -1254,6 +1276,14 @@ struct ShareWorker
 		log("Found %d cells in module %s that may be considered for resource sharing.\n",
 				GetSize(shareable_cells), log_id(module));
 
+		// one SAT context for all queries in this module, the cones of the
+		// control signals of different cell pairs overlap a lot
+		QuickConeSat qcsat(modwalker);
+		if (config.opt_fast) {
+			qcsat.max_cell_outs = 3;
+			qcsat.max_cell_count = 100;
+		}
+
 		while (!shareable_cells.empty() && config.limit != 0)
 		{
 			RTLIL::Cell *cell = *shareable_cells.begin();
@@ -1332,12 +1362,6 @@ struct ShareWorker
 				optimize_activation_patterns(filtered_cell_activation_patterns);
 				optimize_activation_patterns(filtered_other_cell_activation_patterns);
 
-				QuickConeSat qcsat(modwalker);
-				if (config.opt_fast) {
-					qcsat.max_cell_outs = 3;
-					qcsat.max_cell_count = 100;
-				}
-
 				std::set<RTLIL::SigBit> bits_queue;
 
 				std::vector<int> cell_active, other_cell_active;
@@ -1357,7 +1381,7 @@ struct ShareWorker
 				int sub1 = qcsat.ez->expression(qcsat.ez->OpOr, cell_active);
 				int sub2 = qcsat.ez->expression(qcsat.ez->OpOr, other_cell_active);
 
-				bool pattern_only_solve = qcsat.ez->solve(qcsat.ez->AND(sub1, sub2));
+				bool pattern_only_solve = !patterns_exclusive(filtered_cell_activation_patterns, filtered_other_cell_activation_patterns);
 				qcsat.prepare();
 
 				if (!qcsat.ez->solve(sub1)) {
@@ -1377,18 +1401,14 @@ struct ShareWorker
 				pool<ssc_pair_t> optimized_other_cell_activation_patterns = filtered_other_cell_activation_patterns;
 
 				if (pattern_only_solve) {
-					qcsat.ez->non_incremental();
-
 					all_ctrl_signals.sort_and_unify();
 					std::vector<int> sat_model = qcsat.importSig(all_ctrl_signals);
 					std::vector<bool> sat_model_values;
 
-					qcsat.ez->assume(qcsat.ez->AND(sub1, sub2));
-
 					log("      Size of SAT problem: %zu cells, %d variables, %d clauses\n",
 							qcsat.imported_cells.size(), qcsat.ez->numCnfVariables(), qcsat.ez->numCnfClauses());
 
-					if (qcsat.ez->solve(sat_model, sat_model_values)) {
+					if (qcsat.ez->solve(sat_model, sat_model_values, qcsat.ez->AND(sub1, sub2))) {
 						log("      According to the SAT solver this pair of cells can not be shared.\n");
 						log("      Model from SAT solver: %s = %d'", log_signal(all_ctrl_signals), GetSize(sat_model_values));
 						for (int i = GetSize(sat_model_values)-1; i >= 0; i--)
@@ -1487,6 +1507,9 @@ struct ShareWorker
 			}
 		}
 
+		if (!qcsat.imported_cells.empty())
+			qcsat.log_stats();
+
 		if (!cells_to_remove.empty()) {
 			log("Removing %d cells in module %s:\n", GetSize(cells_to_remove), log_id(module));
 			for (auto c : cells_to_remove) {
@@ -23,6 +23,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/patterneval.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -230,6 +231,7 @@ struct PerformReduction
 	SigMap &sigmap;
 	drivers_t &drivers;
 	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs;
+	PatternEval &sim;
 	pool<SigBit> recursion_guard;
 
 	ezSatPtr ez;
@@ -279,8 +281,8 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
-	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
-			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
+	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, PatternEval &sim, std::vector<RTLIL::SigBit> &bits, int cone_size) :
+			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), sim(sim), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
 	{
 		satgen.model_undef = true;
 
@@ -347,6 +349,51 @@ struct PerformReduction
 		results[result_idx].push_back(bit);
 	}
 
+	// The random patterns are consistent assignments of the whole module with
+	// all free bits defined, so any pattern where one signal in the bucket is
+	// 1 and another is 0 is also a SAT model and the solver can be skipped.
+	bool split_by_simulation(std::vector<std::set<int>> &results, std::map<int, int> &results_map, std::vector<int> &bucket, std::string indent1, std::string indent2)
+	{
+		for (int w = 0; w < sim.num_words(); w++)
+		{
+			PatternEval::word_t any_set = 0, any_clr = 0;
+			for (int idx : bucket) {
+				PatternEval::word_t value = sim.value(out_bits[idx])[w];
+				PatternEval::word_t def = sim.defined(out_bits[idx])[w];
+				if (out_inverted[idx])
+					value = ~value;
+				any_set |= value & def;
+				any_clr |= ~value & def;
+			}
+
+			PatternEval::word_t split = any_set & any_clr;
+			if (split == 0)
+				continue;
+
+			PatternEval::word_t mask = split & -split;
+			std::vector<int> buckets_a;
+			std::vector<int> buckets_b;
+
+			for (int idx : bucket) {
+				bool value = (sim.value(out_bits[idx])[w] & mask) != 0;
+				bool def = (sim.defined(out_bits[idx])[w] & mask) != 0;
+				if (!def || value != out_inverted[idx])
+					buckets_a.push_back(idx);
+				if (!def || value == out_inverted[idx])
+					buckets_b.push_back(idx);
+			}
+
+			if (verbose_level >= 1)
+				log("%s    Split by simulation: %d set vs. %d clr\n", (indent1 + indent2).c_str(),
+						GetSize(bucket) - GetSize(buckets_b), GetSize(bucket) - GetSize(buckets_a));
+
+			analyze(results, results_map, buckets_a, indent1 + ".", indent2 + "  ");
+			analyze(results, results_map, buckets_b, indent1 + "x", indent2 + "  ");
+			return true;
+		}
+		return false;
+	}
+
 	void analyze(std::vector<std::set<int>> &results, std::map<int, int> &results_map, std::vector<int> &bucket, std::string indent1, std::string indent2)
 	{
 		std::string indent = indent1 + indent2;
@@ -365,6 +412,9 @@ struct PerformReduction
 			log("%s  Trying to shatter bucket with %d signals: %s\n", indt, int(bucket.size()), log_signal(bucket_sigbits));
 		}
 
+		if (split_by_simulation(results, results_map, bucket, indent1, indent2))
+			return;
+
 		std::vector<int> sat_set_list, sat_clr_list;
 		for (int idx : bucket) {
 			sat_set_list.push_back(ez->AND(sat_out[idx], sat_def[idx]));
@@ -666,6 +716,9 @@ struct FreduceWorker
 		}
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
+		PatternEval sim(module, sigmap, ct);
+		sim.randomize();
+
 		int bucket_count = 0;
 		std::vector<std::vector<equiv_bit_t>> equiv;
 		for (auto &bucket : buckets)
@@ -677,12 +730,12 @@ struct FreduceWorker
 
 			if (bucket.first.size() == 0) {
 				log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
+				PerformReduction worker(sigmap, drivers, inv_pairs, sim, bucket.second, bucket.first.size());
 				for (size_t idx = 0; idx < bucket.second.size(); idx++)
 					worker.analyze_const(equiv, idx);
 			} else {
 				log("  Trying to shatter bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
+				PerformReduction worker(sigmap, drivers, inv_pairs, sim, bucket.second, bucket.first.size());
 				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
 			}
 		}
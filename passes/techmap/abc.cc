@@ -47,7 +47,9 @@
 #include "kernel/ffinit.h"
 #include "kernel/ff.h"
 #include "kernel/cost.h"
+#include "kernel/tracing.h"
 #include "kernel/log.h"
+#include "kernel/io.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -1159,16 +1161,16 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
 
 		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
-		std::ifstream ifs;
-		ifs.open(buffer);
-		if (ifs.fail())
+		// an empty file can't be mapped but is a valid (empty) netlist
+		MappedFile mapped;
+		if (!mapped.open(buffer) && !check_file_exists(buffer))
 			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
 
 		bool builtin_lib = liberty_files.empty() && genlib_files.empty();
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		parse_blif(mapped_design, mapped.data, mapped.size, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
 
-		ifs.close();
+		mapped.close();
 
 		log_header(design, "Re-integrating ABC results.\n");
 		RTLIL::Module *mapped_mod = mapped_design->module(ID(netlist));
@@ -2049,6 +2051,7 @@ struct AbcPass : public Pass {
 				continue;
 			}
 
+			TraceScope trace_scope(mod);
 			assign_map.set(mod);
 			initvals.set(&assign_map, mod);
 
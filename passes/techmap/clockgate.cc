@@ -1,6 +1,5 @@
 #include "kernel/yosys.h"
 #include "kernel/ff.h"
-#include "kernel/gzip.h"
 #include "libparse.h"
 #include <optional>
 
@@ -308,12 +307,7 @@ struct ClockgatePass : public Pass {
 
 		if (!liberty_files.empty()) {
 			LibertyMergedCells merged;
-			for (auto path : liberty_files) {
-				std::istream* f = uncompressed(path);
-				LibertyParser p(*f, path);
-				merged.merge(p);
-				delete f;
-			}
+			merged.merge_files(liberty_files);
 			std::tie(pos_icg_desc, neg_icg_desc) =
 				find_icgs(merged.cells, dont_use_cells);
 		} else {
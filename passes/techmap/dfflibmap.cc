@@ -19,7 +19,6 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
-#include "kernel/gzip.h"
 #include "libparse.h"
 #include <string.h>
 #include <errno.h>
@@ -648,12 +647,7 @@ struct DfflibmapPass : public Pass {
 			log_cmd_error("Missing `-liberty liberty_file' option!\n");
 
 		LibertyMergedCells merged;
-		for (auto path : liberty_files) {
-			std::istream* f = uncompressed(path);
-			LibertyParser p(*f, path);
-			merged.merge(p);
-			delete f;
-		}
+		merged.merge_files(liberty_files);
 
 		find_cell(merged.cells, ID($_DFF_N_), false, false, false, false, false, false, dont_use_cells);
 		find_cell(merged.cells, ID($_DFF_P_), true, false, false, false, false, false, dont_use_cells);
@@ -54,6 +54,18 @@
 		log("    -verbose   Enable printing info when cache is used\n");
 		log("    -quiet     Disable printing info when cache is used (default)\n");
 		log("\n");
+		log("    libcache -dir <directory>\n");
+		log("    libcache -nodir\n");
+		log("\n");
+		log("Stores a compact binary copy of every liberty file parsed from now on in the\n");
+		log("given directory, which is created if necessary, and loads the data from there\n");
+		log("instead of parsing the file again, also in later invocations. Copies are\n");
+		log("identified by the absolute file path and are ignored once the size, inode or\n");
+		log("modification time of the file changes. Files modified less than two seconds\n");
+		log("before they are read are not copied. Commands that only need a few cells from\n");
+		log("a large library (such as 'stat -liberty') only load those cells from the copy.\n");
+		log("-nodir stops using the directory.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *) override
 	{
@@ -64,6 +76,8 @@
 		bool list = false;
 		bool verbose = false;
 		bool quiet = false;
+		bool set_dir = false;
+		std::string dir;
 		std::vector<std::string> paths;
 
 		size_t argidx;
@@ -96,16 +110,35 @@
 				quiet = true;
 				continue;
 			}
+			if (args[argidx] == "-dir" && argidx+1 < args.size()) {
+				set_dir = true;
+				dir = args[++argidx];
+				rewrite_filename(dir);
+				continue;
+			}
+			if (args[argidx] == "-nodir") {
+				set_dir = true;
+				continue;
+			}
 			std::string fname = args[argidx];
 			rewrite_filename(fname);
 			paths.push_back(fname);
 			break;
 		}
-		int modes = enable + disable + purge + list + verbose + quiet;
+		int modes = enable + disable + purge + list + verbose + quiet + set_dir;
 		if (modes == 0)
-			log_cmd_error("At least one of -enable, -disable, -purge, -list,\n-verbose, or -quiet is required.\n");
+			log_cmd_error("At least one of -enable, -disable, -purge, -list,\n-verbose, -quiet, -dir or -nodir is required.\n");
 		if (modes > 1)
-			log_cmd_error("Only one of -enable, -disable, -purge, -list,\n-verbose, or -quiet may be present.\n");
+			log_cmd_error("Only one of -enable, -disable, -purge, -list,\n-verbose, -quiet, -dir or -nodir may be present.\n");
+
+		if (set_dir) {
+			if (all || !paths.empty())
+				log_cmd_error("The -dir and -nodir modes take no further options.\n");
+			if (!dir.empty() && !check_directory_exists(dir) && !create_directory(dir))
+				log_cmd_error("Can't create cache directory `%s'.\n", dir.c_str());
+			LibertyAstCache::instance.disk_dir = dir;
+			return;
+		}
 
 		if (all && !paths.empty())
 			log_cmd_error("The -all option cannot be combined with a list of paths.\n");
@@ -116,6 +149,8 @@
 
 		if (list) {
 			log("Caching is %s by default.\n", LibertyAstCache::instance.cache_by_default ? "enabled" : "disabled");
+			if (!LibertyAstCache::instance.disk_dir.empty())
+				log("Storing parsed data in `%s'.\n", LibertyAstCache::instance.disk_dir.c_str());
 			for (auto const &entry : LibertyAstCache::instance.cache_path)
 				log("Caching is %s for `%s'.\n", entry.second ? "enabled" : "disabled", entry.first.c_str());
 			for (auto const &entry : LibertyAstCache::instance.cached)
@@ -27,7 +27,11 @@
 #include <sstream>
 
 #ifndef FILTERLIB
+#include "kernel/gzip.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
+#include "libs/sha1/sha1.h"
+#include <sys/stat.h>
 #endif
 
 using namespace Yosys;
@@ -57,6 +61,233 @@ void LibertyAstCache::parsed_ast(const std::string &fname, const std::shared_ptr
 	cached.emplace(fname, ast);
 }
 
+// Binary format of the disk cache, all integers in native byte order:
+//
+//   header:  "YSLIBAST", u32 version, u32 byte order mark, i64 source size,
+//            i64 source mtime, i64 source ctime, u64 source device, u64 source
+//            inode (see FileStamp), string canonical source path
+//   root:    node fields of the top level group, u32 number of children
+//   index:   per child u64 file offset and string cell name (empty when the
+//            child is not a cell group with a single argument)
+//   nodes:   strings id and value, u32 + strings args, u32 + nodes children
+//
+// where a string is a u32 length followed by the bytes.
+
+namespace {
+
+const char libcache_magic[8] = {'Y', 'S', 'L', 'I', 'B', 'A', 'S', 'T'};
+const uint32_t libcache_version = 2;
+const uint32_t libcache_bom = 0x01020304;
+
+// Entries are keyed on the canonical path, so that the same relative path
+// from different working directories doesn't share an entry
+std::string disk_cache_file(const std::string &dir, const std::string &path)
+{
+	return dir + "/" + sha1(path) + ".ylib";
+}
+
+struct LibcacheWriter
+{
+	std::string data;
+
+	template<typename T> void put(T value) {
+		data.append((const char *)&value, sizeof(T));
+	}
+	void put_string(const std::string &str) {
+		put<uint32_t>(str.size());
+		data.append(str);
+	}
+	void put_stamp(const FileStamp &stamp) {
+		put<int64_t>(stamp.size);
+		put<int64_t>(stamp.mtime);
+		put<int64_t>(stamp.ctime);
+		put<uint64_t>(stamp.dev);
+		put<uint64_t>(stamp.ino);
+	}
+	void put_fields(const LibertyAst *node) {
+		put_string(node->id);
+		put_string(node->value);
+		put<uint32_t>(node->args.size());
+		for (auto &arg : node->args)
+			put_string(arg);
+	}
+	void put_node(const LibertyAst *node) {
+		put_fields(node);
+		put<uint32_t>(node->children.size());
+		for (auto child : node->children)
+			put_node(child);
+	}
+};
+
+struct LibcacheReader
+{
+	const char *data;
+	size_t size, pos = 0;
+	bool ok = true;
+
+	LibcacheReader(const char *data, size_t size) : data(data), size(size) {}
+
+	template<typename T> T get() {
+		T value = T();
+		if (size - pos < sizeof(T)) {
+			ok = false;
+			pos = size;
+			return value;
+		}
+		memcpy(&value, data + pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+	std::string get_string() {
+		uint32_t len = get<uint32_t>();
+		if (size - pos < len) {
+			ok = false;
+			pos = size;
+			return std::string();
+		}
+		std::string str(data + pos, len);
+		pos += len;
+		return str;
+	}
+	FileStamp get_stamp() {
+		FileStamp stamp;
+		stamp.size = get<int64_t>();
+		stamp.mtime = get<int64_t>();
+		stamp.ctime = get<int64_t>();
+		stamp.dev = get<uint64_t>();
+		stamp.ino = get<uint64_t>();
+		return stamp;
+	}
+	void get_fields(LibertyAst *node) {
+		node->id = get_string();
+		node->value = get_string();
+		uint32_t num_args = get<uint32_t>();
+		for (uint32_t i = 0; i < num_args && ok; i++)
+			node->args.push_back(get_string());
+	}
+	LibertyAst *get_node() {
+		LibertyAst *node = new LibertyAst;
+		get_fields(node);
+		uint32_t num_children = get<uint32_t>();
+		for (uint32_t i = 0; i < num_children && ok; i++)
+			node->children.push_back(get_node());
+		return node;
+	}
+};
+
+}
+
+std::shared_ptr<const LibertyAst> LibertyAstCache::disk_cached_ast(const std::string &fname, const pool<std::string> *cells, bool &complete, FileStamp &source)
+{
+	complete = false;
+	source = FileStamp();
+	if (disk_dir.empty())
+		return nullptr;
+
+	if (!source.read(fname) || source.size < 0)
+		return nullptr;
+
+	std::string path = canonical_path(fname);
+	MappedFile file;
+	if (!file.open(disk_cache_file(disk_dir, path)))
+		return nullptr;
+
+	LibcacheReader reader(file.data, file.size);
+	if (file.size < sizeof(libcache_magic) || memcmp(file.data, libcache_magic, sizeof(libcache_magic)))
+		return nullptr;
+	reader.pos = sizeof(libcache_magic);
+	if (reader.get<uint32_t>() != libcache_version || reader.get<uint32_t>() != libcache_bom)
+		return nullptr;
+	if (reader.get_stamp() != source || reader.get_string() != path || !reader.ok)
+		return nullptr;
+
+	std::unique_ptr<LibertyAst> ast(new LibertyAst);
+	reader.get_fields(ast.get());
+	uint32_t num_children = reader.get<uint32_t>();
+
+	std::vector<std::pair<uint64_t, std::string>> index;
+	for (uint32_t i = 0; i < num_children && reader.ok; i++) {
+		uint64_t offset = reader.get<uint64_t>();
+		index.emplace_back(offset, reader.get_string());
+	}
+
+	complete = true;
+	for (auto &entry : index) {
+		if (!reader.ok)
+			break;
+		if (cells != nullptr && !entry.second.empty() && !cells->count(entry.second)) {
+			complete = false;
+			continue;
+		}
+		if (entry.first >= file.size) {
+			reader.ok = false;
+			break;
+		}
+		reader.pos = entry.first;
+		ast->children.push_back(reader.get_node());
+	}
+
+	if (!reader.ok) {
+		log_warning("Ignoring corrupt liberty cache file for `%s'.\n", fname.c_str());
+		complete = false;
+		return nullptr;
+	}
+
+	if (verbose)
+		log("Using %s data from disk cache for liberty file `%s'\n", complete ? "all" : "partial", fname.c_str());
+	return std::shared_ptr<const LibertyAst>(ast.release());
+}
+
+void LibertyAstCache::store_disk_cache(const std::string &fname, const FileStamp &source, const LibertyAst *ast)
+{
+	if (disk_dir.empty() || ast == nullptr || source.size < 0)
+		return;
+	if (source.racy()) {
+		if (verbose)
+			log("Not storing liberty file `%s' in disk cache, it was modified just before it was read\n", fname.c_str());
+		return;
+	}
+
+	std::string path = canonical_path(fname);
+	LibcacheWriter writer;
+	writer.data.append(libcache_magic, sizeof(libcache_magic));
+	writer.put<uint32_t>(libcache_version);
+	writer.put<uint32_t>(libcache_bom);
+	writer.put_stamp(source);
+	writer.put_string(path);
+	writer.put_fields(ast);
+	writer.put<uint32_t>(ast->children.size());
+
+	// offsets are patched in once the children have been written
+	std::vector<size_t> offset_pos;
+	for (auto child : ast->children) {
+		offset_pos.push_back(writer.data.size());
+		writer.put<uint64_t>(0);
+		bool is_cell = child->id == "cell" && child->args.size() == 1;
+		writer.put_string(is_cell ? child->args[0] : std::string());
+	}
+	for (int i = 0; i < GetSize(ast->children); i++) {
+		uint64_t offset = writer.data.size();
+		memcpy(&writer.data[offset_pos[i]], &offset, sizeof(offset));
+		writer.put_node(ast->children[i]);
+	}
+
+	// write to a temporary file first so that concurrent runs never see a
+	// partially written cache file
+	std::string cache_file = disk_cache_file(disk_dir, path);
+	std::string temp_file = make_temp_file(cache_file + ".XXXXXX");
+	std::ofstream f(temp_file, std::ios::binary);
+	f.write(writer.data.data(), writer.data.size());
+	f.close();
+	if (f.fail() || rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+		remove(temp_file.c_str());
+		log_warning("Failed to write liberty cache file `%s'.\n", cache_file.c_str());
+		return;
+	}
+	if (verbose)
+		log("Stored data for liberty file `%s' in disk cache\n", fname.c_str());
+}
+
 #endif
 
 bool LibertyInputStream::extend_buffer_once()
@@ -114,6 +345,315 @@ int LibertyInputStream::peek_cold(size_t offset)
 	return buffer[buf_pos + offset];
 }
 
+#ifndef FILTERLIB
+
+namespace {
+
+// Splits the body of the top-level group in a liberty file into ranges of
+// complete statements, each ending with the closing brace of a group and
+// spanning at least target_size bytes. Strings and comments are skipped the
+// same way LibertyParser::lexer() does. Returns false when the file can't be
+// split, parsing it in one piece then gives the proper error messages.
+bool split_liberty_text(const std::string &text, size_t target_size, size_t &body_begin, std::vector<std::pair<size_t, size_t>> &chunks)
+{
+	size_t size = text.size();
+	size_t chunk_begin = 0;
+	int depth = 0;
+
+	for (size_t i = 0; i < size; i++) {
+		char c = text[i];
+		if (c == '"') {
+			i = text.find('"', i + 1);
+			if (i == std::string::npos)
+				return false;
+		} else if (c == '/' && i + 1 < size && text[i + 1] == '*') {
+			// the lexer lets the '*' of "/*" also end the comment
+			char last_c = '*';
+			for (i += 2; i < size && (last_c != '*' || text[i] != '/'); i++)
+				last_c = text[i];
+			if (i == size)
+				return false;
+		} else if (c == '/' && i + 1 < size && text[i + 1] == '/') {
+			i = text.find('\n', i);
+			if (i == std::string::npos)
+				return false;
+		} else if (c == '{') {
+			if (++depth == 1)
+				body_begin = chunk_begin = i + 1;
+		} else if (c == '}') {
+			if (depth == 0)
+				return false;
+			if (--depth == 0) {
+				if (i > chunk_begin)
+					chunks.emplace_back(chunk_begin, i);
+				return GetSize(chunks) > 1;
+			}
+			if (depth == 1 && i + 1 - chunk_begin >= target_size) {
+				chunks.emplace_back(chunk_begin, i + 1);
+				chunk_begin = i + 1;
+			}
+		}
+	}
+	return false;
+}
+
+// Read-only istream over memory owned by someone else
+struct MemoryStreamBuf : std::streambuf
+{
+	MemoryStreamBuf(const char *begin, const char *end) {
+		setg(const_cast<char *>(begin), const_cast<char *>(begin), const_cast<char *>(end));
+	}
+};
+
+// Files smaller than this are not split
+const size_t split_min_size = 16 << 20;
+const size_t split_min_chunk = 1 << 20;
+
+void read_all(std::istream &f, std::string &text)
+{
+	char buffer[65536];
+	while (f.read(buffer, sizeof(buffer)) || f.gcount() > 0)
+		text.append(buffer, f.gcount());
+}
+
+template<typename F>
+void run_parallel(int num_items, int num_threads, F body)
+{
+	ConcurrentQueue<int> queue;
+	for (int i = 0; i < num_items; i++)
+		queue.push_back(i);
+	queue.close();
+	auto worker = [&](int) {
+		while (auto item = queue.pop_front())
+			body(*item);
+	};
+	if (num_threads > 0 && num_items > 1)
+		ThreadPool pool(std::min(num_threads, num_items), worker);
+	else
+		worker(0);
+}
+
+}
+
+struct LibertyParser::ParseJob
+{
+	std::istream *f = nullptr;
+
+	// file contents when the file is split into chunks
+	std::string text;
+	size_t body_begin = 0;
+	std::vector<std::pair<size_t, size_t>> chunks;
+	std::vector<std::vector<LibertyAst *>> chunk_children;
+	std::vector<char> chunk_failed;
+
+	LibertyAst *ast = nullptr;
+	std::string error;
+};
+
+LibertyParser::LibertyParser(std::istream &f, const std::string &fname, const pool<std::string> *cells) : f(f), line(1)
+{
+	LibertyAstCache &cache = LibertyAstCache::instance;
+	shared_ast = cache.cached_ast(fname);
+	if (!shared_ast) {
+		bool complete;
+		FileStamp source;
+		shared_ast = cache.disk_cached_ast(fname, cells, complete, source);
+		if (!shared_ast) {
+			std::vector<ParseJob> jobs(1);
+			jobs[0].f = &f;
+			parse_jobs(jobs);
+			shared_ast.reset(jobs[0].ast);
+			cache.store_disk_cache(fname, source, shared_ast.get());
+			complete = true;
+		}
+		// partially loaded data must not be handed to other users
+		if (complete)
+			cache.parsed_ast(fname, shared_ast);
+		partial = !complete;
+	}
+	ast = shared_ast.get();
+	if (!ast) {
+		log_error("No entries found in liberty file `%s'.\n", fname.c_str());
+	}
+}
+
+LibertyAst *LibertyParser::parse_detached(std::istream &f)
+{
+	LibertyParser parser(f, true);
+	return parser.parse(true);
+}
+
+// Parses all jobs, on worker threads if available. Logs the first error in
+// job order on the calling thread.
+void LibertyParser::parse_jobs(std::vector<ParseJob> &jobs)
+{
+	int num_threads = ThreadPool::pool_size(1, 64);
+
+	// Workers can't report errors from gzip_istream, read these files here
+	for (auto &job : jobs)
+		if (dynamic_cast<std::ifstream *>(job.f) == nullptr) {
+			read_all(*job.f, job.text);
+			job.f = nullptr;
+		}
+
+	run_parallel(GetSize(jobs), num_threads, [&](int index) {
+		ParseJob &job = jobs[index];
+		try {
+			if (job.f != nullptr) {
+				std::streamoff remaining = 0;
+				if (num_threads > 0) {
+					std::streampos pos = job.f->tellg();
+					job.f->seekg(0, std::ios::end);
+					remaining = job.f->tellg() - pos;
+					job.f->seekg(pos);
+				}
+				if (remaining < std::streamoff(split_min_size)) {
+					job.ast = parse_detached(*job.f);
+					return;
+				}
+				read_all(*job.f, job.text);
+			}
+			if (num_threads > 0 && job.text.size() >= split_min_size) {
+				size_t target_size = std::max(split_min_chunk, job.text.size() / (4 * num_threads));
+				if (split_liberty_text(job.text, target_size, job.body_begin, job.chunks))
+					return;
+				job.chunks.clear();
+			}
+			MemoryStreamBuf buf(job.text.data(), job.text.data() + job.text.size());
+			std::istream s(&buf);
+			job.ast = parse_detached(s);
+		} catch (SyntaxError &e) {
+			job.error = e.message;
+		}
+	});
+
+	std::vector<std::pair<int, int>> chunk_items;
+	for (int i = 0; i < GetSize(jobs); i++) {
+		ParseJob &job = jobs[i];
+		job.chunk_children.resize(job.chunks.size());
+		job.chunk_failed.resize(job.chunks.size());
+		for (int j = 0; j < GetSize(job.chunks); j++)
+			chunk_items.emplace_back(i, j);
+	}
+
+	run_parallel(GetSize(chunk_items), num_threads, [&](int index) {
+		ParseJob &job = jobs[chunk_items[index].first];
+		int chunk = chunk_items[index].second;
+		const char *begin = job.text.data() + job.chunks[chunk].first;
+		const char *end = job.text.data() + job.chunks[chunk].second;
+		MemoryStreamBuf buf(begin, end);
+		std::istream s(&buf);
+		LibertyParser parser(s, true);
+		try {
+			while (LibertyAst *child = parser.parse(true))
+				job.chunk_children[chunk].push_back(child);
+		} catch (SyntaxError &) {
+			job.chunk_failed[chunk] = true;
+		}
+	});
+
+	for (auto &job : jobs) {
+		if (!job.chunks.empty()) {
+			// The body of the library is the concatenation of the chunks,
+			// the header is parsed with an empty body
+			bool ok = std::count(job.chunk_failed.begin(), job.chunk_failed.end(), 1) == 0;
+			if (ok) {
+				std::string header = job.text.substr(0, job.body_begin) + "}";
+				std::istringstream s(header);
+				LibertyParser parser(s, true);
+				try {
+					job.ast = parser.parse(true);
+					if (job.ast == nullptr || parser.parse(true) != nullptr || parser.f.peek() != EOF)
+						ok = false;
+				} catch (SyntaxError &) {
+					ok = false;
+				}
+			}
+			for (auto &children : job.chunk_children)
+				for (auto child : children) {
+					if (ok)
+						job.ast->children.push_back(child);
+					else
+						delete child;
+				}
+			if (!ok) {
+				// Statements before the library or a syntax error, parse
+				// the whole file again for the same result and errors
+				delete job.ast;
+				job.ast = nullptr;
+				MemoryStreamBuf buf(job.text.data(), job.text.data() + job.text.size());
+				std::istream s(&buf);
+				try {
+					job.ast = parse_detached(s);
+				} catch (SyntaxError &e) {
+					job.error = e.message;
+				}
+			}
+		}
+		std::string().swap(job.text);
+		if (!job.error.empty())
+			log_error("%s", job.error.c_str());
+	}
+}
+
+std::vector<std::shared_ptr<const LibertyAst>> LibertyParser::parse_files(const std::vector<std::string> &fnames)
+{
+	LibertyAstCache &cache = LibertyAstCache::instance;
+	std::vector<std::shared_ptr<const LibertyAst>> asts(fnames.size());
+	std::vector<FileStamp> sources(fnames.size());
+	std::vector<ParseJob> jobs;
+	std::vector<int> job_files;
+
+	for (int i = 0; i < GetSize(fnames); i++) {
+		asts[i] = cache.cached_ast(fnames[i]);
+		if (!asts[i]) {
+			bool complete;
+			asts[i] = cache.disk_cached_ast(fnames[i], nullptr, complete, sources[i]);
+		}
+		if (!asts[i]) {
+			jobs.emplace_back();
+			jobs.back().f = uncompressed(fnames[i]);
+			job_files.push_back(i);
+		}
+	}
+
+	std::vector<std::istream *> streams;
+	for (auto &job : jobs)
+		streams.push_back(job.f);
+	parse_jobs(jobs);
+	for (auto f : streams)
+		delete f;
+
+	for (int i = 0; i < GetSize(jobs); i++) {
+		auto &fname = fnames[job_files[i]];
+		std::shared_ptr<const LibertyAst> ast(jobs[i].ast);
+		cache.store_disk_cache(fname, sources[job_files[i]], ast.get());
+		cache.parsed_ast(fname, ast);
+		asts[job_files[i]] = ast;
+	}
+
+	for (int i = 0; i < GetSize(fnames); i++)
+		if (!asts[i])
+			log_error("No entries found in liberty file `%s'.\n", fnames[i].c_str());
+	return asts;
+}
+
+void LibertyMergedCells::merge_files(const std::vector<std::string> &fnames)
+{
+	std::vector<std::shared_ptr<const LibertyAst>> file_asts = LibertyParser::parse_files(fnames);
+	for (int i = 0; i < GetSize(fnames); i++) {
+		const LibertyAst *ast = file_asts[i].get();
+		asts.push_back(file_asts[i]);
+		if (ast->id != "library")
+			log_error("Syntax error in liberty file `%s'.\n  Top level entity isn't \"library\".\n", fnames[i].c_str());
+		for (const LibertyAst *cell : ast->children)
+			if (cell->id == "cell" && cell->args.size() == 1)
+				cells.push_back(cell);
+	}
+}
+
+#endif
+
 LibertyAst::~LibertyAst()
 {
 	for (auto child : children)
@@ -663,6 +1203,8 @@ LibertyAst *LibertyParser::parse(bool top_level)
 
 void LibertyParser::error() const
 {
+	if (detached)
+		throw SyntaxError{stringf("Syntax error in liberty file on line %d.\n", line)};
 	log_error("Syntax error in liberty file on line %d.\n", line);
 }
 
@@ -671,6 +1213,8 @@ void LibertyParser::error(const std::string &str) const
 	std::stringstream ss;
 	ss << "Syntax error in liberty file on line " << line << ".\n";
 	ss << "  " << str << "\n";
+	if (detached)
+		throw SyntaxError{ss.str()};
 	log_error("%s", ss.str().c_str());
 }
 
@@ -153,6 +153,19 @@ namespace Yosys
 
 		std::shared_ptr<const LibertyAst> cached_ast(const std::string &fname);
 		void parsed_ast(const std::string &fname, const std::shared_ptr<const LibertyAst> &ast);
+
+		// Directory for binary copies of parsed liberty files that are reused
+		// by later invocations, empty when disabled. Entries are keyed by the
+		// canonical path and checked against the FileStamp of the source file.
+		std::string disk_dir;
+
+		// Loads a liberty file from the disk cache. If `cells' is given, only
+		// the cell groups with these names are materialized and `complete'
+		// is set to false when any were skipped. `source' is set to the stamp
+		// of the file before it is read, to be passed to store_disk_cache()
+		// when the file is parsed instead.
+		std::shared_ptr<const LibertyAst> disk_cached_ast(const std::string &fname, const pool<std::string> *cells, bool &complete, FileStamp &source);
+		void store_disk_cache(const std::string &fname, const FileStamp &source, const LibertyAst *ast);
 		static LibertyAstCache instance;
 	};
 #endif
@@ -178,9 +191,23 @@ namespace Yosys
 		void error() const;
 		void error(const std::string &str) const;
 
+#ifndef FILTERLIB
+		// Parsers on worker threads must not call log_error(), they throw
+		// SyntaxError instead. See parse_files().
+		bool detached = false;
+		struct SyntaxError { std::string message; };
+		struct ParseJob;
+
+		LibertyParser(std::istream &f, bool detached) : f(f), line(1), detached(detached) {}
+		static LibertyAst *parse_detached(std::istream &f);
+		static void parse_jobs(std::vector<ParseJob> &jobs);
+#endif
+
 	public:
 		std::shared_ptr<const LibertyAst> shared_ast;
 		const LibertyAst *ast = nullptr;
+		// set when cell groups were left out, see below
+		bool partial = false;
 
 		LibertyParser(std::istream &f) : f(f), line(1) {
 			shared_ast.reset(parse(true));
@@ -196,17 +223,16 @@ namespace Yosys
 		}
 
 #ifndef FILTERLIB
-		LibertyParser(std::istream &f, const std::string &fname) : f(f), line(1) {
-			shared_ast = LibertyAstCache::instance.cached_ast(fname);
-			if (!shared_ast) {
-				shared_ast.reset(parse(true));
-				LibertyAstCache::instance.parsed_ast(fname, shared_ast);
-			}
-			ast = shared_ast.get();
-			if (!ast) {
-				log_error("No entries found in liberty file `%s'.\n", fname.c_str());
-			}
-		}
+		// When `cells' is given, cell groups with other names may be left
+		// out if the data is loaded from the disk cache.
+		LibertyParser(std::istream &f, const std::string &fname, const pool<std::string> *cells = nullptr);
+
+		// Loads several liberty files through the AST cache and returns the
+		// ASTs in the order of `fnames'. Files that need parsing are parsed
+		// concurrently, and large files are additionally split at the
+		// top-level groups of the library. The result is the same as with
+		// the constructor above, independent of the number of threads.
+		static std::vector<std::shared_ptr<const LibertyAst>> parse_files(const std::vector<std::string> &fnames);
 #endif
 	};
 
@@ -228,6 +254,12 @@ namespace Yosys
 						cells.push_back(cell);
 			}
 		}
+
+#ifndef FILTERLIB
+		// Same as merging a LibertyParser for each file in order, but
+		// parses the files concurrently
+		void merge_files(const std::vector<std::string> &fnames);
+#endif
 	};
 
 }
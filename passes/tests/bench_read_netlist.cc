@@ -0,0 +1,168 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/io.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct BenchReadNetlistPass : public Pass {
+	BenchReadNetlistPass() : Pass("bench_read_netlist", "benchmark the AIGER and BLIF frontends") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    bench_read_netlist [options] filename\n");
+		log("\n");
+		log("Measures how long it takes to read the given AIGER (*.aig, *.aag) or BLIF\n");
+		log("(*.blif) file, once from the memory mapped file (as read_aiger and read_blif do\n");
+		log("for plain files) and once from a generic input stream (as they do for\n");
+		log("compressed files and here-documents), and checks that both create designs\n");
+		log("with the same modules, wires and cells. The current design is not modified.\n");
+		log("\n");
+		log("    -n {integer}\n");
+		log("        number of times each path is run (default = 3).\n");
+		log("\n");
+		log("    -xaiger\n");
+		log("        read the file with 'read_aiger -xaiger'.\n");
+		log("\n");
+	}
+
+	// Names of objects created by the frontends depend on autoidx, so the
+	// designs are compared by their shape instead of a full dump
+	static std::string summary(RTLIL::Design *design, int &num_cells)
+	{
+		std::vector<std::string> lines;
+		num_cells = 0;
+		for (auto module : design->modules()) {
+			int wire_bits = 0;
+			for (auto wire : module->wires())
+				wire_bits += wire->width;
+			dict<IdString, int> cell_types;
+			for (auto cell : module->cells())
+				cell_types[cell->type]++;
+			num_cells += GetSize(module->cells());
+			std::string line = stringf("%s %d %d %d", log_id(module), GetSize(module->wires()), wire_bits, GetSize(module->connections()));
+			cell_types.sort();
+			for (auto &it : cell_types)
+				line += stringf(" %s:%d", log_id(it.first), it.second);
+			lines.push_back(line);
+		}
+		std::sort(lines.begin(), lines.end());
+		std::string result;
+		for (auto &line : lines)
+			result += line + "\n";
+		return result;
+	}
+
+	// Runs the frontend on a fresh design for each iteration and returns the
+	// summary of the last one, the time spent deleting designs isn't counted
+	template<typename F>
+	std::string run(const char *name, int iterations, size_t size, F parse)
+	{
+		int64_t total_ns = 0;
+		std::string result;
+		int num_cells = 0;
+		for (int i = 0; i < iterations; i++) {
+			RTLIL::Design *design = new RTLIL::Design;
+			int64_t begin = PerformanceTimer::query();
+			{
+				LogMakeDebugHdl quiet(true);
+				parse(design);
+			}
+			total_ns += PerformanceTimer::query() - begin;
+			if (i == iterations - 1)
+				result = summary(design, num_cells);
+			delete design;
+		}
+		double seconds = std::max(total_ns / 1e9 / iterations, 1e-9);
+		log("  %-8s %10.3f ms %10.1f MB/s %10.1f k cells/s\n", name, seconds * 1e3, size / 1e6 / seconds, num_cells / 1e3 / seconds);
+		return result;
+	}
+
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		int iterations = 3;
+		bool xaiger = false;
+
+		log_header(design, "Executing BENCH_READ_NETLIST pass.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				iterations = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-xaiger") {
+				xaiger = true;
+				continue;
+			}
+			break;
+		}
+
+		if (argidx >= args.size())
+			log_cmd_error("Missing filename.\n");
+		std::string filename = args[argidx++];
+		if (argidx < args.size())
+			cmd_error(args, argidx, "Extra argument.");
+
+		if (iterations < 1)
+			log_cmd_error("Number of iterations must be positive.\n");
+
+		std::vector<std::string> command;
+		if (filename.size() > 4 && (filename.compare(filename.size()-4, std::string::npos, ".aig") == 0 ||
+				filename.compare(filename.size()-4, std::string::npos, ".aag") == 0)) {
+			command.push_back("aiger");
+			if (xaiger)
+				command.push_back("-xaiger");
+		} else if (filename.size() > 5 && filename.compare(filename.size()-5, std::string::npos, ".blif") == 0) {
+			if (xaiger)
+				log_cmd_error("Option -xaiger can only be used with AIGER files.\n");
+			command.push_back("blif");
+		} else
+			log_cmd_error("Can't guess the format of `%s' from its extension.\n", filename.c_str());
+
+		rewrite_filename(filename);
+		MappedFile mapped;
+		if (!mapped.open(filename))
+			log_cmd_error("Can't open input file `%s' for reading.\n", filename.c_str());
+		size_t size = mapped.size;
+		mapped.close();
+		log("Reading `%s' (%.1f MB) with read_%s, %d iterations:\n", filename.c_str(), size / 1e6, command.front().c_str(), iterations);
+
+		std::string mapped_summary = run("mapped", iterations, size, [&](RTLIL::Design *d) {
+			std::ifstream f(filename, std::ios::binary);
+			Frontend::frontend_call(d, &f, filename, command);
+		});
+		std::string stream_summary = run("stream", iterations, size, [&](RTLIL::Design *d) {
+			std::filebuf buf;
+			buf.open(filename, std::ios::in | std::ios::binary);
+			std::istream f(&buf);
+			Frontend::frontend_call(d, &f, filename, command);
+		});
+
+		if (mapped_summary != stream_summary)
+			log_error("Reading the mapped file and reading the stream created different designs.\n");
+		log("Both paths created identical designs.\n");
+	}
+} BenchReadNetlistPass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,140 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/io.h"
+#include "backends/rtlil/rtlil_backend.h"
+#include "frontends/rtlil/rtlil_frontend.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct BenchRtlilPass : public Pass {
+	BenchRtlilPass() : Pass("bench_rtlil", "benchmark the RTLIL frontend") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    bench_rtlil [options] [filename]\n");
+		log("\n");
+		log("Measures how long it takes to read the given RTLIL file, once with the default\n");
+		log("reader of read_rtlil (parsing the memory mapped file) and once with the legacy\n");
+		log("flex/bison parser (parsing a stream), and checks that both create the same\n");
+		log("design. Without a filename the current design is written to memory in RTLIL\n");
+		log("format and that text is used as input. The current design is not modified.\n");
+		log("\n");
+		log("    -n {integer}\n");
+		log("        number of times each parser is run (default = 3).\n");
+		log("\n");
+	}
+
+	static std::string dump(RTLIL::Design *design)
+	{
+		std::ostringstream buf;
+		RTLIL_BACKEND::dump_design(buf, design, false);
+		return buf.str();
+	}
+
+	// Runs the parser on a fresh design for each iteration and returns the
+	// dump of the last one, the time spent deleting designs isn't counted
+	template<typename F>
+	std::string run(const char *name, int iterations, size_t size, F parse)
+	{
+		int64_t total_ns = 0;
+		std::string result;
+		for (int i = 0; i < iterations; i++) {
+			RTLIL::Design *design = new RTLIL::Design;
+			int64_t begin = PerformanceTimer::query();
+			parse(design);
+			total_ns += PerformanceTimer::query() - begin;
+			if (i == iterations - 1)
+				result = dump(design);
+			delete design;
+		}
+		double seconds = total_ns / 1e9 / iterations;
+		log("  %-8s %10.3f ms %10.1f MB/s\n", name, seconds * 1e3, size / 1e6 / std::max(seconds, 1e-9));
+		return result;
+	}
+
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		int iterations = 3;
+
+		log_header(design, "Executing BENCH_RTLIL pass.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				iterations = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+
+		std::string filename;
+		if (argidx < args.size())
+			filename = args[argidx++];
+		if (argidx < args.size())
+			cmd_error(args, argidx, "Extra argument.");
+
+		if (iterations < 1)
+			log_cmd_error("Number of iterations must be positive.\n");
+
+		RTLIL_FRONTEND::flag_nooverwrite = false;
+		RTLIL_FRONTEND::flag_overwrite = false;
+		RTLIL_FRONTEND::flag_lib = false;
+
+		std::string text, reader_dump, legacy_dump;
+		if (filename.empty()) {
+			text = dump(design);
+			log("Parsing the current design (%.1f MB), %d iterations:\n", text.size() / 1e6, iterations);
+			reader_dump = run("reader", iterations, text.size(), [&](RTLIL::Design *d) {
+				RTLIL_FRONTEND::parse_rtlil(text.data(), text.size(), d);
+			});
+			legacy_dump = run("legacy", iterations, text.size(), [&](RTLIL::Design *d) {
+				std::istringstream f(text);
+				RTLIL_FRONTEND::parse_rtlil_legacy(&f, d);
+			});
+		} else {
+			rewrite_filename(filename);
+			MappedFile mapped;
+			if (!mapped.open(filename))
+				log_cmd_error("Can't open input file `%s' for reading.\n", filename.c_str());
+			size_t size = mapped.size;
+			mapped.close();
+			log("Parsing `%s' (%.1f MB), %d iterations:\n", filename.c_str(), size / 1e6, iterations);
+			reader_dump = run("reader", iterations, size, [&](RTLIL::Design *d) {
+				MappedFile f;
+				f.open(filename);
+				RTLIL_FRONTEND::parse_rtlil(f.data, f.size, d);
+			});
+			legacy_dump = run("legacy", iterations, size, [&](RTLIL::Design *d) {
+				std::ifstream f(filename);
+				RTLIL_FRONTEND::parse_rtlil_legacy(&f, d);
+			});
+		}
+
+		if (reader_dump != legacy_dump)
+			log_error("The reader and the legacy parser created different designs.\n");
+		log("Both parsers created identical designs.\n");
+	}
+} BenchRtlilPass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,179 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct BenchSigspecWorker
+{
+	std::vector<SigSpec> ports;
+	std::vector<const SigMap*> port_sigmaps;
+	std::vector<std::pair<Cell*, IdString>> port_refs;
+	int64_t sink = 0;
+
+	void add_module(Module *module)
+	{
+		const SigMap &sigmap = module->sigmap();
+		for (auto cell : module->selected_cells())
+			for (auto &conn : cell->connections()) {
+				ports.push_back(conn.second);
+				port_sigmaps.push_back(&sigmap);
+				port_refs.emplace_back(cell, conn.first);
+			}
+	}
+
+	// Runs body on a fresh (packed) copy of all ports for each iteration,
+	// only the time spent in body is counted
+	template<typename F>
+	void run(const char *name, int iterations, F body)
+	{
+		int64_t total_ns = 0;
+		for (int i = 0; i < iterations; i++) {
+			std::vector<SigSpec> work = ports;
+			int64_t begin = PerformanceTimer::query();
+			body(work);
+			total_ns += PerformanceTimer::query() - begin;
+		}
+		double per_port = double(total_ns) / iterations / std::max(GetSize(ports), 1);
+		log("  %-10s %10.3f ms %10.1f ns/port\n", name, total_ns / 1e6 / iterations, per_port);
+	}
+
+	void report_shapes()
+	{
+		int64_t bits = 0, chunks = 0, single_bit = 0, single_chunk = 0;
+		for (auto &sig : ports) {
+			bits += GetSize(sig);
+			chunks += GetSize(sig.chunks());
+			single_bit += sig.is_bit();
+			single_chunk += sig.is_chunk();
+		}
+		int num_ports = std::max(GetSize(ports), 1);
+		log("Benchmarking %d cell ports: %.2f bits and %.2f chunks on average,\n", GetSize(ports),
+				double(bits) / num_ports, double(chunks) / num_ports);
+		log("%.1f%% single-bit and %.1f%% single-chunk ports (stored inline), sizeof(SigSpec) = %d.\n",
+				100.0 * single_bit / num_ports, 100.0 * single_chunk / num_ports, int(sizeof(SigSpec)));
+		log("\n");
+	}
+
+	void run_all(int iterations)
+	{
+		run("copy", iterations, [&](std::vector<SigSpec> &work) {
+			std::vector<SigSpec> copy = work;
+			sink += GetSize(copy);
+		});
+		run("getport", iterations, [&](std::vector<SigSpec> &) {
+			for (auto &ref : port_refs)
+				sink += GetSize(ref.first->getPort(ref.second));
+		});
+		run("chunks", iterations, [&](std::vector<SigSpec> &work) {
+			for (auto &sig : work)
+				for (auto &chunk : sig.chunks())
+					sink += chunk.width;
+		});
+		run("bits", iterations, [&](std::vector<SigSpec> &work) {
+			for (auto &sig : work)
+				for (auto bit : sig.bits())
+					sink += bit.wire != nullptr;
+		});
+		run("repack", iterations, [&](std::vector<SigSpec> &work) {
+			for (auto &sig : work) {
+				sig.bits();
+				sink += GetSize(sig.chunks());
+			}
+		});
+		run("sigmap", iterations, [&](std::vector<SigSpec> &work) {
+			for (int i = 0; i < GetSize(work); i++)
+				sink += GetSize((*port_sigmaps[i])(work[i]));
+		});
+		run("hash", iterations, [&](std::vector<SigSpec> &work) {
+			pool<SigSpec> unique;
+			for (auto &sig : work)
+				unique.insert(sig);
+			sink += GetSize(unique);
+		});
+		run("compare", iterations, [&](std::vector<SigSpec> &work) {
+			for (int i = 0; i < GetSize(work); i++)
+				sink += work[i] == ports[i];
+		});
+		run("extract", iterations, [&](std::vector<SigSpec> &work) {
+			for (auto &sig : work)
+				if (!sig.empty())
+					sink += GetSize(sig.extract(0, 1));
+		});
+	}
+};
+
+struct BenchSigspecPass : public Pass {
+	BenchSigspecPass() : Pass("bench_sigspec", "benchmark SigSpec operations on cell ports") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    bench_sigspec [options] [selection]\n");
+		log("\n");
+		log("Microbenchmark for the SigSpec operations that passes typically perform on cell\n");
+		log("ports: copying, port lookup, iterating chunks and bits, converting between the\n");
+		log("two representations, applying a SigMap, hashing, comparing and extracting bits.\n");
+		log("The ports of the selected cells are used as input, so running this on a\n");
+		log("flattened post-techmap netlist gives representative numbers. The design is\n");
+		log("not modified.\n");
+		log("\n");
+		log("    -n {integer}\n");
+		log("        number of times each benchmark is repeated (default = 10).\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		int iterations = 10;
+
+		log_header(design, "Executing BENCH_SIGSPEC pass.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				iterations = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (iterations < 1)
+			log_cmd_error("Number of iterations must be positive.\n");
+
+		BenchSigspecWorker worker;
+		for (auto module : design->selected_modules())
+			worker.add_module(module);
+
+		if (worker.ports.empty()) {
+			log("No cell ports in selection.\n");
+			return;
+		}
+
+		worker.report_shapes();
+		worker.run_all(iterations);
+		log_debug("Checksum: %lld\n", (long long)worker.sink);
+	}
+} BenchSigspecPass;
+
+PRIVATE_NAMESPACE_END
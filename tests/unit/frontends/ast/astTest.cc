@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "frontends/ast/ast.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+using namespace AST;
+
+class FrontendsAstTest : public testing::Test {
+protected:
+	FrontendsAstTest() {
+		yosys_setup();
+	}
+};
+
+TEST_F(FrontendsAstTest, AttributesSorted)
+{
+	AstNode *node = new AstNode(AST_WIRE);
+	std::vector<RTLIL::IdString> names = {ID(keep), ID(init), ID(src), ID(a), ID(z)};
+	for (auto name : names)
+		node->set_attribute(name, AstNode::mkconst_int(1, false));
+	node->attributes[ID(keep)]->integer = 0;
+	EXPECT_EQ(node->attributes.size(), names.size());
+
+	// iterates in the same order as a std::map
+	std::sort(names.begin(), names.end());
+	auto it = node->attributes.begin();
+	for (auto name : names)
+		EXPECT_EQ((it++)->first, name);
+
+	EXPECT_FALSE(node->get_bool_attribute(ID(keep)));
+	EXPECT_TRUE(node->get_bool_attribute(ID(init)));
+	EXPECT_FALSE(node->get_bool_attribute(ID(missing)));
+	EXPECT_EQ(node->attributes.count(ID(missing)), 0u);
+	EXPECT_EQ(node->attributes.find(ID(missing)), node->attributes.end());
+	EXPECT_THROW(node->attributes.at(ID(missing)), std::out_of_range);
+	EXPECT_FALSE(node->attributes.emplace(ID(a), nullptr).second);
+
+	delete node->attributes.at(ID(src));
+	EXPECT_EQ(node->attributes.erase(ID(src)), 1u);
+	EXPECT_EQ(node->attributes.erase(ID(src)), 0u);
+	EXPECT_EQ(node->attributes.count(ID(src)), 0u);
+	EXPECT_EQ(node->attributes.size(), names.size() - 1);
+	delete node;
+}
+
+TEST_F(FrontendsAstTest, CloneAndReuse)
+{
+	AstNode *node = new AstNode(AST_ADD, AstNode::mkconst_int(1, false), AstNode::mkconst_int(2, false));
+	node->set_attribute(ID(keep), AstNode::mkconst_int(1, false));
+
+	AstNode *copy = node->clone();
+	EXPECT_NE(copy->children[0], node->children[0]);
+	EXPECT_NE(copy->attributes.at(ID(keep)), node->attributes.at(ID(keep)));
+	EXPECT_EQ(copy->children[1]->integer, 2u);
+	EXPECT_TRUE(copy->get_bool_attribute(ID(keep)));
+
+	// released nodes are reused by the next allocation
+	unsigned long long count = astnode_count();
+	void *released = copy;
+	delete copy;
+	EXPECT_EQ(astnode_count(), count - 4);
+	AstNode *reused = new AstNode(AST_NONE);
+	EXPECT_EQ((void*)reused, released);
+	delete reused;
+	delete node;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelCellTypesTest : public testing::Test {
+protected:
+	KernelCellTypesTest() {
+		// sets up the ID:: constants used by the built-in table
+		yosys_setup();
+	}
+};
+
+TEST_F(KernelCellTypesTest, BuiltinLookup)
+{
+	CellTypes ct;
+	EXPECT_FALSE(ct.cell_known(ID($add)));
+
+	ct.setup_internals();
+	EXPECT_TRUE(ct.cell_known(ID($add)));
+	EXPECT_TRUE(ct.cell_input(ID($add), ID::A));
+	EXPECT_FALSE(ct.cell_input(ID($add), ID::Y));
+	EXPECT_TRUE(ct.cell_output(ID($add), ID::Y));
+	EXPECT_FALSE(ct.cell_output(ID($add), ID(foo)));
+	EXPECT_TRUE(ct.cell_evaluable(ID($add)));
+	EXPECT_FALSE(ct.cell_known(ID($dff)));
+	EXPECT_FALSE(ct.cell_known(ID($_DFF_P_)));
+
+	ct.setup_stdcells_mem();
+	EXPECT_TRUE(ct.cell_input(ID($_DFFE_PN0P_), ID::E));
+	EXPECT_TRUE(ct.cell_output(ID($_DFFE_PN0P_), ID::Q));
+	EXPECT_FALSE(ct.cell_evaluable(ID($_DFFE_PN0P_)));
+
+	ct.erase(ID($add));
+	EXPECT_FALSE(ct.cell_known(ID($add)));
+	EXPECT_TRUE(ct.cell_known(ID($sub)));
+
+	ct.clear();
+	EXPECT_FALSE(ct.cell_known(ID($sub)));
+	EXPECT_TRUE(ct.all_types().empty());
+}
+
+TEST_F(KernelCellTypesTest, UserTypes)
+{
+	CellTypes ct;
+	ct.setup_type(ID(mycell), {ID::A}, {ID::Y});
+	ct.setup_internals();
+	EXPECT_TRUE(ct.cell_input(ID(mycell), ID::A));
+	EXPECT_TRUE(ct.cell_output(ID(mycell), ID::Y));
+
+	// the last definition of a type wins, as with a single dict
+	ct.setup_type(ID($not), {ID::Y}, {ID::A});
+	EXPECT_TRUE(ct.cell_input(ID($not), ID::Y));
+	EXPECT_FALSE(ct.cell_evaluable(ID($not)));
+	ct.setup_internals_eval();
+	EXPECT_TRUE(ct.cell_input(ID($not), ID::A));
+	EXPECT_TRUE(ct.cell_evaluable(ID($not)));
+
+	auto all = ct.all_types();
+	EXPECT_TRUE(all.count(ID(mycell)));
+	EXPECT_TRUE(all.count(ID($tribuf)));
+	EXPECT_EQ(all.at(ID($not)).outputs, pool<RTLIL::IdString>{ID::Y});
+	const BuiltinCellTypes &builtin = BuiltinCellTypes::get();
+	int num_internals = builtin.group_end[BuiltinCellTypes::INTERNALS_OTHER] - builtin.group_begin[BuiltinCellTypes::INTERNALS_EVAL];
+	EXPECT_EQ(GetSize(all), num_internals + 1);
+}
+
+YOSYS_NAMESPACE_END
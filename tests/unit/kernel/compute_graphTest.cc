@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "kernel/compute_graph.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+typedef ComputeGraph<std::string, int, IdString, std::string> TestGraph;
+
+TEST(KernelComputeGraphTest, AddUnique)
+{
+	TestGraph graph;
+	int a = graph.add_unique("input", 1, std::vector<int>{}).index();
+	int b = graph.add_unique("input", 2, std::vector<int>{}).index();
+	EXPECT_NE(a, b);
+	EXPECT_EQ(graph.add_unique("input", 1, std::vector<int>{}).index(), a);
+
+	int sum = graph.add_unique("add", 0, std::vector<int>{a, b}).index();
+	EXPECT_EQ(graph.add_unique("add", 0, std::vector<int>{a, b}).index(), sum);
+	EXPECT_NE(graph.add_unique("add", 0, std::vector<int>{b, a}).index(), sum);
+	EXPECT_NE(graph.add_unique("sub", 0, std::vector<int>{a, b}).index(), sum);
+
+	// nodes added with add() are never shared
+	EXPECT_NE(graph.add("add", 0, std::vector<int>{a, b}).index(), sum);
+	EXPECT_EQ(graph.size(), 6);
+
+	EXPECT_EQ(graph[sum].function(), "add");
+	EXPECT_EQ(graph[sum].size(), 2);
+	EXPECT_EQ(graph[sum].arg(1).index(), b);
+}
+
+TEST(KernelComputeGraphTest, MergeDuplicates)
+{
+	TestGraph graph;
+	int a = graph.add("input", 0).index();
+	int a2 = graph.add("input", 0).index();
+	int x = graph.add("not", 0, std::vector<int>{a}).index();
+	int x2 = graph.add("not", 0, std::vector<int>{a2}).index();
+	int y = graph.add("and", 0, std::vector<int>{x, x2}).index();
+	graph[x2].sparse_attr() = ID(x2);
+	graph[y].assign_key("y");
+	graph[x2].assign_key("x2");
+
+	int merged = 0;
+	graph.merge_duplicates([&](TestGraph::Ref kept, TestGraph::Ref removed) {
+		EXPECT_LT(kept.index(), removed.index());
+		merged++;
+	});
+
+	EXPECT_EQ(merged, 2);
+	EXPECT_EQ(graph.size(), 3);
+	auto and_node = graph("y");
+	EXPECT_EQ(and_node.function(), "and");
+	EXPECT_EQ(and_node.arg(0).index(), and_node.arg(1).index());
+	EXPECT_EQ(graph("x2").index(), and_node.arg(0).index());
+	EXPECT_FALSE(graph("x2").has_sparse_attr());
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "kernel/drivertools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelDrivertoolsTest : public testing::Test {
+protected:
+	RTLIL::Design design;
+	RTLIL::Module *module;
+	RTLIL::Wire *a, *b, *c, *y;
+
+	KernelDrivertoolsTest() {
+		yosys_setup();
+		module = design.addModule(ID(top));
+		a = module->addWire(ID(a), 4);
+		a->port_input = true;
+		b = module->addWire(ID(b), 4);
+		c = module->addWire(ID(c), 4);
+		y = module->addWire(ID(y), 4);
+		y->port_output = true;
+		module->fixup_ports();
+	}
+
+	// dm must give the same result as a map built from scratch
+	void expect_fresh(DriverMap &dm) {
+		DriverMap fresh(&design);
+		fresh.add(module);
+		for (auto wire : module->wires()) {
+			DriveSpec spec = DriveChunkWire(wire, 0, wire->width);
+			EXPECT_EQ(dm(spec), fresh(spec));
+		}
+	}
+};
+
+TEST_F(KernelDrivertoolsTest, InterleavedAddQuery)
+{
+	DriverMap dm(&design);
+	dm.add(module);
+	DriveSpec undriven = dm(DriveSpec(DriveChunkWire(b, 0, 4)));
+	for (auto const &chunk : undriven.chunks())
+		EXPECT_TRUE(chunk.is_none());
+
+	// queries cache the orientation of undirected connections, which new
+	// connections can change
+	module->connect(b, a);
+	dm.add(b, a);
+	expect_fresh(dm);
+
+	module->connect(c, b);
+	dm.add(c, b);
+	expect_fresh(dm);
+
+	module->connect(y, c);
+	dm.add(y, c);
+	expect_fresh(dm);
+}
+
+TEST_F(KernelDrivertoolsTest, BatchedQuery)
+{
+	module->connect(b, a);
+	module->connect(c, b);
+	module->connect(y, c);
+	DriverMap dm(&design);
+	dm.add(module);
+
+	std::vector<DriveSpec> specs;
+	for (auto wire : module->wires())
+		specs.push_back(DriveChunkWire(wire, 0, wire->width));
+	specs.push_back(DriveChunkWire(c, 1, 2));
+
+	std::vector<DriveSpec> drivers = dm(specs);
+	ASSERT_EQ(GetSize(drivers), GetSize(specs));
+	for (int i = 0; i < GetSize(specs); i++)
+		EXPECT_EQ(drivers[i], dm(specs[i]));
+	EXPECT_EQ(drivers.back(), DriveSpec(DriveChunkWire(a, 1, 2)));
+}
+
+YOSYS_NAMESPACE_END
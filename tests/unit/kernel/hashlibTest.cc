@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "kernel/yosys_common.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelHashlibTest, DictSmallAndLarge)
+{
+	// crosses hashtable_small_size in both directions
+	dict<int, int> d;
+	for (int i = 0; i < 20; i++) {
+		d[i] = i * i;
+		for (int j = 0; j <= i; j++)
+			EXPECT_EQ(d.at(j), j * j);
+		EXPECT_EQ(d.count(i + 1), 0);
+	}
+	for (int i = 0; i < 20; i += 2)
+		EXPECT_EQ(d.erase(i), 1);
+	EXPECT_EQ(d.erase(0), 0);
+
+	dict<int, int> copy = d;
+	EXPECT_EQ(copy, d);
+	for (int i = 1; i < 16; i += 2)
+		copy.erase(i);
+	EXPECT_EQ(GetSize(copy), 2);
+	dict<int, int> small = copy;
+	EXPECT_EQ(small.at(17), 17 * 17);
+	EXPECT_EQ(small.at(19), 19 * 19);
+	EXPECT_EQ(small.count(15), 0);
+}
+
+TEST(KernelHashlibTest, DictIterationOrder)
+{
+	// iteration order is the same with and without hashtable: the last
+	// entry moves into the slot of an erased one
+	for (int size = 2; size <= 8; size++) {
+		dict<std::string, int> d;
+		for (int i = 0; i < size; i++)
+			d[stringf("k%d", i)] = i;
+		d.erase("k0");
+		std::vector<int> order, expected;
+		for (auto &it : d)
+			order.push_back(it.second);
+		for (int i = size - 2; i > 0; i--)
+			expected.push_back(i);
+		expected.push_back(size - 1);
+		EXPECT_EQ(order, expected);
+	}
+}
+
+YOSYS_NAMESPACE_END
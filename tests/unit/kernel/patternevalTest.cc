@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "kernel/patterneval.h"
+#include "kernel/consteval.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelPatternEvalTest : public testing::Test {
+protected:
+	RTLIL::Design design;
+	RTLIL::Module *module;
+	CellTypes ct;
+
+	KernelPatternEvalTest() {
+		yosys_setup();
+		module = design.addModule(ID(top));
+		ct.setup_internals();
+		ct.setup_stdcells();
+	}
+
+	// compares all patterns against ConstEval on the current module
+	void check(const std::vector<RTLIL::Wire*> &inputs, RTLIL::Wire *output) {
+		SigMap sigmap(module);
+		PatternEval sim(module, sigmap, ct, 2);
+		sim.randomize();
+		ConstEval ce(module);
+		for (int p = 0; p < sim.num_patterns(); p++) {
+			int w = p / 64, b = p % 64;
+			ce.clear();
+			for (auto wire : inputs) {
+				RTLIL::Const value(RTLIL::State::S0, wire->width);
+				for (int i = 0; i < wire->width; i++) {
+					ASSERT_TRUE((sim.defined(SigBit(wire, i))[w] >> b) & 1);
+					value.bits()[i] = (sim.value(SigBit(wire, i))[w] >> b) & 1 ? RTLIL::State::S1 : RTLIL::State::S0;
+				}
+				ce.set(wire, value);
+			}
+			RTLIL::SigSpec expected = output;
+			ASSERT_TRUE(ce.eval(expected));
+			for (int i = 0; i < output->width; i++) {
+				ASSERT_TRUE((sim.defined(SigBit(output, i))[w] >> b) & 1);
+				EXPECT_EQ((sim.value(SigBit(output, i))[w] >> b) & 1, expected[i] == RTLIL::State::S1)
+						<< "pattern " << p << " bit " << i;
+			}
+		}
+	}
+};
+
+TEST_F(KernelPatternEvalTest, WordLevelCells)
+{
+	std::vector<RTLIL::IdString> types = {
+		ID($not), ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($sub), ID($neg),
+		ID($eq), ID($ne), ID($lt), ID($le), ID($gt), ID($ge),
+		ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
+		ID($logic_not), ID($logic_and), ID($logic_or), ID($mux)
+	};
+	int counter = 0;
+	for (auto type : types)
+	for (int variant = 0; variant < 4; variant++)
+	{
+		for (auto cell : module->cells().to_vector())
+			module->remove(cell);
+		for (auto wire : module->wires().to_vector())
+			module->remove(pool<RTLIL::Wire*>{wire});
+
+		bool is_signed = variant & 1;
+		int width_a = 1 + (counter * 7) % 9, width_b = 1 + (counter * 5) % 9, width_y = 1 + (counter * 3) % 11;
+		counter++;
+		if (type == ID($mux))
+			width_a = width_b = width_y;
+
+		RTLIL::Wire *a = module->addWire(ID(a), width_a);
+		RTLIL::Wire *b = module->addWire(ID(b), width_b);
+		RTLIL::Wire *s = module->addWire(ID(s));
+		RTLIL::Wire *y = module->addWire(ID(y), width_y);
+		RTLIL::Cell *cell = module->addCell(ID(cell), type);
+		cell->setPort(ID::A, a);
+		cell->setPort(ID::Y, y);
+		if (type == ID($mux)) {
+			cell->setPort(ID::B, b);
+			cell->setPort(ID::S, s);
+			cell->setParam(ID::WIDTH, width_y);
+		} else {
+			cell->setParam(ID::A_SIGNED, is_signed);
+			cell->setParam(ID::A_WIDTH, width_a);
+			cell->setParam(ID::Y_WIDTH, width_y);
+			if (ct.cell_input(type, ID::B)) {
+				cell->setPort(ID::B, b);
+				cell->setParam(ID::B_SIGNED, is_signed);
+				cell->setParam(ID::B_WIDTH, width_b);
+			}
+		}
+		cell->check();
+		SCOPED_TRACE(type.str() + (is_signed ? " signed" : " unsigned"));
+		check({a, b, s}, y);
+	}
+}
+
+TEST_F(KernelPatternEvalTest, GateChain)
+{
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *y = module->addWire(ID(y), 4);
+	RTLIL::SigBit x = module->AndGate(NEW_ID, SigBit(a, 0), SigBit(a, 1));
+	x = module->Aoi3Gate(NEW_ID, x, SigBit(a, 2), SigBit(a, 3));
+	RTLIL::SigBit m = module->MuxGate(NEW_ID, SigBit(a, 0), x, SigBit(a, 1));
+	module->addXorGate(NEW_ID, m, SigBit(a, 3), SigBit(y, 0));
+	module->addOai4Gate(NEW_ID, SigBit(a, 0), SigBit(a, 1), m, x, SigBit(y, 1));
+	module->addNotGate(NEW_ID, SigBit(y, 0), SigBit(y, 2));
+	module->connect(SigBit(y, 3), RTLIL::State::S1);
+	check({a}, y);
+}
+
+TEST_F(KernelPatternEvalTest, UndefAndFlipFlops)
+{
+	RTLIL::Wire *a = module->addWire(ID(a));
+	RTLIL::Wire *q = module->addWire(ID(q));
+	RTLIL::Wire *y = module->addWire(ID(y));
+	RTLIL::Wire *z = module->addWire(ID(z));
+	RTLIL::Wire *loop = module->addWire(ID(loop));
+	module->addNotGate(NEW_ID, a, y);
+	module->addXorGate(NEW_ID, SigBit(q), RTLIL::State::Sx, z);
+	module->addNotGate(NEW_ID, loop, loop);
+
+	CellTypes ff_ct = ct;
+	ff_ct.setup_stdcells_mem();
+	RTLIL::Wire *d = module->addWire(ID(d));
+	module->addDffGate(NEW_ID, RTLIL::State::S0, d, q);
+	module->addNotGate(NEW_ID, q, d);
+
+	SigMap sigmap(module);
+	PatternEval sim(module, sigmap, ff_ct, 1);
+	sim.randomize();
+	EXPECT_EQ(sim.defined(z)[0], 0u);
+	EXPECT_EQ(sim.defined(loop)[0], 0u);
+	EXPECT_EQ(sim.value(y)[0], ~sim.value(a)[0]);
+	EXPECT_EQ(sim.differ(y, a, 0), ~PatternEval::word_t(0));
+
+	PatternEval::word_t q0 = sim.value(q)[0];
+	sim.step();
+	EXPECT_EQ(sim.defined(q)[0], ~PatternEval::word_t(0));
+	EXPECT_EQ(sim.value(q)[0], ~q0);
+}
+
+YOSYS_NAMESPACE_END
@@ -90,6 +90,90 @@ namespace RTLIL {
 
 	}
 
+	TEST_F(KernelRtlilTest, SigSpecChunkStorage)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		Wire *a = mod->addWire(ID(a), 4);
+		Wire *b = mod->addWire(ID(b), 4);
+
+		SigSpec sig(a);
+		EXPECT_TRUE(sig.chunks().is_inline());
+		EXPECT_EQ(GetSize(sig.chunks()), 1);
+		EXPECT_TRUE(sig.is_wire());
+
+		sig.append(b);
+		EXPECT_FALSE(sig.chunks().is_inline());
+		EXPECT_EQ(GetSize(sig.chunks()), 2);
+
+		// a round trip through the unpacked form gives the same chunks
+		SigSpec copy = sig;
+		copy.bits();
+		EXPECT_EQ(copy.chunks(), sig.chunks());
+
+		SigSpec bit = SigSpec(b).extract(2, 1);
+		bit.bits();
+		EXPECT_TRUE(bit.chunks().is_inline());
+		EXPECT_EQ(bit.as_bit(), SigBit(b, 2));
+
+		std::vector<SigChunk> chunks = sig.chunks();
+		EXPECT_EQ(SigSpec(chunks), sig);
+	}
+
+	TEST_F(KernelRtlilTest, SigSpecCachedHash)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		Wire *a = mod->addWire(ID(a), 4);
+		Wire *b = mod->addWire(ID(b), 4);
+		auto hash = [](const SigSpec &sig) { return sig.hash_into(Hasher()).yield(); };
+
+		SigSpec sig(a);
+		Hasher::hash_t h = hash(sig);
+		// const accesses in either form don't change the hash
+		EXPECT_EQ(sig[1], SigBit(a, 1));
+		EXPECT_EQ(hash(sig), h);
+		EXPECT_EQ(hash(SigSpec(a)), h);
+
+		// every kind of modification must invalidate it
+		sig[1] = SigBit(b, 1);
+		EXPECT_EQ(hash(sig), hash(SigSpec({SigSpec(a, 2, 2), SigSpec(b, 1), SigSpec(a, 0)})));
+		sig.append(State::S1);
+		EXPECT_EQ(hash(sig), hash(SigSpec({State::S1, SigSpec(a, 2, 2), SigSpec(b, 1), SigSpec(a, 0)})));
+		sig.remove_const();
+		sig.replace(SigSpec(b, 1), SigSpec(a, 1));
+		EXPECT_EQ(hash(sig), h);
+		sig.reverse();
+		EXPECT_NE(hash(sig), h);
+		sig.remove(0, 2);
+		EXPECT_EQ(hash(sig), hash(SigSpec({SigSpec(a, 0), SigSpec(a, 1)})));
+	}
+
+	TEST_F(KernelRtlilTest, ModuleObjectSlab)
+	{
+		std::unique_ptr<Module> mod = std::make_unique<Module>();
+		Cell *a = mod->addCell(ID(a), ID($_NOT_));
+		mod->addCell(ID(b), ID($_NOT_));
+		uintptr_t a_addr = reinterpret_cast<uintptr_t>(a);
+		size_t bytes = mod->object_bytes();
+		EXPECT_GT(bytes, 0u);
+
+		// the memory of a removed cell is reused for the next one
+		mod->remove(a);
+		Cell *c = mod->addCell(ID(c), ID($_AND_));
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(c), a_addr);
+		EXPECT_EQ(mod->object_bytes(), bytes);
+
+		for (int i = 0; i < 1000; i++)
+			mod->addWire(stringf("\\w%d", i), i % 7 + 1);
+		pool<Wire*> to_remove;
+		for (auto wire : mod->wires())
+			if (wire->width == 3)
+				to_remove.insert(wire);
+		mod->remove(to_remove);
+		for (auto wire : mod->wires())
+			EXPECT_NE(wire->width, 3);
+		EXPECT_EQ(GetSize(mod->wires()), 1000 - GetSize(to_remove));
+	}
+
 	class WireRtlVsHdlIndexConversionTest :
 		public KernelRtlilTest,
 		public testing::WithParamInterface<std::tuple<bool, int, int>>
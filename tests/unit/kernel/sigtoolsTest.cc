@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelSigtoolsTest : public testing::Test {
+protected:
+	RTLIL::Design design;
+	RTLIL::Module *module;
+	RTLIL::Wire *a, *b, *c;
+
+	KernelSigtoolsTest() {
+		if (log_files.empty()) log_files.emplace_back(stdout);
+		// registers the commands for Pass::call()
+		yosys_setup();
+		module = design.addModule(ID(top));
+		a = module->addWire(ID(a), 4);
+		b = module->addWire(ID(b), 4);
+		c = module->addWire(ID(c), 4);
+	}
+
+	// the borrowed SigMap must give the same result as a fresh one
+	void expect_fresh(const SigMap &borrowed) {
+		SigMap fresh(module);
+		for (auto wire : module->wires())
+			for (auto bit : SigSpec(wire))
+				EXPECT_EQ(borrowed(bit), fresh(bit));
+	}
+};
+
+TEST_F(KernelSigtoolsTest, ModuleSigmapConnect)
+{
+	const SigMap &sigmap = module->sigmap();
+	EXPECT_NE(sigmap(a), sigmap(b));
+
+	module->connect(a, b);
+	EXPECT_EQ(sigmap(a), sigmap(b));
+	expect_fresh(sigmap);
+
+	module->connect(SigSpec(c).extract(0, 2), Const(1, 2));
+	EXPECT_TRUE(sigmap(SigSpec(c).extract(0, 2)).is_fully_const());
+	expect_fresh(module->sigmap());
+}
+
+TEST_F(KernelSigtoolsTest, ModuleSigmapInvalidate)
+{
+	module->connect(a, b);
+	module->connect(b, c);
+	EXPECT_EQ(module->sigmap()(a), module->sigmap()(c));
+
+	module->new_connections({RTLIL::SigSig(a, b)});
+	EXPECT_NE(module->sigmap()(a), module->sigmap()(c));
+	expect_fresh(module->sigmap());
+
+	module->rename(b, ID(b_renamed));
+	expect_fresh(module->sigmap());
+
+	module->remove(pool<RTLIL::Wire*>{c});
+	expect_fresh(module->sigmap());
+
+	module->connections_.clear();
+	module->invalidate_sigmap();
+	EXPECT_NE(module->sigmap()(a), module->sigmap()(b));
+}
+
+
+TEST_F(KernelSigtoolsTest, ModuleSigmapCommandBoundary)
+{
+	module->connect(a, b);
+	expect_fresh(module->sigmap());
+
+	// a pass that forgets to call invalidate_sigmap() only affects the
+	// rest of the same command
+	module->connections_.clear();
+	Pass::call(&design, "select -clear");
+	expect_fresh(module->sigmap());
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "kernel/topo_scc.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// mostly acyclic random graph with a few back edges, so that all of the
+// trimming phases and the cyclic core are exercised
+static void random_graph(std::vector<IntGraph> &graphs, int num_nodes, int num_edges, int num_back_edges, uint32_t seed)
+{
+	auto rng = [&]() {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	};
+	// edges point from higher to lower nodes, except for the back edges
+	for (auto &graph : graphs)
+		graph.add_edge(num_nodes - 1, 0);
+	for (int i = 0; i < num_edges + num_back_edges; i++) {
+		int a = rng() % num_nodes, b = rng() % num_nodes;
+		if ((a > b) != (i < num_edges))
+			std::swap(a, b);
+		if (a == b)
+			continue;
+		for (auto &graph : graphs)
+			graph.add_edge(a, b);
+	}
+}
+
+TEST(KernelTopoSccTest, LevelizedMatchesTarjan)
+{
+	for (uint32_t seed = 1; seed <= 20; seed++)
+	for (int min_wave_size : {1, 4096})
+	{
+		std::vector<IntGraph> graphs(2);
+		int num_nodes = 2000;
+		random_graph(graphs, num_nodes, 4000, seed % 5, seed * 7919);
+
+		std::vector<int> tarjan_comp(num_nodes, -1);
+		int num_tarjan_comps = 0;
+		TopoSortedSccs tarjan(graphs[0], [&](int *begin, int *end) {
+			for (int *i = begin; i != end; ++i)
+				tarjan_comp[*i] = num_tarjan_comps;
+			num_tarjan_comps++;
+		});
+		tarjan.process_all();
+
+		LevelizedSccs<IntGraph> levelized(graphs[1], 4, min_wave_size);
+		ASSERT_EQ(levelized.num_components(), num_tarjan_comps);
+		ASSERT_EQ(GetSize(levelized.nodes), num_nodes);
+
+		std::vector<int> level(num_nodes, -1), comp(num_nodes, -1);
+		for (int l = 0; l < levelized.num_levels(); l++)
+			for (int c = levelized.level_begin[l]; c < levelized.level_begin[l + 1]; c++)
+				for (int j = levelized.component_begin[c]; j < levelized.component_begin[c + 1]; j++) {
+					int node = levelized.nodes[j];
+					EXPECT_EQ(level[node], -1);
+					level[node] = l;
+					comp[node] = c;
+					// the same partition into components as Tarjan
+					EXPECT_EQ(tarjan_comp[node], tarjan_comp[levelized.nodes[levelized.component_begin[c]]]);
+				}
+
+		// successors outside the component are on lower levels
+		for (int node = 0; node < num_nodes; node++)
+			for (auto succ = graphs[1].enumerate_successors(node); !succ.finished();) {
+				int s = succ.next();
+				if (comp[s] != comp[node]) {
+					EXPECT_LT(level[s], level[node]);
+				}
+			}
+	}
+}
+
+TEST(KernelTopoSccTest, LevelizedDeterministic)
+{
+	std::vector<IntGraph> graphs(2);
+	random_graph(graphs, 5000, 12000, 3, 42);
+	LevelizedSccs<IntGraph> serial(graphs[0], 1);
+	LevelizedSccs<IntGraph> parallel(graphs[1], 4, 1);
+	EXPECT_EQ(serial.nodes, parallel.nodes);
+	EXPECT_EQ(serial.component_begin, parallel.component_begin);
+	EXPECT_EQ(serial.level_begin, parallel.level_begin);
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,66 @@
+module child #(
+	parameter W = 1
+) (
+	output wire [31:0] out
+);
+	// depends on a parameter, so must not be shared between derived modules
+	function automatic integer add_w;
+		input integer x;
+		add_w = x + W;
+	endfunction
+
+	localparam A = add_w(1);
+	assign out = A;
+endmodule
+
+module shadow #(
+	parameter Q = 0
+) (
+	output wire [31:0] out
+);
+	localparam P = 3;
+	// P refers to g.P here, which differs between derived modules even
+	// though the module level P doesn't
+	if (1) begin : g
+		localparam P = Q;
+		function automatic integer add_p;
+			input integer x;
+			add_p = x + P;
+		endfunction
+		localparam A = add_p(1);
+		assign out = A;
+	end
+endmodule
+
+module top;
+	function automatic integer fib;
+		input integer n;
+		if (n < 2)
+			fib = n;
+		else
+			fib = fib(n - 1) + fib(n - 2);
+	endfunction
+
+	localparam F = fib(24);
+	always @* assert(F == 46368);
+
+	genvar i;
+	generate
+		for (i = 0; i < 16; i = i + 1) begin : gen
+			localparam G = fib(i) + fib(5);
+			always @* assert(G == fib(i) + 5);
+		end
+	endgenerate
+
+	wire [31:0] out3, out5;
+	child #(.W(3)) c3 (.out(out3));
+	child #(.W(5)) c5 (.out(out5));
+	always @* assert(out3 == 4);
+	always @* assert(out5 == 6);
+
+	wire [31:0] out_s1, out_s2;
+	shadow #(.Q(1)) s1 (.out(out_s1));
+	shadow #(.Q(2)) s2 (.out(out_s2));
+	always @* assert(out_s1 == 2);
+	always @* assert(out_s2 == 3);
+endmodule